@@ -0,0 +1,109 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the persistent cache of compiled scripts.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CG_CODECACHE_H_
+#define INCLUDE_QORE_CG_CODECACHE_H_
+
+#include <cstdint>
+#include <string>
+#include "qore/core/Env.h"
+
+namespace qore {
+namespace cg {
+
+/**
+ * \brief Persistent cache of executables compiled ahead of time, keyed by the contents of their sources.
+ *
+ * The key of a script is a hash of the main source file, the version of the compiler and the options that affect
+ * the generated code. Each entry consists of the executable named by the key and a manifest (`<key>.deps`) with
+ * the hashes of all source files the executable was compiled from, including those included by `%include`. A
+ * lookup succeeds only if none of these files have changed.
+ *
+ * The size of the directory is bounded: when an entry is stored, the least recently used entries are removed until
+ * the total size fits. Using an entry updates the modification time of its manifest. Entries are moved into the
+ * directory with a rename, so concurrent compilations of the same script are harmless.
+ */
+class CodeCache {
+
+public:
+    /**
+     * \brief Constructor.
+     * \param directory the directory with the entries, created if it does not exist
+     * \param maxSize the maximum total size of the entries in bytes
+     */
+    CodeCache(std::string directory, std::uint64_t maxSize);
+
+    /**
+     * \brief Computes the key of a script.
+     * \param fileName the name of the main source file
+     * \param options a description of the options that affect the generated code
+     * \return the key or an empty string if the file cannot be read
+     */
+    std::string getKey(const std::string &fileName, const std::string &options) const;
+
+    /**
+     * \brief Finds an up-to-date executable.
+     * \param key the key of the script
+     * \return the name of the executable or an empty string if there is none or if a source has changed
+     */
+    std::string lookup(const std::string &key);
+
+    /**
+     * \brief Returns a new unique name in the cache directory for building an executable before it is stored.
+     * \param key the key of the script
+     * \return the name of the file or an empty string if it cannot be created
+     */
+    std::string createTempFile(const std::string &key) const;
+
+    /**
+     * \brief Stores an executable.
+     * \param key the key of the script
+     * \param executable the name of the executable, usually created by createTempFile(), moved into the cache
+     * \param env the environment the executable has been compiled from, provides the names of the source files
+     * \return the name of the executable in the cache or an empty string in case of failure
+     */
+    std::string store(const std::string &key, const std::string &executable, Env &env);
+
+private:
+    std::string getPath(const std::string &key) const {
+        return directory + "/" + key;
+    }
+
+    void evict(const std::string &keep);
+
+private:
+    std::string directory;
+    std::uint64_t maxSize;
+};
+
+} // namespace cg
+} // namespace qore
+
+#endif // INCLUDE_QORE_CG_CODECACHE_H_
@@ -35,10 +35,21 @@
 #include <string>
 #include <vector>
 #include "qore/core/Env.h"
+#include "qore/core/Function.h"
+#include "qore/cg/Optimization.h"
 
 namespace qore {
 namespace cg {
 
+/**
+ * \brief The format of the files produced by the ahead-of-time compilation.
+ */
+enum class OutputFormat {
+    IR,         //!< Textual LLVM IR.
+    Bitcode,    //!< LLVM bitcode.
+    Object,     //!< Native object file for the host.
+};
+
 /**
  * \brief LLVM IR code generator.
  */
@@ -48,8 +59,42 @@ public:
     /**
      * \brief Generates LLVM IR code.
      * \param env the runtime environment
+     * \param level the optimization level
+     * \return the time spent in the phases of the compilation
+     */
+    static CompileTimes process(Env &env, OptLevel level = OptLevel::O2);
+
+    /**
+     * \brief Compiles all functions of an environment ahead of time.
+     *
+     * Besides `qstart`, the output defines `qmain` with the signature `qvalue (const qvalue *args)` which calls
+     * `entry`. Object files are generated for the host by an LLVM target machine. With more than one thread, the
+     * functions are compiled and optimized in parallel partitions which are linked before emission. With debug
+     * information, the output carries DWARF line tables mapping the code back to the Qore sources.
+     * \param env the environment to compile
+     * \param entry the function called by `qmain`, usually the one returned by the analyzer
+     * \param path the name of the output file
+     * \param format the format of the output
+     * \param level the optimization level
+     * \param threads the number of threads generating and optimizing code
+     * \param debugInfo true to generate debug information
+     * \param times receives the time spent in the phases of the compilation
+     * \param error receives the description of the problem in case of failure
+     * \return true on success
+     */
+    static bool emit(Env &env, const Function &entry, const std::string &path, OutputFormat format, OptLevel level,
+            unsigned threads, bool debugInfo, CompileTimes &times, std::string &error);
+
+    /**
+     * \brief Links an object file produced by \ref emit() with the static runtime into an executable.
+     *
+     * The executable creates an environment, runs `qstart` and then `qmain`.
+     * \param object the name of the object file
+     * \param output the name of the executable
+     * \param error receives the description of the problem in case of failure
+     * \return true on success
      */
-    static void process(Env &env);
+    static bool link(const std::string &object, const std::string &output, std::string &error);
 };
 
 } // namespace cg
@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the in-process execution of compiled programs.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CG_JIT_H_
+#define INCLUDE_QORE_CG_JIT_H_
+
+#include <memory>
+#include "qore/core/Env.h"
+#include "qore/core/Function.h"
+#include "qore/cg/Optimization.h"
+
+namespace qore {
+namespace cg {
+
+/**
+ * \brief Compiles an analyzed environment to native code and executes it in the running process.
+ *
+ * All functions of the environment are compiled into one module which is optimized at the requested level and
+ * emitted by MCJIT. Its `qstart` function runs right after compilation and creates the namespaces, global variables
+ * and string literals in the runtime environment (see getRuntimeEnv()), which is separate from the analyzed one.
+ *
+ * With more than one thread, the functions are compiled and optimized in parallel partitions which are linked
+ * together before emission, calls across partitions are not inlined.
+ *
+ * With debug information enabled, the code carries DWARF line tables which MCJIT registers with debuggers, and
+ * the addresses and names of the generated functions are appended to `/tmp/perf-<pid>.map` so that `perf` can
+ * attribute samples to them.
+ *
+ * If the JIT has not been enabled at build time (`QORE_ENABLE_JIT`), compile() always fails.
+ */
+class Jit {
+
+public:
+    /**
+     * \brief The entry point of the native code of a function.
+     *
+     * Receives the values of the arguments and returns the return value (null for functions returning nothing).
+     */
+    using NativeCode = qvalue (*)(const qvalue *args);
+
+public:
+    /**
+     * \brief Constructor.
+     * \param level the optimization level
+     * \param threads the number of threads generating and optimizing code
+     * \param debugInfo true to generate debug information and announce the code to profilers
+     */
+    explicit Jit(OptLevel level = OptLevel::O2, unsigned threads = 1, bool debugInfo = false);
+
+    /**
+     * \brief Destructor, releases the native code and the runtime environment.
+     */
+    ~Jit();
+
+    /**
+     * \brief Compiles all functions of an environment and runs `qstart`.
+     *
+     * Must be called at most once.
+     * \param env the analyzed environment
+     * \return false if the environment cannot be compiled
+     */
+    bool compile(Env &env);
+
+    /**
+     * \brief Returns the native code of a function of the compiled environment.
+     * \param f the function
+     * \return the entry point of the native code or `nullptr` if `f` has not been compiled
+     */
+    NativeCode getNativeCode(const Function &f) const;
+
+    /**
+     * \brief Returns the time spent in the phases of compile().
+     * \return the compilation times
+     */
+    const CompileTimes &getCompileTimes() const;
+
+    /**
+     * \brief Returns the runtime environment populated by `qstart`.
+     * \return the runtime environment or `nullptr` if no environment has been compiled
+     */
+    Env *getRuntimeEnv();
+
+private:
+    Jit(const Jit &) = delete;
+    Jit(Jit &&) = delete;
+    Jit &operator=(const Jit &) = delete;
+    Jit &operator=(Jit &&) = delete;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace cg
+} // namespace qore
+
+#endif // INCLUDE_QORE_CG_JIT_H_
@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the optimization levels of the code generator.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CG_OPTIMIZATION_H_
+#define INCLUDE_QORE_CG_OPTIMIZATION_H_
+
+#include <chrono>
+
+namespace qore {
+namespace cg {
+
+/**
+ * \brief Optimization level of the LLVM pass pipeline run over the generated modules.
+ */
+enum class OptLevel {
+    O0,     //!< No optimizations.
+    O1,     //!< Promotion of locals to registers, simplifications and always-inline functions only.
+    O2,     //!< The standard pipeline including inlining, GVN and loop optimizations.
+    O3,     //!< Like O2 with more aggressive inlining and argument promotion.
+};
+
+/**
+ * \brief The time spent in the individual phases of a compilation.
+ */
+struct CompileTimes {
+    std::chrono::microseconds generation{0};        //!< Building the LLVM IR from the code of the functions.
+    std::chrono::microseconds optimization{0};      //!< Running the pass pipeline.
+    std::chrono::microseconds emission{0};          //!< Emitting machine code (JIT) or the output file.
+
+    /**
+     * \brief Adds the times of another compilation.
+     * \param other the times to add
+     * \return this
+     */
+    CompileTimes &operator+=(const CompileTimes &other) {
+        generation += other.generation;
+        optimization += other.optimization;
+        emission += other.emission;
+        return *this;
+    }
+};
+
+} // namespace cg
+} // namespace qore
+
+#endif // INCLUDE_QORE_CG_OPTIMIZATION_H_
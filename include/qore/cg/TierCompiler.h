@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the compiler of hot functions for tiered execution.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CG_TIERCOMPILER_H_
+#define INCLUDE_QORE_CG_TIERCOMPILER_H_
+
+#include <functional>
+#include <memory>
+#include "qore/core/Function.h"
+#include "qore/cg/Optimization.h"
+
+namespace qore {
+namespace cg {
+
+/**
+ * \brief Compiles individual functions to native code at runtime.
+ *
+ * Each function is compiled by \ref FunctionCompiler into its own module which is optimized and added to a shared
+ * MCJIT execution engine. String constants and global variables are referenced by the addresses of the existing
+ * runtime objects. Recursive calls are direct, calls of other functions go through a trampoline so that the callee is
+ * executed by whichever tier currently owns it.
+ *
+ * If the JIT has not been enabled at build time (`QORE_ENABLE_JIT`), compile() always returns `nullptr`.
+ */
+class TierCompiler {
+
+public:
+    /**
+     * \brief The entry point of the native code of a function.
+     *
+     * Receives the values of the arguments and returns the return value (null for functions returning nothing).
+     */
+    using NativeCode = qvalue (*)(const qvalue *args);
+
+    /**
+     * \brief Calls a function from native code.
+     *
+     * Receives the target of the called function as returned by the \ref Linker, the values of the arguments and
+     * their number.
+     */
+    using Trampoline = qvalue (*)(const void *target, const qvalue *args, Size argCount);
+
+    /**
+     * \brief Returns the target passed to the trampoline for calls of a function.
+     */
+    using Linker = std::function<const void *(const Function &)>;
+
+public:
+    /**
+     * \brief Constructor.
+     * \param trampoline the function called by the native code for calling other functions
+     * \param level the optimization level
+     */
+    explicit TierCompiler(Trampoline trampoline, OptLevel level = OptLevel::O2);
+
+    /**
+     * \brief Destructor, releases all native code.
+     */
+    ~TierCompiler();
+
+    /**
+     * \brief Compiles a function to native code.
+     * \param f the function to compile
+     * \param linker resolves the targets of the functions called by `f`
+     * \return the entry point of the native code or `nullptr` if the function cannot be compiled
+     */
+    NativeCode compile(const Function &f, const Linker &linker);
+
+    /**
+     * \brief Returns the total time spent in compile().
+     * \return the compilation times summed over all functions
+     */
+    const CompileTimes &getCompileTimes() const;
+
+private:
+    TierCompiler(const TierCompiler &) = delete;
+    TierCompiler(TierCompiler &&) = delete;
+    TierCompiler &operator=(const TierCompiler &) = delete;
+    TierCompiler &operator=(TierCompiler &&) = delete;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace cg
+} // namespace qore
+
+#endif // INCLUDE_QORE_CG_TIERCOMPILER_H_
@@ -54,6 +54,9 @@ class LValue;
  *
  * The actual creation of code blocks and temporaries are delegated to derived classes. This allows a special
  * implementation in the interactive mode where there is no \ref Function instance for the top level code.
+ *
+ * In the \ref RefCountMode::Deferred mode, reference counts are decreased using \ref code::RefDecDeferred which
+ * needs no landing pad, and a \ref code::RefReclaim is emitted before each return.
  */
 class Builder {
 
@@ -74,6 +77,18 @@ public:
      */
     void setCurrentBlock(code::Block *block) {
         currentBlock = block;
+        currentBlock->setLocation(location);
+    }
+
+    /**
+     * \brief Sets the source location of the instructions created from now on.
+     * \param location the location of the statement being translated
+     */
+    void setLocation(SourceLocation location) {
+        this->location = location;
+        if (currentBlock) {
+            currentBlock->setLocation(location);
+        }
     }
 
     /**
@@ -204,7 +219,7 @@ public:
 
     void createRefDec(code::Temp temp) {    //XXX no need to create landing pad for simple types (e.g. string)
         checkNotTerminated();
-        currentBlock->appendRefDec(temp, getLandingPad());
+        appendRefDec(temp, localsStack.rbegin());
     }
 
     void createRefInc(code::Temp temp) {
@@ -215,6 +230,7 @@ public:
     void createRet(code::Temp temp) {
         checkNotTerminated();
         buildLocalsDerefForRet();
+        appendRefReclaim();
         currentBlock->appendRet(temp);
         assert(isTerminated());
     }
@@ -222,12 +238,14 @@ public:
     void createRetVoid() {
         checkNotTerminated();
         buildLocalsDerefForRet();
+        appendRefReclaim();
         currentBlock->appendRetVoid();
         assert(isTerminated());
     }
 
     void createRetVoidInteractive() {
         checkNotTerminated();
+        appendRefReclaim();
         currentBlock->appendRetVoid();
         assert(isTerminated());
     }
@@ -236,8 +254,10 @@ public:
 protected:
     /**
      * \brief Creates the builder. Derived classes must set currentBlock!
+     * \param refCountMode the reference counting mode of the generated code
      */
-    Builder() : currentBlock(nullptr), unlockLValue(nullptr) {
+    explicit Builder(RefCountMode refCountMode) : refCountMode(refCountMode), currentBlock(nullptr),
+            unlockLValue(nullptr) {
     }
 
     /**
@@ -315,12 +335,33 @@ private:
     code::Block *getLandingPad2(std::vector<LocalsStackItem>::reverse_iterator it);
     void buildLocalsDerefForRet();
 
+    /**
+     * \brief Appends the instruction that decreases the reference count of a temporary to the current block.
+     * \param temp the temporary
+     * \param it the position in the stack of locals to build the landing pad from (unused in deferred mode)
+     */
+    void appendRefDec(code::Temp temp, std::vector<LocalsStackItem>::reverse_iterator it) {
+        if (refCountMode == RefCountMode::Deferred) {
+            currentBlock->appendRefDecDeferred(temp);
+        } else {
+            currentBlock->appendRefDec(temp, getLandingPad2(it));
+        }
+    }
+
+    void appendRefReclaim() {
+        if (refCountMode == RefCountMode::Deferred) {
+            currentBlock->appendRefReclaim();
+        }
+    }
+
 private:
+    RefCountMode refCountMode;
     code::Block *currentBlock;
     std::vector<code::Temp> freeTemps;
     std::vector<code::Temp> derefTemps;
     std::vector<LocalsStackItem> localsStack;
     LValue *unlockLValue;
+    SourceLocation location;
 
     friend class LocalsStackMarker;
     friend class TempHelper;
@@ -335,8 +376,9 @@ public:
     /**
      * \brief Creates the builder.
      * \param f the function to build
+     * \param refCountMode the reference counting mode of the generated code
      */
-    explicit FunctionBuilder(Function &f) : f(f) {
+    FunctionBuilder(Function &f, RefCountMode refCountMode) : Builder(refCountMode), f(f) {
         setCurrentBlock(createBlock());
     }
 
@@ -502,7 +544,7 @@ public:
             if (item.lv && item.lv->getType().isRefCounted() && !builder.isTerminated()) {
                 TempHelper temp(builder);
                 builder.currentBlock->appendLocalGet(temp, *item.lv);
-                builder.currentBlock->appendRefDec(temp, builder.getLandingPad());
+                builder.appendRefDec(temp, builder.localsStack.rbegin());
             }
 
             if (item.mark == this) {
@@ -49,11 +49,12 @@ public:
 public:
     /**
      * \brief Creates a new instance.
+     * \param location the location of the statement
      * \param expression the expression
      * \return the new instance
      */
-    static Ptr create(Expression::Ptr expression) {
-        return Ptr(new ExpressionStatement(std::move(expression)));
+    static Ptr create(SourceLocation location, Expression::Ptr expression) {
+        return Ptr(new ExpressionStatement(location, std::move(expression)));
     }
 
     Kind getKind() const override {
@@ -69,7 +70,8 @@ public:
     }
 
 private:
-    explicit ExpressionStatement(Expression::Ptr expression) : expression(std::move(expression)) {
+    ExpressionStatement(SourceLocation location, Expression::Ptr expression) : Statement(location),
+            expression(std::move(expression)) {
     }
 
 private:
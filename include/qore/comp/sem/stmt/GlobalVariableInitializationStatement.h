@@ -81,7 +81,8 @@ public:
 
 private:
     GlobalVariableInitializationStatement(GlobalVariable &globalVariable, Expression::Ptr expression)
-            : globalVariable(globalVariable), expression(std::move(expression)) {
+            : Statement(globalVariable.getLocation()), globalVariable(globalVariable),
+            expression(std::move(expression)) {
     }
 
 private:
@@ -50,15 +50,17 @@ public:
 public:
     /**
      * \brief Creates a new instance.
+     * \param location the location of the statement
      * \param condition the expression representing the condition
      * \param trueBranch the statement to execute if `condition` evaluates to `true`
      * \param falseBranch the statement to execute if `condition` evaluates to `false`, can be nullptr
      * \return the new instance
      */
-    static Ptr create(Expression::Ptr condition, Statement::Ptr trueBranch, Statement::Ptr falseBranch) {
+    static Ptr create(SourceLocation location, Expression::Ptr condition, Statement::Ptr trueBranch,
+            Statement::Ptr falseBranch) {
         assert(condition);
         assert(trueBranch);
-        return Ptr(new IfStatement(std::move(condition), std::move(trueBranch), std::move(falseBranch)));
+        return Ptr(new IfStatement(location, std::move(condition), std::move(trueBranch), std::move(falseBranch)));
     }
 
     Kind getKind() const override {
@@ -90,8 +92,9 @@ public:
     }
 
 private:
-    IfStatement(Expression::Ptr condition, Statement::Ptr trueBranch, Statement::Ptr falseBranch)
-            : condition(std::move(condition)), trueBranch(std::move(trueBranch)), falseBranch(std::move(falseBranch)) {
+    IfStatement(SourceLocation location, Expression::Ptr condition, Statement::Ptr trueBranch,
+            Statement::Ptr falseBranch) : Statement(location), condition(std::move(condition)),
+            trueBranch(std::move(trueBranch)), falseBranch(std::move(falseBranch)) {
     }
 
 private:
@@ -49,11 +49,12 @@ public:
 public:
     /**
      * \brief Creates a new instance.
+     * \param location the location of the statement
      * \param expression the expression representing the return value, can be nullptr
      * \return the new instance
      */
-    static Ptr create(Expression::Ptr expression = nullptr) {
-        return Ptr(new ReturnStatement(std::move(expression)));
+    static Ptr create(SourceLocation location, Expression::Ptr expression = nullptr) {
+        return Ptr(new ReturnStatement(location, std::move(expression)));
     }
 
     Kind getKind() const override {
@@ -69,7 +70,8 @@ public:
     }
 
 private:
-    explicit ReturnStatement(Expression::Ptr expression) : expression(std::move(expression)) {
+    ReturnStatement(SourceLocation location, Expression::Ptr expression) : Statement(location),
+            expression(std::move(expression)) {
     }
 
 private:
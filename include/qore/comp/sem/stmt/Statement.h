@@ -32,6 +32,7 @@
 #define INCLUDE_QORE_COMP_SEM_STMT_STATEMENT_H_
 
 #include <memory>
+#include "qore/core/SourceLocation.h"
 
 namespace qore {
 namespace comp {
@@ -74,6 +75,14 @@ public:
      */
     virtual Kind getKind() const = 0;
 
+    /**
+     * \brief Returns the location of the statement in the source code.
+     * \return the location of the statement, invalid for statements without code of their own
+     */
+    const SourceLocation &getLocation() const {
+        return location;
+    }
+
     /**
      * \brief Calls visitor's `visit()` method appropriate for the concrete type of the Statement.
      * \param visitor the visitor to call
@@ -101,11 +110,21 @@ public:
 protected:
     Statement() = default;
 
+    /**
+     * \brief Constructor.
+     * \param location the location of the statement in the source code
+     */
+    explicit Statement(SourceLocation location) : location(location) {
+    }
+
 private:
     Statement(const Statement &) = delete;
     Statement(Statement &&) = delete;
     Statement &operator=(const Statement &) = delete;
     Statement &operator=(Statement &&) = delete;
+
+private:
+    SourceLocation location;
 };
 
 } // namespace sem
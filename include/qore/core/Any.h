@@ -31,6 +31,7 @@
 #ifndef INCLUDE_QORE_CORE_ANY_H_
 #define INCLUDE_QORE_CORE_ANY_H_
 
+#include "qore/core/Pool.h"
 #include "qore/core/RefCounted.h"
 #include "qore/core/Type.h"
 #include "qore/core/Value.h"
@@ -39,16 +40,56 @@ namespace qore {
 
 /**
  * \brief Base class for all Qore values that are reference-counted.
+ *
+ * Instances are allocated from the \ref Pool.
  */
 class Any : public RefCounted {
 
 public:
+    /**
+     * \brief Allocates memory for an instance from the pool.
+     * \param size the size of the instance
+     * \return the allocated memory
+     */
+    static void *operator new(std::size_t size) {
+        return Pool::allocate(size);
+    }
+
+    /**
+     * \brief Returns the memory of an instance to the pool.
+     * \param ptr the memory to deallocate
+     * \param size the size of the instance
+     */
+    static void operator delete(void *ptr, std::size_t size) noexcept {
+        Pool::deallocate(ptr, size);
+    }
+
     /**
      * \brief Returns the type of the value represented by this instance.
      * \return the type of the value represented by this instance
      */
     virtual const Type &getType() const = 0;
 
+    /**
+     * \brief Returns the runtime type of a value of type `any`.
+     *
+     * Takes the tagged representation of `int` and `bool` values into account (see \ref qvalue).
+     * \param value the value of type `any`
+     * \return the runtime type of the value
+     */
+    static const Type &typeOf(qvalue value) {
+        if (value.isHeapObject()) {
+            return value.p->getType();
+        }
+        if (value.isTaggedInt()) {
+            return Type::Int;
+        }
+        if (value.isTaggedBool()) {
+            return Type::Bool;
+        }
+        return Type::Nothing;
+    }
+
 protected:
     Any() = default;
 
@@ -59,6 +100,9 @@ private:
     Any &operator=(Any &&) = delete;
 };
 
+static_assert(sizeof(RefCounted) <= Pool::Granularity, "the reference count and the vtable pointer of an instance "
+        "must fit into a single cache line");
+
 /**
  * \brief Simple smart pointer for qvalue. The decrease of reference count in destructor is done optionally based
  * on a `refCounted` parameter specified during construction.
@@ -86,7 +130,7 @@ public:
      * \brief Optionally decreases the reference count of the value.
      */
     ~auto_ptr() {
-        if (refCounted && value.p) {
+        if (refCounted && value.isHeapObject()) {
             value.p->decRefCount();
         }
     }
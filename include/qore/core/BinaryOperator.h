@@ -31,6 +31,7 @@
 #ifndef INCLUDE_QORE_CORE_BINARYOPERATOR_H_
 #define INCLUDE_QORE_CORE_BINARYOPERATOR_H_
 
+#include <initializer_list>
 #include <string>
 #include "qore/core/Type.h"
 #include "qore/core/Value.h"
@@ -51,6 +52,8 @@ public:
         PlusEquals,     //!< The '+=' operator.
     };
 
+    static constexpr int KindCount = static_cast<int>(Kind::PlusEquals) + 1;   //!< The number of binary operators.
+
 public:
     using Function = qvalue(qvalue, qvalue);    //!< The type of the function that implements the binary operator.
 
@@ -81,6 +84,24 @@ public:
         return function;
     }
 
+    /**
+     * \brief Returns the kind of the binary operator.
+     * \return the kind of the binary operator
+     */
+    Kind getKind() const {
+        return kind;
+    }
+
+    /**
+     * \brief Returns true if the operator determines the actual operation at runtime based on the operand values.
+     *
+     * Invocations of such operators use a \ref BinaryOperatorCache.
+     * \return true if both operands are of type `any`
+     */
+    bool isDynamic() const {
+        return left == Type::Any && right == Type::Any;
+    }
+
     /**
      * \brief Returns the type of the left operand.
      * \return the type of the left operand
@@ -125,11 +146,49 @@ private:
     BinaryOperator &operator=(const BinaryOperator &) = delete;
     BinaryOperator &operator=(BinaryOperator &&) = delete;
 
+private:
+    /**
+     * \brief Describes a set of cells of the binary operator dispatch table.
+     *
+     * A nullptr type matches any type of the operand. When more cells match the same combination of operand types,
+     * the first one wins.
+     */
+    struct Cell {
+        Kind kind;                          //!< The kind of the binary operator.
+        const Type *left;                   //!< The type of the left operand or nullptr to match any type.
+        const Type *right;                  //!< The type of the right operand or nullptr to match any type.
+    };
+
+    /**
+     * \brief Describes the cells of the binary operator dispatch table that use the same binary operator.
+     */
+    struct Rule {
+        const BinaryOperator &op;           //!< The binary operator to use.
+        std::initializer_list<Cell> cells;  //!< The cells in order of decreasing priority.
+    };
+
+    /**
+     * \brief Dense matrix of binary operators indexed by the kind of the operator and the kinds of operand types.
+     */
+    class Table {
+
+    public:
+        /**
+         * \brief Builds the matrix from a list of rules.
+         * \param rules the rules in order of decreasing priority
+         */
+        Table(std::initializer_list<Rule> rules);
+
+        /// The cells indexed by [kind][left][right], nullptr if no operator is applicable.
+        const BinaryOperator *entries[KindCount][Type::KindCount][Type::KindCount];
+    };
+
 private:
     static const BinaryOperator AnyPlusAny;
     static const BinaryOperator AnyPlusEqualsAny;
     static const BinaryOperator SoftStringPlusSoftString;
     static const BinaryOperator SoftIntPlusSoftInt;
+    static const Table DispatchTable;
 
 private:
     std::string functionName;
@@ -31,6 +31,7 @@
 #ifndef INCLUDE_QORE_CORE_CONVERSION_H_
 #define INCLUDE_QORE_CORE_CONVERSION_H_
 
+#include <initializer_list>
 #include <string>
 #include "qore/core/Type.h"
 #include "qore/core/Value.h"
@@ -71,6 +72,14 @@ public:
         return function;
     }
 
+    /**
+     * \brief Returns the original type.
+     * \return the original type
+     */
+    const Type &getFromType() const {
+        return from;
+    }
+
     /**
      * \brief Returns the destination type.
      * \return the destination type
@@ -79,6 +88,16 @@ public:
         return to;
     }
 
+    /**
+     * \brief Returns true if the conversion determines the actual conversion at runtime based on the value.
+     *
+     * Invocations of such conversions use a \ref ConversionCache.
+     * \return true if the original type is `any`
+     */
+    bool isDynamic() const {
+        return from == Type::Any;
+    }
+
     /**
      * \brief Returns true if the conversion can throw an exception at runtime.
      * \return true if the conversion can throw an exception at runtime
@@ -98,12 +117,46 @@ private:
     Conversion &operator=(const Conversion &) = delete;
     Conversion &operator=(Conversion &&) = delete;
 
+private:
+    /**
+     * \brief Describes the cells of the conversion dispatch table that use the same conversion.
+     */
+    struct Rule {
+        const Type &from;                           //!< The original type.
+        std::initializer_list<const Type *> to;     //!< The destination types.
+        const Conversion *conversion;               //!< The conversion or nullptr for an identity conversion.
+    };
+
+    /**
+     * \brief Dense matrix of implicit conversions indexed by the kinds of the original and destination types.
+     */
+    class Table {
+
+    public:
+        /**
+         * \brief Builds the matrix from a list of rules.
+         * \param rules the rules, each pair of the original and a destination type may appear at most once
+         */
+        Table(std::initializer_list<Rule> rules);
+
+        /**
+         * \brief Describes one cell of the matrix.
+         */
+        struct Entry {
+            const Conversion *conversion;   //!< The conversion or nullptr for an identity conversion.
+            bool exists;                    //!< False if there is no implicit conversion.
+        };
+
+        Entry entries[Type::KindCount][Type::KindCount];    //!< The cells indexed by [from][to].
+    };
+
 private:
     static const Conversion AnyToString;
     static const Conversion IntToAny;
     static const Conversion IntToBool;
     static const Conversion IntToString;
     static const Conversion StringToInt;
+    static const Table DispatchTable;
 
 private:
     std::string functionName;
@@ -33,6 +33,7 @@
 
 #include <string>
 #include <vector>
+#include "qore/core/Defs.h"
 #include "qore/core/Namespace.h"
 #include "qore/core/String.h"
 
@@ -52,9 +53,19 @@ public:
 
 public:
     /**
-     * \brief Default constructor.
+     * \brief Constructor.
+     * \param refCountMode determines how the code generated for this environment releases objects
      */
-    Env() : rootNamespace("", SourceLocation()) {
+    explicit Env(RefCountMode refCountMode = RefCountMode::Immediate) : rootNamespace("", SourceLocation()),
+            refCountMode(refCountMode) {
+    }
+
+    /**
+     * \brief Returns the reference counting mode used by the code generated for this environment.
+     * \return the reference counting mode
+     */
+    RefCountMode getRefCountMode() const {
+        return refCountMode;
     }
 
     /**
@@ -80,17 +91,29 @@ public:
     /**
      * \brief Creates a new string literal.
      *
-     * The reference count of the string will not drop to zero before this instance of Env gets destroyed.
+     * The string is immortal (see RefCounted::makeImmortal()), therefore the generated code does not need to
+     * increase or decrease its reference count. It is destroyed together with this instance of Env.
      * \param value the value of the string
      * \return the new string
      */
     String &addString(std::string value) {
         String::Ptr ptr = String::Ptr(new String(std::move(value)));
         String &str = *ptr;
-        strings.push_back(std::move(ptr));
+        str.makeImmortal();
+        strings.list.push_back(std::move(ptr));
         return str;
     }
 
+    /**
+     * \brief Preallocates the storage for source infos and string literals.
+     * \param sourceInfoCount the expected number of source infos
+     * \param stringCount the expected number of string literals
+     */
+    void reserve(Size sourceInfoCount, Size stringCount) {
+        sourceInfos.reserve(sourceInfoCount);
+        strings.list.reserve(stringCount);
+    }
+
     /**
      * \brief Returns a range for iterating source infos.
      * \return a range for iterating source infos
@@ -104,7 +127,7 @@ public:
      * \return a range for iterating string literals
      */
     util::IteratorRange<StringIterator> getStrings() {
-        return util::IteratorRange<StringIterator>(strings);
+        return util::IteratorRange<StringIterator>(strings.list);
     }
 
 private:
@@ -113,10 +136,28 @@ private:
     Env &operator=(const Env &) = delete;
     Env &operator=(Env &&) = delete;
 
+    /**
+     * \brief Owns the string literals and destroys them together with the environment.
+     *
+     * Declared before the root namespace so that it is destroyed after it. Global variables may still refer to the
+     * literals and release those references when the namespace is destroyed, which must happen while the literals
+     * are immortal, otherwise the literals would be freed twice.
+     */
+    struct Strings {
+        ~Strings() {
+            for (String::Ptr &str : list) {
+                str->makeMortal();
+            }
+        }
+
+        std::vector<String::Ptr> list;
+    };
+
 private:
     std::vector<SourceInfo::Ptr> sourceInfos;
-    std::vector<String::Ptr> strings;
+    Strings strings;
     Namespace rootNamespace;
+    RefCountMode refCountMode;
 };
 
 } // namespace qore
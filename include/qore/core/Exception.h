@@ -39,6 +39,12 @@ namespace qore {
 class Exception {
 };
 
+/**
+ * \brief Thrown when the depth of nested calls exceeds the configured limit.
+ */
+class StackOverflowException : public Exception {
+};
+
 } // namespace qore
 
 #endif // INCLUDE_QORE_CORE_EXCEPTION_H_
@@ -51,6 +51,7 @@ class Function {
 public:
     using Ptr = std::unique_ptr<Function>;                                          //!< Pointer type.
     using LocalVariableIterator = util::VectorOfPtrIteratorAdapter<LocalVariable>;  //!< Locals iterator.
+    using BlockIterator = util::VectorOfPtrIteratorAdapter<code::Block>;            //!< Blocks iterator.
 
 public:
     /**
@@ -87,6 +88,18 @@ public:
         return location;
     }
 
+    /**
+     * \brief Returns the name of the symbol of the function in native code.
+     *
+     * The name follows the mangling scheme of the Itanium C++ ABI, so that standard tools such as `c++filt` and
+     * `perf` demangle it. The namespaces and the name of the function group become a nested name, the types of the
+     * parameters are encoded as vendor extended types (e.g. `::ns::f(int, *string)` becomes
+     * `_ZN2ns1fEu3intu7*string`). The name depends only on the declaration of the function, so it is stable
+     * across compilations.
+     * \return the mangled name of the function
+     */
+    std::string getMangledName() const;
+
     /**
      * \brief Returns the number of temporaries needed for interpreting this functions.
      *
@@ -149,6 +162,51 @@ public:
         return util::IteratorRange<LocalVariableIterator>(locals);
     }
 
+    /**
+     * \brief Returns a range for iterating the blocks of the function in the order of their creation.
+     * \return a range for iterating the blocks of the function
+     */
+    util::IteratorRange<BlockIterator> getBlocks() const {
+        return util::IteratorRange<BlockIterator>(blocks);
+    }
+
+    /**
+     * \brief Removes reference count operations that provably cancel out or have no effect.
+     *
+     * Tracks within each block whether a temporary holds a string literal (which is never deallocated) or the value
+     * of a local variable. Increments and decrements of literals are removed. An increment of a local variable's value
+     * is removed together with the matching decrement, unless the reference is handed over to a new owner. If the value
+     * is passed to an operator, conversion or function in between, the pair is only removed if the variable is not read
+     * on any path after the call (callees rely on the reference count to decide whether they may modify a value in
+     * place), which is determined by a liveness analysis across all blocks. This turns copies followed by the release
+     * of the local variable into moves. For each instruction that can throw in between, one decrement of the same
+     * value is removed from its landing pad as well, and landing pads that are left with nothing but
+     * \ref code::ResumeUnwind are dropped. Must be called after the code of the function is complete and before
+     * \ref fuseInstructions().
+     * \return the number of removed instructions
+     */
+    Size elideRefCounts();
+
+    /**
+     * \brief Replaces common instruction sequences with equivalent superinstructions.
+     *
+     * Fuses the locked read of a global variable (with or without the reference count increment) into
+     * \ref code::GlobalLoad or \ref code::GlobalLoadRef, a local variable read followed by a reference count
+     * increment into \ref code::LocalLoadRef, and a conversion to boolean whose result only feeds a branch into
+     * \ref code::ConvertAndBranch. Must be called after the code of the function is complete.
+     */
+    void fuseInstructions();
+
+    /**
+     * \brief Renumbers the temporaries so that temporaries with disjoint lifetimes share the same index.
+     *
+     * Uses \ref code::Liveness to find the instructions that need the value of each temporary and assigns indices
+     * in the order of the first use, picking the lowest index that is not in use by any of those instructions. This
+     * reduces \ref getTempCount() and therefore the size of interpreter frames and the number of stack slots in
+     * compiled code. Must be called after the code of the function is complete.
+     */
+    void compactTemps();
+
     /**
      * \brief Returns false if it is guaranteed that the function cannot throw an exception.
      * \return false if it is guaranteed that the function cannot throw an exception
@@ -67,7 +67,7 @@ public:
      * \brief Decreases the reference count of the value (if needed).
      */
     ~GlobalVariable() {
-        if (hasValue && type.isRefCounted() && value.p) {
+        if (hasValue && type.isRefCounted() && value.isHeapObject()) {
             value.p->decRefCount();
         }
         LOG("GlobalVariable " << fullName << " destroyed");
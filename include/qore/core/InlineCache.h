@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines polymorphic inline caches for operations on values of type `any`.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CORE_INLINECACHE_H_
+#define INCLUDE_QORE_CORE_INLINECACHE_H_
+
+#include <atomic>
+#include "qore/core/BinaryOperator.h"
+#include "qore/core/Conversion.h"
+#include "qore/core/Defs.h"
+
+namespace qore {
+
+/**
+ * \brief Common base of polymorphic inline caches.
+ *
+ * An inline cache belongs to a single instruction which operates on values of type `any`. It remembers up to
+ * \ref Capacity combinations of actual runtime types seen by the instruction together with the operation resolved
+ * for them, so that subsequent executions with the same types skip the lookup. Once all slots are taken, the cache
+ * is megamorphic and new combinations are resolved on every execution.
+ *
+ * A cache whose memory is all zero bits is valid and empty, which allows generated code to allocate caches as
+ * zero-initialized globals. Slots are filled atomically and never changed afterwards, so a cache can be shared
+ * by multiple threads.
+ */
+class InlineCache {
+
+public:
+    static constexpr int Capacity = 4;      //!< The maximum number of type combinations remembered by a cache.
+
+    /**
+     * \brief Counters of inline cache lookups.
+     */
+    struct Stats {
+        Size hits;                          //!< The number of lookups that found a matching entry.
+        Size misses;                        //!< The number of lookups that had to resolve the operation.
+    };
+
+public:
+    /**
+     * \brief Returns the counters of lookups of all inline caches.
+     *
+     * The counters are maintained per thread, the result includes threads that have already finished and the
+     * calling thread.
+     * \return the counters of lookups
+     */
+    static Stats getStats();
+
+protected:
+    InlineCache() = default;
+
+    /// \cond
+    static void hit() noexcept;
+    static void miss() noexcept;
+    /// \endcond
+};
+
+/**
+ * \brief Polymorphic inline cache of an instruction that executes a binary operator on operands of type `any`.
+ */
+class BinaryOperatorCache : public InlineCache {
+
+public:
+    BinaryOperatorCache() = default;
+
+    /**
+     * \brief Executes a binary operator determined by the actual types of operands.
+     * \param kind the kind of the binary operator
+     * \param left the value of the left operand of type `any` (see \ref qvalue for the representation)
+     * \param right the value of the right operand of type `any` (see \ref qvalue for the representation)
+     * \return the result of the operation with reference count increased (it is always reference counted)
+     * \throws Exception if the specified kind of binary operator does not apply for the types of the values
+     */
+    qvalue invoke(BinaryOperator::Kind kind, qvalue left, qvalue right);
+
+private:
+    BinaryOperatorCache(const BinaryOperatorCache &) = delete;
+    BinaryOperatorCache(BinaryOperatorCache &&) = delete;
+    BinaryOperatorCache &operator=(const BinaryOperatorCache &) = delete;
+    BinaryOperatorCache &operator=(BinaryOperatorCache &&) = delete;
+
+private:
+    struct Entry;
+
+    std::atomic<const Entry *> entries[Capacity] = {};
+};
+
+/**
+ * \brief Polymorphic inline cache of an instruction that converts a value of type `any` to another type.
+ */
+class ConversionCache : public InlineCache {
+
+public:
+    ConversionCache() = default;
+
+    /**
+     * \brief Converts a value of type `any` to the specified type.
+     * \param type the destination type
+     * \param value the value of type `any` to convert (see \ref qvalue for the representation)
+     * \return a value of type `type` with reference count increased (if `type` is reference counted)
+     * \throws Exception if no conversion exists
+     */
+    qvalue invoke(const Type &type, qvalue value);
+
+private:
+    ConversionCache(const ConversionCache &) = delete;
+    ConversionCache(ConversionCache &&) = delete;
+    ConversionCache &operator=(const ConversionCache &) = delete;
+    ConversionCache &operator=(ConversionCache &&) = delete;
+
+private:
+    struct Entry;
+
+    std::atomic<const Entry *> entries[Capacity] = {};
+};
+
+} // namespace qore
+
+#endif // INCLUDE_QORE_CORE_INLINECACHE_H_
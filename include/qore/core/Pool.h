@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the pool allocator used by reference-counted runtime values.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CORE_POOL_H_
+#define INCLUDE_QORE_CORE_POOL_H_
+
+#include "qore/core/Defs.h"
+
+namespace qore {
+
+/**
+ * \brief Thread-caching size-class allocator for small runtime objects.
+ *
+ * Memory is carved from slabs aligned to their size so that the slab (and the thread heap owning it) can be found
+ * from any pointer into it. Each thread allocates from its own heap which keeps a free list per size class, so the
+ * common case of an object freed by the thread that created it needs no synchronization at all. Objects freed by
+ * other threads are collected in per-thread batches and handed over to the owning heap in one atomic operation,
+ * the owner picks them up when its local free list runs empty.
+ *
+ * Size classes are multiples of \ref Granularity which is half of a cache line, therefore the first
+ * \ref Granularity bytes of an object never straddle a cache line boundary. Requests larger than \ref MaxSize
+ * are forwarded to the global `operator new`.
+ *
+ * Heaps are never deallocated - when a thread terminates, its heap is returned to a pool and later adopted by
+ * another thread together with all slabs it owns. Slabs are never returned to the operating system.
+ */
+class Pool {
+
+public:
+    static constexpr Size Granularity = 32;             //!< The difference between consecutive size classes.
+    static constexpr Size MaxSize = 256;                //!< The largest size served from slabs.
+
+    /**
+     * \brief Allocates memory.
+     * \param size the number of bytes to allocate
+     * \return the allocated memory, aligned to \ref Granularity if `size` is at most \ref MaxSize
+     * \throws std::bad_alloc if the memory cannot be allocated
+     */
+    static void *allocate(Size size);
+
+    /**
+     * \brief Deallocates memory allocated by allocate().
+     *
+     * Can be called by any thread.
+     * \param ptr the memory to deallocate
+     * \param size the size passed to allocate()
+     */
+    static void deallocate(void *ptr, Size size) noexcept;
+
+    /**
+     * \brief Returns the total size of slabs reserved so far.
+     * \return the number of bytes reserved for slabs
+     */
+    static Size getReservedSize() noexcept;
+
+private:
+    Pool() = delete;
+
+    class Heap;
+};
+
+} // namespace qore
+
+#endif // INCLUDE_QORE_CORE_POOL_H_
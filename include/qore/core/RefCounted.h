@@ -32,44 +32,166 @@
 #define INCLUDE_QORE_CORE_REFCOUNTED_H_
 
 #include <atomic>
+#include <cassert>
+#include <cstdint>
 #include "qore/core/Defs.h"
 #include "qore/core/util/Debug.h"
 #include "qore/core/util/Loggable.h"
 
 namespace qore {
 
+/**
+ * \brief Determines when objects whose reference count drops to zero are destroyed by the generated code.
+ */
+enum class RefCountMode {
+    Immediate,          //!< Objects are destroyed as soon as their reference count drops to zero.
+    Deferred,           //!< Objects are queued and destroyed in batches, see RefCounted::decRefCountDeferred().
+};
+
+/**
+ * \brief Returns the address of the owner record slot of the current thread (see RefCounted).
+ *
+ * The runtime bitcode linked into generated code (compiled with `QORE_RUNTIME_BITCODE`) cannot access the
+ * thread-local variables of the process, so it reaches the slot through this function instead.
+ * \return the address of the thread-local `RefCounted::Owner` pointer
+ */
+extern "C" void *refCounted_ownerSlot() noexcept;
+
 /**
  * \brief Base class for reference-counted objects.
  *
  * Instances must be allocated on the heap and the delete operator must not be used on them explicitly.
+ *
+ * Uses biased reference counting: the thread that created the object (the owner) uses a non-atomic counter, all
+ * other threads use a shared atomic counter. The counters are merged when the owner's counter drops to zero. If
+ * the shared counter becomes negative before that, the object is queued to the owner which merges the counters
+ * explicitly the next time it creates an object (or when it terminates), so that objects released by other threads
+ * are not kept alive indefinitely.
+ *
+ * Objects can also be made immortal (see makeImmortal()), in which case incRefCount() and decRefCount() do not
+ * touch the counters at all.
+ *
+ * Objects released by decRefCountDeferred() are not destroyed immediately. Instead, they are added to the zero count
+ * table of the current thread which is drained by reclaimDeferred() or once it holds \ref DeferredBatchSize objects.
  */
 class RefCounted : public util::Loggable {
 
+public:
+    static constexpr Size DeferredBatchSize = 1024;     //!< The capacity of the zero count table.
+
 public:
     /**
      * \brief Increases the reference count.
      */
     void incRefCount() noexcept {
-        LOG(this << " incRefCount: " << refCount << "->" << (refCount + 1));
-        ++refCount;
+        LOG(this << " incRefCount: " << getRefCount() << "->" << (getRefCount() + 1));
+        if (owner == currentOwner() && biased != 0) {
+            ++biased;
+        } else if (!(shared.load(std::memory_order_relaxed) & Immortal)) {
+            shared.fetch_add(SharedUnit, std::memory_order_relaxed);
+        }
     }
 
     /**
      * \brief Decreases the reference count and if it drops to zero, commits suicide.
      */
     void decRefCount() noexcept {
-        LOG(this << " decRefCount: " << refCount << "->" << (refCount - 1));
-        if (!--refCount) {
-            delete this;
+        LOG(this << " decRefCount: " << getRefCount() << "->" << (getRefCount() - 1));
+        if (owner == currentOwner() && biased != 0) {
+            if (--biased == 0) {
+                mergeOwn(false);
+            }
+        } else {
+            decShared(false);
         }
     }
 
+    /**
+     * \brief Decreases the reference count and if it drops to zero, adds the object to the zero count table.
+     *
+     * The object is destroyed later by the current thread, either by reclaimDeferred() or when the table is full.
+     */
+    void decRefCountDeferred() noexcept {
+        LOG(this << " decRefCountDeferred: " << getRefCount() << "->" << (getRefCount() - 1));
+        if (owner == currentOwner() && biased != 0) {
+            if (--biased == 0) {
+                mergeOwn(true);
+            }
+        } else {
+            decShared(true);
+        }
+    }
+
+    /**
+     * \brief Destroys all objects in the zero count table of the current thread.
+     */
+    static void reclaimDeferred() noexcept;
+
+    /**
+     * \brief Returns the number of objects in the zero count table of the current thread.
+     * \return the number of objects waiting for reclaimDeferred()
+     */
+    static Size getDeferredCount() noexcept;
+
+    /**
+     * \brief Returns the reference count as seen by the current thread.
+     *
+     * The value is exact only if no other thread manipulates the reference count concurrently, it is intended for
+     * diagnostic purposes only.
+     * \return the reference count
+     */
+    std::intptr_t getRefCount() const noexcept {
+        std::intptr_t b = owner == currentOwner() ? static_cast<std::intptr_t>(biased) : 0;
+        return b + (shared.load(std::memory_order_relaxed) >> CountShift);
+    }
+
+    /**
+     * \brief Determines whether the caller holds the only reference to the object.
+     *
+     * The result is conservative - it may return false for uniquely referenced objects owned by another thread.
+     * Immortal objects are never unique.
+     *
+     * Callers use this to modify objects in place (e.g. String::append()), which is only safe if everyone who can
+     * still read the object holds a counted reference to it. Code that borrows a value without increasing its
+     * reference count (see Function::elideRefCounts()) must therefore not pass it to anything that may call this
+     * method while the object is also reachable elsewhere.
+     * \return true if the reference count is one
+     */
+    bool isUnique() const noexcept {
+        std::intptr_t s = shared.load(std::memory_order_acquire);
+        if (owner == currentOwner() && biased != 0) {
+            return biased == 1 && (s & ~FlagMask) == 0;
+        }
+        return (s & (Merged | Immortal | Queued)) == Merged && (s >> CountShift) == 1;
+    }
+
+    /**
+     * \brief Makes the object immortal.
+     *
+     * The reference count of an immortal object is not affected by incRefCount() and decRefCount() and the object
+     * is never destroyed unless makeMortal() is called. Must be called by the owner of the only reference before
+     * the object is shared.
+     */
+    void makeImmortal() noexcept {
+        biased = 0;
+        shared.store(Immortal | Merged, std::memory_order_release);
+    }
+
+    /**
+     * \brief Reverts the effect of makeImmortal() by setting the reference count to one.
+     *
+     * Must be called only when no other references to the object exist, the caller becomes the owner of the only
+     * reference.
+     */
+    void makeMortal() noexcept {
+        shared.store(SharedUnit | Merged, std::memory_order_release);
+    }
+
 protected:
     /**
      * \brief Constructs the object with reference count set to one.
      */
-    RefCounted() : refCount(1) {
-    }
+    RefCounted();
 
     /**
      * \brief Destructor that will be invoked when the reference count drops to zero.
@@ -83,8 +205,40 @@ private:
     RefCounted &operator=(const RefCounted &) = delete;
     RefCounted &operator=(RefCounted &&) = delete;
 
+    class Owner;
+    class ZeroCountTable;
+
+    /**
+     * \brief Returns the owner record of the current thread.
+     * \return the owner record of the current thread or `nullptr` if the thread does not have one (yet)
+     */
+    static Owner *&currentOwner() noexcept {
+#ifdef QORE_RUNTIME_BITCODE
+        return *static_cast<Owner **>(refCounted_ownerSlot());
+#else
+        static thread_local Owner *current = nullptr;
+        return current;
+#endif
+    }
+
+    void mergeOwn(bool deferred) noexcept;
+    void mergeQueued() noexcept;
+    void decShared(bool deferred) noexcept;
+    void destroy(bool deferred) noexcept;
+
+    friend void *refCounted_ownerSlot() noexcept;
+
 private:
-    std::atomic<Size> refCount;
+    static constexpr std::intptr_t Merged = 1;           //!< Set when the biased counter has been merged.
+    static constexpr std::intptr_t Queued = 2;           //!< Set when the object is queued for explicit merge.
+    static constexpr std::intptr_t Immortal = 4;         //!< Set when the object is immortal.
+    static constexpr std::intptr_t FlagMask = 7;
+    static constexpr int CountShift = 3;
+    static constexpr std::intptr_t SharedUnit = 1 << CountShift;
+
+    Owner *owner;                                       //!< The owner record of the thread that owns the object.
+    Size biased;                                        //!< Used only by the owner, zero once merged.
+    std::atomic<std::intptr_t> shared;                  //!< The shared count shifted by CountShift plus flags.
 };
 
 /**
@@ -31,6 +31,7 @@
 #ifndef INCLUDE_QORE_CORE_STRING_H_
 #define INCLUDE_QORE_CORE_STRING_H_
 
+#include <atomic>
 #include <string>
 #include "qore/core/Any.h"
 #include "qore/core/Value.h"
@@ -39,6 +40,11 @@ namespace qore {
 
 /**
  * \brief Implementation of Qore's `string` type.
+ *
+ * The result of a concatenation where the left operand is shared and the result is long enough is represented as
+ * a rope, i.e. a node referring to both operands. The rope is flattened lazily when the value is needed, so a chain
+ * of n concatenations creates n nodes and copies the characters once. If the left operand of a concatenation is not
+ * shared, the right operand is appended to it in place.
  */
 class String : public Any {
 
@@ -50,7 +56,8 @@ public:
      * \brief Creates a new instance.
      * \param str the value of the string
      */
-    explicit String(std::string str) : str(std::move(str)) {
+    explicit String(std::string str) : str(std::move(str)), left(nullptr), right(nullptr),
+            length(this->str.size()), flat(true), intValue(0), intValueValid(false) {
         LOG(this << " created");
     }
 
@@ -58,42 +65,84 @@ public:
         return Type::String;
     }
 
+    /**
+     * \brief Creates a new instance holding the decimal representation of an integer.
+     *
+     * The digits are formatted directly into the buffer of the string. The result of toInt() is known in advance,
+     * so it is cached immediately.
+     * \param value the integer value
+     * \return the new instance
+     */
+    static String *fromInt(qint value);
+
     /**
      * \brief Converts the string to an integer.
+     *
+     * The rules are described in util::parseInt(). The result is cached so that repeated conversions of the same
+     * instance do not need to parse the string again.
      * \return integer value represented by this string
-     * \todo define the conversion - should it throw or behave like current qore does?
      */
-    qint toInt() const;
+    qint toInt() const {
+        if (intValueValid.load(std::memory_order_acquire)) {
+            return intValue.load(std::memory_order_relaxed);
+        }
+        return parseInt();
+    }
 
     /**
-     * \brief Appends another string to the string represented by this instance.
+     * \brief Concatenates this string with another string.
      *
-     * Does not change this instance, instead returns the concatenation.
+     * If the caller holds the only reference to this instance, `right` is appended to it in place and this instance
+     * is returned. Otherwise a new string (possibly a rope) is created. In both cases, the caller is responsible for
+     * decreasing the reference count of the result.
      * \param right the string to append
      * \return the concatenation of this string with `right`
      */
-    String *append(String *right) const {
-        return new String(str + right->str);
-    }
+    String *append(String *right);
 
     /**
      * \brief Returns the value.
      * \return the value
      */
     const std::string &get() const {
+        if (!flat.load(std::memory_order_acquire)) {
+            flatten();
+        }
         return str;
     }
 
-protected:
-    ~String() {
-        LOG(this << " destroyed");
+    /**
+     * \brief Returns the length of the string.
+     * \return the length of the string in bytes
+     */
+    Size getLength() const {
+        return length;
     }
 
 protected:
-    WRITE_TO_LOG("String \"" << str << "\"")
+    ~String();
+
+protected:
+    WRITE_TO_LOG("String " << (flat.load(std::memory_order_acquire) ? "\"" + str + "\""
+            : "rope(" + std::to_string(length) + ")"))
 
 private:
-    std::string str;
+    String(String *left, String *right);
+    explicit String(qint value);
+    void flatten() const;
+    qint parseInt() const;
+    void releaseChildren();
+
+private:
+    static constexpr Size RopeThreshold = 256;      //!< Shorter concatenations are always flattened.
+
+    mutable std::string str;                        //!< The value, valid only if `flat` is true.
+    String *left;                                   //!< The left child of a rope node.
+    String *right;                                  //!< The right child of a rope node.
+    Size length;
+    mutable std::atomic<bool> flat;
+    mutable std::atomic<qint> intValue;             //!< The cached result of toInt().
+    mutable std::atomic<bool> intValueValid;        //!< True if `intValue` is valid.
 };
 
 } // namespace qore
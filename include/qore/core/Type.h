@@ -66,6 +66,8 @@ private:
         ObjectOpt,      //!< The '*object' type.
     };
 
+    static constexpr int KindCount = static_cast<int>(Kind::ObjectOpt) + 1;    //!< The number of kinds of types.
+
 public:
     using Ptr = std::unique_ptr<Type>;      //!< Pointer type.
 
@@ -160,6 +162,9 @@ public:
 private:
     Kind kind;
     std::string name;
+
+    friend class BinaryOperator;
+    friend class Conversion;
 };
 
 /**
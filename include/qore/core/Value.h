@@ -57,14 +57,107 @@ using qptr = class Any *;
 
 /**
  * \brief A 64-bit type that can hold any value.
+ *
+ * Values of statically known primitive types use the corresponding member directly. Values of type `any` use
+ * pointer tagging so that `int` and `bool` values can be stored without allocating a boxed object on the heap:
+ *  - all bits zero represent `NOTHING`,
+ *  - if the lowest bit is set, the remaining 63 bits hold a (signed) `int` value,
+ *  - if the lowest three bits are `010`, the bit 3 holds a `bool` value,
+ *  - otherwise the value is a pointer to a heap-allocated instance of \ref Any.
+ *
+ * Since heap-allocated objects are always at least 8-byte aligned, the tags never clash with a valid pointer.
+ * Integers that do not fit into 63 bits are still boxed as \ref Int.
  */
 union qvalue {
     qbool b;        //!< Holds a 'bool' value.
     qint i;         //!< Holds an 'int' value.
     qfloat f;       //!< Holds a 'float' value.
     qptr p;         //!< Holds a pointer to a heap-allocated value.
+
+    /**
+     * \brief Determines whether a value of type `any` is a pointer to a heap-allocated object.
+     * \return true if the value is neither `NOTHING` nor a tagged `int` or `bool`
+     */
+    bool isHeapObject() const noexcept {
+        return i != 0 && (i & TagMask) == 0;
+    }
+
+    /**
+     * \brief Determines whether a value of type `any` holds a tagged `int`.
+     * \return true if the value holds a tagged `int`
+     */
+    bool isTaggedInt() const noexcept {
+        return (i & IntTag) != 0;
+    }
+
+    /**
+     * \brief Determines whether a value of type `any` holds a tagged `bool`.
+     * \return true if the value holds a tagged `bool`
+     */
+    bool isTaggedBool() const noexcept {
+        return (i & TagMask) == BoolTag;
+    }
+
+    /**
+     * \brief Determines whether an `int` value can be represented as a tagged `int`.
+     * \param value the value to check
+     * \return true if `value` fits into 63 bits
+     */
+    static bool fitsTaggedInt(qint value) noexcept {
+        return value >= MinTaggedInt && value <= MaxTaggedInt;
+    }
+
+    /**
+     * \brief Creates a tagged `int` value.
+     * \param value the value, must satisfy \ref fitsTaggedInt()
+     * \return tagged value of type `any`
+     */
+    static qvalue tagInt(qint value) noexcept {
+        qvalue v;
+        v.i = static_cast<qint>(static_cast<uint64_t>(value) << 1) | IntTag;
+        return v;
+    }
+
+    /**
+     * \brief Extracts the value of a tagged `int`.
+     * \return the `int` value
+     */
+    qint untagInt() const noexcept {
+        return i >> 1;
+    }
+
+    /**
+     * \brief Creates a tagged `bool` value.
+     * \param value the value
+     * \return tagged value of type `any`
+     */
+    static qvalue tagBool(qbool value) noexcept {
+        qvalue v;
+        v.i = value ? (BoolTag | BoolBit) : BoolTag;
+        return v;
+    }
+
+    /**
+     * \brief Extracts the value of a tagged `bool`.
+     * \return the `bool` value
+     */
+    qbool untagBool() const noexcept {
+        return (i & BoolBit) != 0;
+    }
+
+private:
+    enum : qint {
+        IntTag = 1,
+        BoolTag = 2,
+        BoolBit = 8,
+        TagMask = 7,
+        MaxTaggedInt = INT64_MAX >> 1,
+        MinTaggedInt = INT64_MIN >> 1,
+    };
 };
 
+static_assert(sizeof(qvalue) == 8, "qvalue must be 64 bits wide");
+
 } // namespace qore
 
 #endif // INCLUDE_QORE_CORE_VALUE_H_
@@ -37,8 +37,11 @@
 #include "qore/core/code/ConstInt.h"
 #include "qore/core/code/ConstNothing.h"
 #include "qore/core/code/ConstString.h"
+#include "qore/core/code/ConvertAndBranch.h"
 #include "qore/core/code/GlobalGet.h"
 #include "qore/core/code/GlobalInit.h"
+#include "qore/core/code/GlobalLoad.h"
+#include "qore/core/code/GlobalLoadRef.h"
 #include "qore/core/code/GlobalReadLock.h"
 #include "qore/core/code/GlobalReadUnlock.h"
 #include "qore/core/code/GlobalSet.h"
@@ -49,10 +52,13 @@
 #include "qore/core/code/InvokeFunction.h"
 #include "qore/core/code/Jump.h"
 #include "qore/core/code/LocalGet.h"
+#include "qore/core/code/LocalLoadRef.h"
 #include "qore/core/code/LocalSet.h"
 #include "qore/core/code/RefDec.h"
+#include "qore/core/code/RefDecDeferred.h"
 #include "qore/core/code/RefDecNoexcept.h"
 #include "qore/core/code/RefInc.h"
+#include "qore/core/code/RefReclaim.h"
 #include "qore/core/code/ResumeUnwind.h"
 #include "qore/core/code/Ret.h"
 #include "qore/core/code/RetVoid.h"
@@ -143,6 +149,18 @@ public:
         append<ConstString>(dest, value);
     }
 
+    /**
+     * \brief Appends a ConvertAndBranch instruction to the end of the block.
+     * \param conversion the conversion that produces the boolean value of the condition
+     * \param arg the temporary holding the value to convert
+     * \param trueDest the block to jump to in case the condition is true
+     * \param falseDest the block to jump to in case the condition is false
+     */
+    void appendConvertAndBranch(const Conversion &conversion, Temp arg, const Block &trueDest,
+            const Block &falseDest) {
+        append<ConvertAndBranch>(conversion, arg, trueDest, falseDest);
+    }
+
     /**
      * \brief Appends a GlobalGet instruction to the end of the block.
      * \param dest the temporary to load the value of the global variable into
@@ -161,6 +179,24 @@ public:
         append<GlobalInit>(globalVariable, initValue);
     }
 
+    /**
+     * \brief Appends a GlobalLoad instruction to the end of the block.
+     * \param dest the temporary to load the value of the global variable into
+     * \param globalVariable the global variable
+     */
+    void appendGlobalLoad(Temp dest, GlobalVariable &globalVariable) {
+        append<GlobalLoad>(dest, globalVariable);
+    }
+
+    /**
+     * \brief Appends a GlobalLoadRef instruction to the end of the block.
+     * \param dest the temporary to load the value of the global variable into
+     * \param globalVariable the global variable
+     */
+    void appendGlobalLoadRef(Temp dest, GlobalVariable &globalVariable) {
+        append<GlobalLoadRef>(dest, globalVariable);
+    }
+
     /**
      * \brief Appends a GlobalReadLock instruction to the end of the block.
      * \param globalVariable the global variable
@@ -253,6 +289,15 @@ public:
         append<LocalGet>(dest, localVariable);
     }
 
+    /**
+     * \brief Appends a LocalLoadRef instruction to the end of the block.
+     * \param dest the temporary to load the value of the local variable into
+     * \param localVariable the local variable
+     */
+    void appendLocalLoadRef(Temp dest, const LocalVariable &localVariable) {
+        append<LocalLoadRef>(dest, localVariable);
+    }
+
     /**
      * \brief Appends a LocalSet instruction to the end of the block.
      * \param localVariable the local variable
@@ -271,6 +316,14 @@ public:
         append<RefDec>(temp, lpad);
     }
 
+    /**
+     * \brief Appends a RefDecDeferred instruction to the end of the block.
+     * \param temp the temporary value whose reference count should be decreased
+     */
+    void appendRefDecDeferred(Temp temp) {
+        append<RefDecDeferred>(temp);
+    }
+
     /**
      * \brief Appends a RefDecNoexcept instruction to the end of the block.
      * \param temp the temporary value whose reference count should be decreased
@@ -287,6 +340,13 @@ public:
         append<RefInc>(temp);
     }
 
+    /**
+     * \brief Appends a RefReclaim instruction to the end of the block.
+     */
+    void appendRefReclaim() {
+        append<RefReclaim>();
+    }
+
     /**
      * \brief Appends a ResumeUnwind instruction to the end of the block.
      */
@@ -309,11 +369,31 @@ public:
         append<Ret>(value);
     }
 
+    /**
+     * \brief Sets the source location of the instructions appended from now on.
+     * \param location the source location
+     */
+    void setLocation(SourceLocation location) {
+        this->location = location;
+    }
+
+    /**
+     * \brief Exchanges the instructions of this block with the instructions of another block.
+     *
+     * Allows passes to rewrite the code of a block without changing the identity of the block referenced by jumps
+     * and landing pads.
+     * \param other the other block
+     */
+    void swapInstructions(Block &other) {
+        instructions.swap(other.instructions);
+    }
+
 private:
     template<typename T, typename... Args>
     void append(Args&&... args) {
         assert(!isTerminated());
         instructions.push_back(Instruction::Ptr(new T(std::forward<Args>(args)...)));
+        instructions.back()->location = location;
     }
 
 private:
@@ -324,6 +404,7 @@ private:
 
 private:
     std::vector<Instruction::Ptr> instructions;
+    SourceLocation location;
 };
 
 } // namespace code
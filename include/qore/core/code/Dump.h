@@ -78,8 +78,9 @@ public:
     }
 
     void visit(const Branch &ins) {
-        os << "Branch " << temp(ins.getCondition()) << ", "
-                << block(ins.getTrueDest()) << ", " << block(ins.getFalseDest());
+        std::string falseDest = block(ins.getFalseDest());
+        std::string trueDest = block(ins.getTrueDest());
+        os << "Branch " << temp(ins.getCondition()) << ", " << trueDest << ", " << falseDest;
     }
 
     void visit(const ConstInt &ins) {
@@ -111,6 +112,13 @@ public:
         os << "\"";
     }
 
+    void visit(const ConvertAndBranch &ins) {
+        std::string falseDest = block(ins.getFalseDest());
+        std::string trueDest = block(ins.getTrueDest());
+        os << "ConvertAndBranch " << ins.getConversion().getFunctionName() << " " << temp(ins.getArg()) << ", "
+                << trueDest << ", " << falseDest;
+    }
+
     void visit(const GlobalGet &ins) {
         os << "GlobalGet " << temp(ins.getDest()) << ", " << global(ins.getGlobalVariable());
     }
@@ -119,6 +127,14 @@ public:
         os << "GlobalInit " << global(ins.getGlobalVariable()) << ", " << temp(ins.getInitValue());
     }
 
+    void visit(const GlobalLoad &ins) {
+        os << "GlobalLoad " << temp(ins.getDest()) << ", " << global(ins.getGlobalVariable());
+    }
+
+    void visit(const GlobalLoadRef &ins) {
+        os << "GlobalLoadRef " << temp(ins.getDest()) << ", " << global(ins.getGlobalVariable());
+    }
+
     void visit(const GlobalReadLock &ins) {
         os << "GlobalReadLock " << global(ins.getGlobalVariable());
     }
@@ -165,6 +181,10 @@ public:
         os << "LocalGet " << temp(ins.getDest()) << ", " << local(ins.getLocalVariable());
     }
 
+    void visit(const LocalLoadRef &ins) {
+        os << "LocalLoadRef " << temp(ins.getDest()) << ", " << local(ins.getLocalVariable());
+    }
+
     void visit(const LocalSet &ins) {
         os << "LocalSet " << local(ins.getLocalVariable()) << ", " << temp(ins.getSrc());
     }
@@ -173,6 +193,10 @@ public:
         os << "RefDec " << temp(ins.getTemp());
     }
 
+    void visit(const RefDecDeferred &ins) {
+        os << "RefDecDeferred " << temp(ins.getTemp());
+    }
+
     void visit(const RefDecNoexcept &ins) {
         os << "RefDecNoexcept " << temp(ins.getTemp());
     }
@@ -181,6 +205,10 @@ public:
         os << "RefInc " << temp(ins.getTemp());
     }
 
+    void visit(const RefReclaim &ins) {
+        os << "RefReclaim";
+    }
+
     void visit(const ResumeUnwind &ins) {
         os << "ResumeUnwind";
     }
@@ -198,6 +226,7 @@ public:
     }
 
 private:
+    //numbers are assigned on first use, therefore the order of the calls must not be left to the compiler
     std::string block(const Block &b) {
         Index &i = blockMap[&b];
         if (!i) {
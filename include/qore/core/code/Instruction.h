@@ -32,6 +32,7 @@
 #define INCLUDE_QORE_CORE_CODE_INSTRUCTION_H_
 
 #include <memory>
+#include "qore/core/SourceLocation.h"
 
 namespace qore {
 namespace code {
@@ -40,8 +41,11 @@ class Branch;
 class ConstInt;
 class ConstNothing;
 class ConstString;
+class ConvertAndBranch;
 class GlobalGet;
 class GlobalInit;
+class GlobalLoad;
+class GlobalLoadRef;
 class GlobalReadLock;
 class GlobalReadUnlock;
 class GlobalSet;
@@ -52,10 +56,13 @@ class InvokeConversion;
 class InvokeFunction;
 class Jump;
 class LocalGet;
+class LocalLoadRef;
 class LocalSet;
 class RefDec;
+class RefDecDeferred;
 class RefDecNoexcept;
 class RefInc;
+class RefReclaim;
 class ResumeUnwind;
 class Ret;
 class RetVoid;
@@ -77,8 +84,11 @@ public:
         ConstInt,                   //!< Identifies an instance of \ref ConstInt.
         ConstString,                //!< Identifies an instance of \ref ConstString.
         ConstNothing,               //!< Identifies an instance of \ref ConstNothing.
+        ConvertAndBranch,           //!< Identifies an instance of \ref ConvertAndBranch.
         GlobalGet,                  //!< Identifies an instance of \ref GlobalGet.
         GlobalInit,                 //!< Identifies an instance of \ref GlobalInit.
+        GlobalLoad,                 //!< Identifies an instance of \ref GlobalLoad.
+        GlobalLoadRef,              //!< Identifies an instance of \ref GlobalLoadRef.
         GlobalReadLock,             //!< Identifies an instance of \ref GlobalReadLock.
         GlobalReadUnlock,           //!< Identifies an instance of \ref GlobalReadUnlock.
         GlobalSet,                  //!< Identifies an instance of \ref GlobalSet.
@@ -89,10 +99,13 @@ public:
         InvokeFunction,             //!< Identifies an instance of \ref InvokeFunction.
         Jump,                       //!< Identifies an instance of \ref Jump.
         LocalGet,                   //!< Identifies an instance of \ref LocalGet.
+        LocalLoadRef,               //!< Identifies an instance of \ref LocalLoadRef.
         LocalSet,                   //!< Identifies an instance of \ref LocalSet.
         RefDec,                     //!< Identifies an instance of \ref RefDec.
+        RefDecDeferred,             //!< Identifies an instance of \ref RefDecDeferred.
         RefDecNoexcept,             //!< Identifies an instance of \ref RefDecNoexcept.
         RefInc,                     //!< Identifies an instance of \ref RefInc.
+        RefReclaim,                 //!< Identifies an instance of \ref RefReclaim.
         ResumeUnwind,               //!< Identifies an instance of \ref ResumeUnwind.
         Ret,                        //!< Identifies an instance of \ref Ret.
         RetVoid,                    //!< Identifies an instance of \ref RetVoid.
@@ -115,6 +128,14 @@ public:
         return nullptr;
     }
 
+    /**
+     * \brief Returns the location of the source code the instruction has been generated from.
+     * \return the source location, invalid for instructions not attributable to a statement
+     */
+    const SourceLocation &getLocation() const {
+        return location;
+    }
+
     /**
      * \brief Returns true if this instruction serves as a block terminator.
      * \return true if this instruction serves as a block terminator.
@@ -123,6 +144,7 @@ public:
     bool isTerminator() const {
         switch (getKind()) {
             case Kind::Branch:
+            case Kind::ConvertAndBranch:
             case Kind::Jump:
             case Kind::ResumeUnwind:
             case Kind::Ret:
@@ -149,8 +171,11 @@ public:
             CASE(ConstInt);
             CASE(ConstNothing);
             CASE(ConstString);
+            CASE(ConvertAndBranch);
             CASE(GlobalGet);
             CASE(GlobalInit);
+            CASE(GlobalLoad);
+            CASE(GlobalLoadRef);
             CASE(GlobalReadLock);
             CASE(GlobalReadUnlock);
             CASE(GlobalSet);
@@ -161,10 +186,13 @@ public:
             CASE(InvokeFunction);
             CASE(Jump);
             CASE(LocalGet);
+            CASE(LocalLoadRef);
             CASE(LocalSet);
             CASE(RefDec);
+            CASE(RefDecDeferred);
             CASE(RefDecNoexcept);
             CASE(RefInc);
+            CASE(RefReclaim);
             CASE(ResumeUnwind);
             CASE(Ret);
             CASE(RetVoid);
@@ -186,6 +214,11 @@ private:
     Instruction(Instruction &&) = delete;
     Instruction &operator=(const Instruction &) = delete;
     Instruction &operator=(Instruction &&) = delete;
+
+private:
+    SourceLocation location;
+
+    friend class Block;
 };
 
 } // namespace code
@@ -32,6 +32,7 @@
 #define INCLUDE_QORE_CORE_CODE_INVOKEBINARYOPERATOR_H_
 
 #include "qore/core/BinaryOperator.h"
+#include "qore/core/InlineCache.h"
 #include "qore/core/code/Instruction.h"
 #include "qore/core/code/Temp.h"
 
@@ -96,12 +97,23 @@ public:
         return right;
     }
 
+    /**
+     * \brief Returns the inline cache of this instruction.
+     *
+     * The cache is only used if the binary operator is dynamic. It is mutable since it is updated by the execution.
+     * \return the inline cache of this instruction
+     */
+    BinaryOperatorCache &getCache() const {
+        return cache;
+    }
+
 private:
     Temp dest;
     const BinaryOperator &op;
     Temp left;
     Temp right;
     const Block *lpad;
+    mutable BinaryOperatorCache cache;
 };
 
 } // namespace code
@@ -32,6 +32,7 @@
 #define INCLUDE_QORE_CORE_CODE_INVOKECONVERSION_H_
 
 #include "qore/core/Conversion.h"
+#include "qore/core/InlineCache.h"
 #include "qore/core/code/Instruction.h"
 #include "qore/core/code/Temp.h"
 
@@ -87,11 +88,22 @@ public:
         return arg;
     }
 
+    /**
+     * \brief Returns the inline cache of this instruction.
+     *
+     * The cache is only used if the conversion is dynamic. It is mutable since it is updated by the execution.
+     * \return the inline cache of this instruction
+     */
+    ConversionCache &getCache() const {
+        return cache;
+    }
+
 private:
     Temp dest;
     const Conversion &conversion;
     Temp arg;
     const Block *lpad;
+    mutable ConversionCache cache;
 };
 
 } // namespace code
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Liveness analysis of temporaries.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CORE_CODE_LIVENESS_H_
+#define INCLUDE_QORE_CORE_CODE_LIVENESS_H_
+
+#include <unordered_map>
+#include <vector>
+#include "qore/core/Function.h"
+
+namespace qore {
+namespace code {
+
+/**
+ * \brief Computes the sets of temporaries that are live at the boundaries of the basic blocks of a function.
+ *
+ * A temporary is live at a point of the code if its value may be read on some path starting at that point before it
+ * is overwritten. Besides the jumps and branches, the control flow graph also contains an edge from each instruction
+ * with a landing pad to the first instruction of the landing pad, i.e. all temporaries live at the beginning of a
+ * landing pad are live before the instruction that may throw.
+ */
+class Liveness {
+
+public:
+    using Set = std::vector<bool>;          //!< Set of temporaries indexed by \ref Temp::getIndex().
+
+public:
+    /**
+     * \brief Analyzes the code of a function.
+     * \param f the function to analyze
+     */
+    explicit Liveness(const Function &f);
+
+    /**
+     * \brief Returns the set of temporaries live at the beginning of a block.
+     * \param b the block, must belong to the analyzed function
+     * \return the set of temporaries live at the beginning of the block
+     */
+    const Set &getLiveIn(const Block &b) const {
+        return liveIn[indexOf(b)];
+    }
+
+    /**
+     * \brief Returns the set of temporaries live at the end of a block.
+     * \param b the block, must belong to the analyzed function
+     * \return the set of temporaries live at the end of the block
+     */
+    const Set &getLiveOut(const Block &b) const {
+        return liveOut[indexOf(b)];
+    }
+
+    /**
+     * \brief Returns, for each instruction of a block, the temporaries whose storage is in use by the instruction.
+     *
+     * These are the temporaries live before the instruction and the temporaries the instruction writes to. Two
+     * temporaries may share a slot only if no instruction uses both.
+     * \param b the block, must belong to the analyzed function
+     * \return a set of temporaries for each instruction of the block
+     */
+    std::vector<Set> getOccupied(const Block &b) const;
+
+    /**
+     * \brief Collects the temporaries read and written by an instruction.
+     * \param ins the instruction
+     * \param uses receives the temporaries read by the instruction
+     * \param defs receives the temporaries written by the instruction
+     */
+    static void getAccess(const Instruction &ins, std::vector<Temp> &uses, std::vector<Temp> &defs);
+
+private:
+    Index indexOf(const Block &b) const {
+        auto it = blockIndex.find(&b);
+        assert(it != blockIndex.end());
+        return it->second;
+    }
+
+    Set transfer(const Block &b, const Set &out, std::vector<Set> *occupied) const;
+
+private:
+    Size tempCount;
+    std::vector<const Block *> blocks;
+    std::unordered_map<const Block *, Index> blockIndex;
+    std::vector<Set> liveIn;
+    std::vector<Set> liveOut;
+};
+
+} // namespace code
+} // namespace qore
+
+#endif // INCLUDE_QORE_CORE_CODE_LIVENESS_H_
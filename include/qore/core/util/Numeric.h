@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Conversions between numbers and their textual representation.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_CORE_UTIL_NUMERIC_H_
+#define INCLUDE_QORE_CORE_UTIL_NUMERIC_H_
+
+#include <string>
+#include "qore/core/Defs.h"
+#include "qore/core/Value.h"
+
+namespace qore {
+namespace util {
+
+/**
+ * \brief Parses an integer from a string.
+ *
+ * The conversion follows these rules:
+ *   - leading whitespace is skipped,
+ *   - an optional sign (`+` or `-`) follows,
+ *   - if the digits are prefixed with `0x` or `0X`, they are interpreted as hexadecimal,
+ *   - parsing stops at the first character that is not a digit, the rest of the string is ignored,
+ *   - if there are no digits, the result is 0,
+ *   - values out of range of \ref qint saturate to the minimum or maximum value.
+ *
+ * Does not allocate memory and does not depend on the locale.
+ * \param begin the pointer to the first character
+ * \param end the pointer past the last character
+ * \return the parsed value
+ */
+qint parseInt(const char *begin, const char *end) noexcept;
+
+/**
+ * \brief Parses an integer from a string.
+ * \param str the string to parse
+ * \return the parsed value
+ * \see parseInt(const char *, const char *)
+ */
+inline qint parseInt(const std::string &str) noexcept {
+    return parseInt(str.data(), str.data() + str.size());
+}
+
+/**
+ * \brief The maximum number of characters produced by formatInt().
+ */
+constexpr Size MaxIntLength = 20;
+
+/**
+ * \brief Returns the number of characters formatInt() produces for given value.
+ * \param value the value to format
+ * \return the number of characters including the sign
+ */
+Size intLength(qint value) noexcept;
+
+/**
+ * \brief Formats an integer as a decimal number.
+ *
+ * Produces two digits per step using a lookup table. The output is not terminated by a null character.
+ * \param value the value to format
+ * \param buffer the output buffer, must have room for at least \ref MaxIntLength characters
+ * \return the number of characters written
+ */
+Size formatInt(qint value, char *buffer) noexcept;
+
+} // namespace util
+} // namespace qore
+
+#endif // INCLUDE_QORE_CORE_UTIL_NUMERIC_H_
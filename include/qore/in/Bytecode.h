@@ -0,0 +1,350 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the compact bytecode executed by the interpreter.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_IN_BYTECODE_H_
+#define INCLUDE_QORE_IN_BYTECODE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "qore/core/Function.h"
+#include "qore/core/GlobalVariable.h"
+#include "qore/core/InlineCache.h"
+#include "qore/core/String.h"
+
+namespace qore {
+namespace in {
+
+class Program;
+class Tiering;
+
+/**
+ * \brief Flat representation of the code of a function suitable for fast interpretation.
+ *
+ * The code is a contiguous array of \ref Word "words". Each instruction occupies one word with its opcode
+ * followed by its operands: indexes of temporaries and local variables, constants, pointers to resolved runtime
+ * objects and jump offsets relative to the start of the instruction. When the compiler supports it, the opcode
+ * words hold the addresses of the interpreter's handlers directly (direct threading).
+ *
+ * Landing pads are described by a separate table of \ref Handler "handlers" instead of guarding each instruction.
+ *
+ * When the bytecode belongs to a \ref Program with \ref Tiering, it counts its calls and back-edges and may be
+ * promoted to native code, see getNativeCode().
+ */
+class Bytecode {
+
+public:
+    using Ptr = std::unique_ptr<Bytecode>;          //!< Pointer type.
+
+    /**
+     * \brief Enumeration of bytecode instructions.
+     */
+    enum class Opcode {
+        Branch,                     //!< `cond, trueOffset, falseOffset`
+        ConstInt,                   //!< `dest, value`
+        ConstNothing,               //!< `dest`
+        ConstString,                //!< `dest, string`
+        ConvertAndBranch,           //!< `conversion, arg, trueOffset, falseOffset`
+        GlobalGet,                  //!< `dest, global`
+        GlobalInit,                 //!< `global, src`
+        GlobalLoad,                 //!< `dest, global`
+        GlobalLoadRef,              //!< `dest, global`
+        GlobalReadLock,             //!< `global`
+        GlobalReadUnlock,           //!< `global`
+        GlobalSet,                  //!< `global, src`
+        GlobalWriteLock,            //!< `global`
+        GlobalWriteUnlock,          //!< `global`
+        InvokeBinaryOperator,       //!< `dest, binaryOperator, left, right`
+        InvokeBinaryOperatorCached, //!< `dest, binaryOperatorCache, binaryOperatorKind, left, right`
+        InvokeConversion,           //!< `dest, conversion, arg`
+        InvokeConversionCached,     //!< `dest, conversionCache, type, arg`
+        InvokeFunction,             //!< `dest, function, argCount, args...`
+        Jump,                       //!< `offset`
+        JumpBack,                   //!< `offset` (a jump to a lower or the same offset, counted as a back-edge)
+        LocalGet,                   //!< `dest, local`
+        LocalLoadRef,               //!< `dest, local`
+        LocalSet,                   //!< `local, src`
+        RefDec,                     //!< `temp`
+        RefDecDeferred,             //!< `temp`
+        RefDecNoexcept,             //!< `temp`
+        RefInc,                     //!< `temp`
+        RefReclaim,                 //!< no operands
+        ResumeUnwind,               //!< no operands
+        Ret,                        //!< `value`
+        RetVoid,                    //!< no operands
+    };
+
+    static constexpr int OpcodeCount = static_cast<int>(Opcode::RetVoid) + 1;   //!< The number of opcodes.
+
+    /**
+     * \brief One word of the bytecode.
+     */
+    union Word {
+        const void *handler;                        //!< The address of the handler (direct threading).
+        Opcode opcode;                              //!< The opcode (switch-based dispatch).
+        Index index;                                //!< The index of a temporary or a local variable.
+        std::ptrdiff_t offset;                      //!< A jump offset relative to the start of the instruction.
+        Size count;                                 //!< The number of arguments.
+        qint value;                                 //!< An integer constant.
+        String *string;                             //!< A string constant.
+        GlobalVariable *global;                     //!< A global variable.
+        BinaryOperator::Function *binaryOperator;   //!< The implementation of a binary operator.
+        BinaryOperatorCache *binaryOperatorCache;   //!< The inline cache of a dynamic binary operator.
+        BinaryOperator::Kind binaryOperatorKind;    //!< The kind of a dynamic binary operator.
+        Conversion::Function *conversion;           //!< The implementation of a conversion.
+        ConversionCache *conversionCache;           //!< The inline cache of a dynamic conversion.
+        const Type *type;                           //!< The destination type of a dynamic conversion.
+        const Bytecode *function;                   //!< The bytecode of a called function.
+    };
+
+    /**
+     * \brief Describes a range of instructions protected by a landing pad.
+     */
+    struct Handler {
+        Index begin;                //!< The offset of the first protected instruction.
+        Index end;                  //!< The offset past the last protected instruction.
+        Index lpad;                 //!< The offset of the first instruction of the landing pad.
+    };
+
+public:
+    using Resolver = std::function<const Bytecode &(const Function &)>;    //!< Resolves called functions.
+
+    /**
+     * \brief The entry point of native code of a promoted function.
+     *
+     * Receives the values of the arguments and returns the return value (null for functions returning nothing).
+     * The arguments may live on the \ref Stack, so they must be read before the native code calls any function.
+     */
+    using NativeCode = qvalue (*)(const qvalue *args);
+
+public:
+    /**
+     * \brief Creates an empty bytecode, see lower().
+     */
+    Bytecode() : tempCount(0), localCount(0), callCount(0), backEdgeCount(0), nativeCode(nullptr),
+            promoting(false), function(nullptr), program(nullptr), callThreshold(0), backEdgeThreshold(0) {
+    }
+
+    /**
+     * \brief Lowers a graph of basic blocks to bytecode.
+     *
+     * Must be called exactly once before the bytecode is executed.
+     * \param entryBlock the entry block of the function
+     * \param tempCount the number of temporaries used by the code
+     * \param localCount the number of local variables used by the code
+     * \param resolver returns the bytecode of a function called by the code; the result may be still empty
+     * (e.g. in case of recursion) as long as it is lowered before it is executed
+     */
+    void lower(const code::Block &entryBlock, Size tempCount, Size localCount, const Resolver &resolver);
+
+    /**
+     * \brief Executes the bytecode on the stack of the current thread.
+     *
+     * Calls of other functions are executed by the same loop without recursion, see \ref Stack. If the function
+     * has been promoted to native code, the native code is executed instead.
+     * \param args the values of the arguments, stored to the first local variables
+     * \param argCount the number of arguments
+     * \return the return value
+     * \throws Exception if an exception is not handled by the bytecode
+     * \throws StackOverflowException if the maximum depth of the stack is exceeded
+     */
+    qvalue call(const qvalue *args, Size argCount) const;
+
+    /**
+     * \brief Returns the words of the bytecode.
+     * \return the words of the bytecode
+     */
+    const std::vector<Word> &getCode() const {
+        return code;
+    }
+
+    /**
+     * \brief Returns the table of landing pads ordered by the offsets of protected ranges.
+     * \return the table of landing pads
+     */
+    const std::vector<Handler> &getHandlers() const {
+        return handlers;
+    }
+
+    /**
+     * \brief Returns the number of temporaries needed for executing the bytecode.
+     * \return the number of temporaries
+     */
+    Size getTempCount() const {
+        return tempCount;
+    }
+
+    /**
+     * \brief Returns the number of local variables needed for executing the bytecode.
+     * \return the number of local variables
+     */
+    Size getLocalCount() const {
+        return localCount;
+    }
+
+    /**
+     * \brief Returns the number of values in the stack window of an activation.
+     * \return the number of local variables and temporaries
+     */
+    Size getFrameSize() const {
+        return localCount + tempCount;
+    }
+
+    /**
+     * \brief Returns the native code of the function if it has been promoted.
+     * \return the entry point of the native code or `nullptr` if the function is interpreted
+     */
+    NativeCode getNativeCode() const {
+        return nativeCode.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Returns the number of calls counted while the function was interpreted.
+     *
+     * Calls are counted only when tiering is enabled. The counters are updated without synchronization, so calls
+     * from concurrent threads may be lost.
+     * \return the number of calls
+     */
+    Size getCallCount() const {
+        return callCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the number of back-edges counted while the function was interpreted.
+     *
+     * Back-edges are the unconditional jumps to a lower or the same offset which close loops, conditional branches
+     * are not counted.
+     * \return the number of back-edges
+     * \see getCallCount()
+     */
+    Size getBackEdgeCount() const {
+        return backEdgeCount.load(std::memory_order_relaxed);
+    }
+
+    ///\cond
+    //called by the interpreter, return true when the threshold has been reached
+    bool countCall() const {
+        Size count = callCount.load(std::memory_order_relaxed) + 1;
+        callCount.store(count, std::memory_order_relaxed);
+        return count == callThreshold;
+    }
+
+    bool countBackEdge() const {
+        Size count = backEdgeCount.load(std::memory_order_relaxed) + 1;
+        backEdgeCount.store(count, std::memory_order_relaxed);
+        return count == backEdgeThreshold;
+    }
+
+    NativeCode promote() const;
+    ///\endcond
+
+private:
+    static const void *const *getDispatchTable();
+    void enableTiering(const Function &f, Program &program);
+
+private:
+    Bytecode(const Bytecode &) = delete;
+    Bytecode(Bytecode &&) = delete;
+    Bytecode &operator=(const Bytecode &) = delete;
+    Bytecode &operator=(Bytecode &&) = delete;
+
+private:
+    std::vector<Word> code;
+    std::vector<Handler> handlers;
+    Size tempCount;
+    Size localCount;
+    mutable std::atomic<Size> callCount;
+    mutable std::atomic<Size> backEdgeCount;
+    mutable std::atomic<NativeCode> nativeCode;
+    mutable std::atomic<bool> promoting;
+    const Function *function;
+    Program *program;
+    Size callThreshold;
+    Size backEdgeThreshold;
+
+    friend class BytecodeBuilder;
+    friend class Program;
+};
+
+/**
+ * \brief A set of functions lowered to bytecode.
+ *
+ * Functions are lowered on first use, together with all functions they call.
+ */
+class Program {
+
+public:
+    /**
+     * \brief Constructor.
+     * \param tiering if not `nullptr`, hot functions of the program are promoted to native code, see \ref Tiering
+     */
+    explicit Program(Tiering *tiering = nullptr) : tiering(tiering) {
+    }
+
+    /**
+     * \brief Returns the bytecode of a function, lowering it if needed.
+     * \param f the function
+     * \return the bytecode of the function
+     */
+    const Bytecode &getBytecode(const Function &f);
+
+    /**
+     * \brief Executes a function with no arguments on the stack of the current thread.
+     * \param f the function to execute
+     * \return the return value of the function
+     */
+    qvalue run(const Function &f);
+
+    /**
+     * \brief Returns the tiering of the program.
+     * \return the tiering or `nullptr` if all functions are interpreted
+     */
+    Tiering *getTiering() const {
+        return tiering;
+    }
+
+private:
+    Program(const Program &) = delete;
+    Program(Program &&) = delete;
+    Program &operator=(const Program &) = delete;
+    Program &operator=(Program &&) = delete;
+
+private:
+    std::unordered_map<const Function *, Bytecode::Ptr> functions;
+    Tiering *tiering;
+};
+
+} // namespace in
+} // namespace qore
+
+#endif // INCLUDE_QORE_IN_BYTECODE_H_
@@ -120,6 +120,14 @@ public:
         setTemp(ins.getDest(), v);
     }
 
+    void visit(const code::ConvertAndBranch &ins) {
+        if (ins.getConversion().getFunction()(getTemp(ins.getArg())).b) {
+            it = ins.getTrueDest().begin();
+        } else {
+            it = ins.getFalseDest().begin();
+        }
+    }
+
     void visit(const code::GlobalGet &ins) {
         setTemp(ins.getDest(), ins.getGlobalVariable().getValue());
     }
@@ -128,6 +136,24 @@ public:
         ins.getGlobalVariable().initValue(getTemp(ins.getInitValue()));
     }
 
+    void visit(const code::GlobalLoad &ins) {
+        GlobalVariable &gv = ins.getGlobalVariable();
+        gv.readLock();
+        setTemp(ins.getDest(), gv.getValue());
+        gv.readUnlock();
+    }
+
+    void visit(const code::GlobalLoadRef &ins) {
+        GlobalVariable &gv = ins.getGlobalVariable();
+        gv.readLock();
+        qvalue v = gv.getValue();
+        if (v.isHeapObject()) {
+            v.p->incRefCount();
+        }
+        gv.readUnlock();
+        setTemp(ins.getDest(), v);
+    }
+
     void visit(const code::GlobalReadLock &ins) {
         ins.getGlobalVariable().readLock();
     }
@@ -149,11 +175,22 @@ public:
     }
 
     void visit(const code::InvokeBinaryOperator &ins) {
-        setTemp(ins.getDest(), ins.getOperator().getFunction()(getTemp(ins.getLeft()), getTemp(ins.getRight())));
+        const BinaryOperator &op = ins.getOperator();
+        if (op.isDynamic()) {
+            setTemp(ins.getDest(), ins.getCache().invoke(op.getKind(), getTemp(ins.getLeft()),
+                    getTemp(ins.getRight())));
+        } else {
+            setTemp(ins.getDest(), op.getFunction()(getTemp(ins.getLeft()), getTemp(ins.getRight())));
+        }
     }
 
     void visit(const code::InvokeConversion &ins) {
-        setTemp(ins.getDest(), ins.getConversion().getFunction()(getTemp(ins.getArg())));
+        const Conversion &conversion = ins.getConversion();
+        if (conversion.isDynamic()) {
+            setTemp(ins.getDest(), ins.getCache().invoke(conversion.getToType(), getTemp(ins.getArg())));
+        } else {
+            setTemp(ins.getDest(), conversion.getFunction()(getTemp(ins.getArg())));
+        }
     }
 
     void visit(const code::InvokeFunction &ins) {
@@ -175,25 +212,44 @@ public:
         setTemp(ins.getDest(), getLocal(ins.getLocalVariable()));
     }
 
+    void visit(const code::LocalLoadRef &ins) {
+        qvalue v = getLocal(ins.getLocalVariable());
+        if (v.isHeapObject()) {
+            v.p->incRefCount();
+        }
+        setTemp(ins.getDest(), v);
+    }
+
     void visit(const code::LocalSet &ins) {
         setLocal(ins.getLocalVariable(), getTemp(ins.getSrc()));
     }
 
     void visit(const code::RefDec &ins) {
         qvalue v = getTemp(ins.getTemp());
-        if (v.p) {
+        if (v.isHeapObject()) {
             v.p->decRefCount();
             //FIXME if an exception was created, throw it
         }
     }
 
+    void visit(const code::RefDecDeferred &ins) {
+        qvalue v = getTemp(ins.getTemp());
+        if (v.isHeapObject()) {
+            v.p->decRefCountDeferred();
+        }
+    }
+
     void visit(const code::RefInc &ins) {
         qvalue v = getTemp(ins.getTemp());
-        if (v.p) {
+        if (v.isHeapObject()) {
             v.p->incRefCount();
         }
     }
 
+    void visit(const code::RefReclaim &ins) {
+        RefCounted::reclaimDeferred();
+    }
+
     void visit(const code::Ret &ins) {
         frame.returnValue = getTemp(ins.getValue());
         done = true;
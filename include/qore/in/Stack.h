@@ -0,0 +1,228 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the value stack used by the bytecode interpreter.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_IN_STACK_H_
+#define INCLUDE_QORE_IN_STACK_H_
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+#include "qore/core/Defs.h"
+#include "qore/core/Exception.h"
+#include "qore/core/Value.h"
+
+namespace qore {
+namespace in {
+
+class Bytecode;
+
+/**
+ * \brief A contiguous stack of values shared by all activations of interpreted functions in one thread.
+ *
+ * Each activation occupies a window of the stack holding its local variables followed by its temporaries. The
+ * window of a callee starts right after the window of its caller, and the caller stores the arguments directly to
+ * the first local slots of the callee. Calls and returns only move the top of the stack, memory is allocated only
+ * when the stack grows beyond its previous maximum size.
+ *
+ * The stack may be reallocated when a new window is entered, so the interpreter addresses windows by their index
+ * and reloads pointers after each call.
+ */
+class Stack {
+
+public:
+    static constexpr Size DefaultMaxDepth = 100000; //!< The default maximum number of nested activations.
+
+    /**
+     * \brief Remembers the state of the caller during a call.
+     */
+    struct Activation {
+        const Bytecode *bytecode;                   //!< The bytecode of the caller.
+        Index pc;                                   //!< The offset of the call instruction in the caller.
+        Index base;                                 //!< The index of the caller's window.
+        std::exception_ptr exception;               //!< The exception being handled by the caller.
+    };
+
+public:
+    /**
+     * \brief Constructor.
+     * \param maxDepth the maximum number of nested activations
+     */
+    explicit Stack(Size maxDepth = DefaultMaxDepth) : top(0), depth(0), maxDepth(maxDepth) {
+    }
+
+    /**
+     * \brief Returns the stack of the current thread.
+     * \return the stack of the current thread
+     */
+    static Stack &getCurrent();
+
+    /**
+     * \brief Returns the maximum number of nested activations.
+     * \return the maximum number of nested activations
+     */
+    Size getMaxDepth() const {
+        return maxDepth;
+    }
+
+    /**
+     * \brief Sets the maximum number of nested activations.
+     *
+     * Entering an activation beyond this limit throws StackOverflowException which can be handled by the script.
+     * \param maxDepth the maximum number of nested activations
+     */
+    void setMaxDepth(Size maxDepth) {
+        this->maxDepth = maxDepth;
+    }
+
+    /**
+     * \brief Returns the number of activations currently on the stack.
+     * \return the number of activations currently on the stack
+     */
+    Size getDepth() const {
+        return depth;
+    }
+
+    /**
+     * \brief Returns the index of the first unused value.
+     * \return the index of the first unused value
+     */
+    Index getTop() const {
+        return top;
+    }
+
+    /**
+     * \brief Returns a pointer to the value at given index.
+     *
+     * The pointer is invalidated by enter().
+     * \param index the index of the value
+     * \return a pointer to the value
+     */
+    qvalue *at(Index index) {
+        return values.data() + index;
+    }
+
+    /**
+     * \brief Enters a new activation by allocating a window of zeroed values on the top of the stack.
+     * \param size the number of values in the window
+     * \return the index of the window
+     * \throws StackOverflowException if the maximum depth has been reached
+     */
+    Index enter(Size size) {
+        if (depth == maxDepth) {
+            throw StackOverflowException();
+        }
+        if (top + size > values.size()) {
+            grow(top + size);
+        }
+        Index base = top;
+        qvalue zero;
+        zero.i = 0;
+        std::fill(values.begin() + base, values.begin() + base + size, zero);
+        top += size;
+        ++depth;
+        return base;
+    }
+
+    /**
+     * \brief Leaves the activation on the top of the stack.
+     * \param base the index of the window of the activation as returned by enter()
+     */
+    void leave(Index base) {
+        top = base;
+        --depth;
+    }
+
+    /**
+     * \brief Discards activations entered after the one that has given window and depth.
+     *
+     * Used when an exception unwinds nested activations.
+     * \param end the index past the end of the window of the surviving activation
+     * \param depth the depth of the surviving activation
+     */
+    void unwindTo(Index end, Size depth) {
+        top = end;
+        this->depth = depth;
+    }
+
+    /**
+     * \brief Discards an activation together with all activations entered after it and their caller records.
+     *
+     * Used when an exception that is not handled by landing pads leaves the interpreter.
+     * \param base the index of the window of the activation as returned by enter()
+     * \param depth the depth of the activation, i.e. the value of getDepth() right after it was entered
+     */
+    void discard(Index base, Size depth) {
+        activations.resize(activations.size() - (this->depth - depth));
+        top = base;
+        this->depth = depth - 1;
+    }
+
+    /**
+     * \brief Records the state of a caller.
+     * \param bytecode the bytecode of the caller
+     * \param pc the offset of the call instruction
+     * \param base the index of the caller's window
+     * \param exception the exception being handled by the caller
+     */
+    void pushActivation(const Bytecode *bytecode, Index pc, Index base, std::exception_ptr exception) {
+        activations.push_back(Activation{bytecode, pc, base, std::move(exception)});
+    }
+
+    /**
+     * \brief Removes the record of the most recent caller.
+     * \return the record of the caller
+     */
+    Activation popActivation() {
+        Activation a = std::move(activations.back());
+        activations.pop_back();
+        return a;
+    }
+
+private:
+    void grow(Size minSize);
+
+private:
+    Stack(const Stack &) = delete;
+    Stack(Stack &&) = delete;
+    Stack &operator=(const Stack &) = delete;
+    Stack &operator=(Stack &&) = delete;
+
+private:
+    std::vector<qvalue> values;
+    std::vector<Activation> activations;
+    Index top;
+    Size depth;
+    Size maxDepth;
+};
+
+} // namespace in
+} // namespace qore
+
+#endif // INCLUDE_QORE_IN_STACK_H_
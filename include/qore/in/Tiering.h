@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the promotion of hot functions from the bytecode interpreter to native code.
+///
+//------------------------------------------------------------------------------
+#ifndef INCLUDE_QORE_IN_TIERING_H_
+#define INCLUDE_QORE_IN_TIERING_H_
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "qore/in/Bytecode.h"
+
+namespace qore {
+namespace in {
+
+/**
+ * \brief Promotes frequently executed functions from the bytecode interpreter to native code.
+ *
+ * Each \ref Bytecode of a \ref Program using tiering counts its calls and the jumps back to already executed code
+ * (back-edges). When either counter reaches its threshold, the function is passed to the compiler and if the
+ * compilation succeeds, the entry point of the bytecode is switched to the native code. All later calls, both from
+ * the interpreter and from other native code (which calls functions through invoke()), execute the native code.
+ *
+ * There is no on-stack replacement: an activation which has triggered the promotion from a loop finishes in the
+ * interpreter. A function is compiled at most once, if the compilation fails, it stays interpreted.
+ */
+class Tiering {
+
+public:
+    /**
+     * \brief Compiles a function of a program to native code.
+     *
+     * The native code calls other functions of the program through invoke() with their bytecode as returned by
+     * Program::getBytecode(). Returns `nullptr` if the function cannot be compiled.
+     */
+    using Compiler = std::function<Bytecode::NativeCode(const Function &, Program &)>;
+
+    /**
+     * \brief Thresholds of the promotion.
+     */
+    struct Options {
+        Size callThreshold;         //!< The number of calls after which a function is promoted, 0 to disable.
+        Size backEdgeThreshold;     //!< The number of back-edges after which a function is promoted, 0 to disable.
+
+        /**
+         * \brief Creates the default options.
+         */
+        Options() : callThreshold(1000), backEdgeThreshold(10000) {
+        }
+    };
+
+    /**
+     * \brief Statistics of the promotions.
+     */
+    struct Stats {
+        Size promotions;                            //!< The number of successfully compiled functions.
+        Size failures;                              //!< The number of functions the compiler has rejected.
+        std::vector<const Function *> promoted;     //!< The promoted functions in the order of promotion.
+
+        /**
+         * \brief Creates empty statistics.
+         */
+        Stats() : promotions(0), failures(0) {
+        }
+    };
+
+public:
+    /**
+     * \brief Constructor.
+     * \param compiler the compiler of hot functions
+     * \param options the thresholds of the promotion
+     */
+    explicit Tiering(Compiler compiler, Options options = Options())
+            : compiler(std::move(compiler)), options(options) {
+    }
+
+    /**
+     * \brief Returns the thresholds of the promotion.
+     * \return the thresholds of the promotion
+     */
+    const Options &getOptions() const {
+        return options;
+    }
+
+    /**
+     * \brief Returns a snapshot of the statistics of the promotions.
+     * \return the statistics of the promotions
+     */
+    Stats getStats() const;
+
+    /**
+     * \brief Calls a function from native code in whichever tier currently executes it.
+     *
+     * Native code compiled for tiering calls other functions through this trampoline.
+     * \param bytecode the bytecode of the called function as returned by Program::getBytecode()
+     * \param args the values of the arguments
+     * \param argCount the number of arguments
+     * \return the return value
+     * \throws Exception if the called function throws an exception
+     */
+    static qvalue invoke(const void *bytecode, const qvalue *args, Size argCount);
+
+private:
+    Bytecode::NativeCode compile(const Function &f, Program &program);
+
+private:
+    Tiering(const Tiering &) = delete;
+    Tiering(Tiering &&) = delete;
+    Tiering &operator=(const Tiering &) = delete;
+    Tiering &operator=(Tiering &&) = delete;
+
+private:
+    Compiler compiler;
+    Options options;
+    Stats stats;
+    mutable std::mutex mutex;
+
+    friend class Bytecode;
+};
+
+} // namespace in
+} // namespace qore
+
+#endif // INCLUDE_QORE_IN_TIERING_H_
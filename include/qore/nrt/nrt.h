@@ -31,6 +31,7 @@
 #ifndef INCLUDE_QORE_NRT_NRT_H_
 #define INCLUDE_QORE_NRT_NRT_H_
 
+#include "qore/core/InlineCache.h"
 #include "qore/core/Value.h"
 
 namespace qore {
@@ -47,64 +48,82 @@ class Type;
  */
 namespace nrt {
 
-///\name Wrappers for Env methods
+///\name Constant tables describing an environment
 ///\{
 /**
- * \brief Wraps the \ref Env::getRootNamespace() method.
- * \param env `this` for the method invocation
- * \return the root namespace
+ * \brief Describes a string literal.
  */
-extern "C" Namespace *env_getRootNamespace(Env *env);
+struct StringEntry {
+    const char *value;          //!< The value of the string, not necessarily terminated by '\0'.
+    qint length;                //!< The length of the value.
+    qvalue *slot;               //!< Receives the string created by env_load().
+};
 
 /**
- * \brief Wraps the ref Env::addSourceInfo() method.
- * \param env `this` for the method invocation
- * \param name the name of the source
- * \return created \ref SourceInfo instance
+ * \brief Describes a namespace, parents precede their children.
  */
-extern "C" SourceInfo *env_addSourceInfo(Env *env, const char *name);
+struct NamespaceEntry {
+    const char *name;           //!< The name of the namespace (without the name of the parent).
+    int parent;                 //!< The index of the parent namespace or -1 for the root namespace.
+    int sourceInfo;             //!< The index of the source info of the location.
+    int location;               //!< The encoded location.
+};
 
 /**
- * \brief Wraps the ref Env::addString() method.
- * \param env `this` for the method invocation
- * \param str the value of the string literal
- * \return created \ref String instance
+ * \brief Describes a global variable.
  */
-extern "C" qvalue env_addString(Env *env, const char *str);
-///\}
+struct GlobalVariableEntry {
+    const char *name;           //!< The name of the global variable (without the name of the namespace).
+    int ns;                     //!< The index of the namespace or -1 for the root namespace.
+    int sourceInfo;             //!< The index of the source info of the location.
+    int location;               //!< The encoded location.
+    const Type *(*type)();      //!< Returns the type of the global variable.
+    GlobalVariable **slot;      //!< Receives the global variable created by env_load().
+};
 
-///\name Wrappers for Namespace methods
-///\{
 /**
- * \brief Wraps the \ref Namespace::addNamespace() method.
- * \param ns `this` for the method invocation
- * \param name the name of the new namespace
- * \param sourceInfo identifies the script
- * \param location encoded location
- * \return the new namespace
+ * \brief Describes a function group.
  */
-extern "C" Namespace *namespace_addNamespace(Namespace *ns, const char *name,
-        SourceInfo *sourceInfo, int location);
+struct FunctionGroupEntry {
+    const char *name;           //!< The name of the function group (without the name of the namespace).
+    int ns;                     //!< The index of the namespace or -1 for the root namespace.
+};
 
 /**
- * \brief Wraps the \ref Namespace::addFunctionGroup() method.
- * \param ns `this` for the method invocation
- * \param name the name of the new function group
- * \return the new function group
+ * \brief Constant tables describing the contents of an environment, emitted by the code generator.
  */
-extern "C" FunctionGroup *namespace_addFunctionGroup(Namespace *ns, const char *name);
+struct EnvTable {
+    const char *const *sourceInfos;                 //!< The names of the source infos.
+    int sourceInfoCount;                            //!< The number of source infos.
+    const StringEntry *strings;                     //!< The string literals.
+    int stringCount;                                //!< The number of string literals.
+    const NamespaceEntry *namespaces;               //!< The namespaces except the root namespace.
+    int namespaceCount;                             //!< The number of namespaces.
+    const GlobalVariableEntry *globalVariables;     //!< The global variables.
+    int globalVariableCount;                        //!< The number of global variables.
+    const FunctionGroupEntry *functionGroups;       //!< The function groups.
+    int functionGroupCount;                         //!< The number of function groups.
+};
+///\}
 
+///\name Wrappers for Env methods
+///\{
 /**
- * \brief Wraps the \ref Namespace::addGlobalVariable() method.
- * \param ns `this` for the method invocation
- * \param name the name of the global variable
- * \param type the type of the global variable
- * \param sourceInfo identifies the script
- * \param location encoded location
- * \return the new global variable
+ * \brief Creates the source infos, string literals, namespaces, global variables and function groups described by
+ * constant tables.
+ *
+ * Replaces a sequence of calls of the individual methods of Env and Namespace so that the code which initializes an
+ * environment does not grow with the size of the program. The pointers to the created strings and global variables
+ * are stored in the slots given by the tables.
+ *
+ * The objects are allocated here rather than adopted from the tables. In particular, string literals are not
+ * constant-initialized String objects in read-only data: a String owns a std::string, has a vtable and a mutable
+ * reference count and may cache its integer value, none of which can live in read-only memory. This is a deliberate
+ * limitation, literals are instead made immortal by Env::addString() so that no reference counting is needed.
+ * \param env the environment to populate
+ * \param table the description of the contents of the environment
  */
-extern "C" GlobalVariable *namespace_addGlobalVariable(Namespace *ns, const char *name, const Type *type,
-        SourceInfo *sourceInfo, int location);
+extern "C" void env_load(Env *env, const EnvTable *table);
 ///\}
 
 ///\name Wrappers for GlobalVariable methods
@@ -161,28 +180,79 @@ extern "C" void globalVariable_writeUnlock(GlobalVariable *gv);
  * \brief Returns \ref Type::String.
  * \return \ref Type::String
  */
-extern "C" const Type *type_String();
+extern "C" const Type *type_String() noexcept;
 ///\}
 
 ///\name Instruction implementations
 ///\{
+/**
+ * \brief Implements the \ref code::GlobalLoad instruction.
+ * \param gv the global variable
+ * \return the value of the global variable
+ */
+extern "C" qvalue global_load(GlobalVariable *gv);
+
+/**
+ * \brief Implements the \ref code::GlobalLoadRef instruction.
+ * \param gv the global variable
+ * \return the value of the global variable with its reference count incremented
+ */
+extern "C" qvalue global_load_ref(GlobalVariable *gv);
+
 /**
  * \brief Implements the \ref code::RefDec instruction.
  * \param value the argument of the instruction
  */
 extern "C" void ref_dec(qvalue value);
 
+/**
+ * \brief Implements the \ref code::RefDecDeferred instruction.
+ * \param value the argument of the instruction
+ */
+extern "C" void ref_dec_deferred(qvalue value) noexcept;
+
 /**
  * \brief Implements the \ref code::RefDecNoexcept instruction.
  * \param value the argument of the instruction
  */
-extern "C" void ref_dec_noexcept(qvalue value);
+extern "C" void ref_dec_noexcept(qvalue value) noexcept;
 
 /**
  * \brief Implements the \ref code::RefInc instruction.
  * \param value the argument of the instruction
  */
-extern "C" void ref_inc(qvalue value);
+extern "C" void ref_inc(qvalue value) noexcept;
+
+/**
+ * \brief Implements the \ref code::RefReclaim instruction.
+ */
+extern "C" void ref_reclaim() noexcept;
+///\}
+
+///\name Inline caches
+///\{
+/**
+ * \brief Wraps the \ref ConversionCache::invoke() method.
+ *
+ * Used by native code which cannot refer to the `convert<ArgType>To<ResultType>Cached` functions by name.
+ * \param cache `this` for the method invocation
+ * \param type the destination type
+ * \param value the value to convert
+ * \return the result of the conversion
+ */
+extern "C" qvalue conversionCache_invoke(ConversionCache *cache, const Type *type, qvalue value);
+
+/**
+ * \brief Wraps the \ref BinaryOperatorCache::invoke() method.
+ *
+ * Used by native code which cannot refer to the `binOpAny<Kind>AnyCached` functions by name.
+ * \param cache `this` for the method invocation
+ * \param kind the kind of the operator (see \ref BinaryOperator::Kind)
+ * \param left the left operand
+ * \param right the right operand
+ * \return the result of the operator
+ */
+extern "C" qvalue binaryOperatorCache_invoke(BinaryOperatorCache *cache, int kind, qvalue left, qvalue right);
 ///\}
 
 ///\name Utility functions
@@ -192,14 +262,21 @@ extern "C" void ref_inc(qvalue value);
  * \param i the value to convert
  * \return converted value
  */
-extern "C" qvalue qint_to_qvalue(qint i);
+extern "C" qvalue qint_to_qvalue(qint i) noexcept;
 
 /**
  * \brief Converts \ref qvalue to \ref qbool.
  * \param v the value to convert
  * \return converted value
  */
-extern "C" qbool qvalue_to_qbool(qvalue v);
+extern "C" qbool qvalue_to_qbool(qvalue v) noexcept;
+
+/**
+ * \brief Converts \ref qbool to \ref qvalue.
+ * \param b the value to convert
+ * \return converted value
+ */
+extern "C" qvalue qbool_to_qvalue(qbool b) noexcept;
 ///\}
 
 } // namespace nrt
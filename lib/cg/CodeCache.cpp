@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implements the persistent cache of compiled scripts.
+///
+//------------------------------------------------------------------------------
+#include "qore/cg/CodeCache.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeValue.h"
+#include "qore/core/util/Debug.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+static const char *ManifestSuffix = ".deps";
+
+static bool readFile(const std::string &fileName, std::string &data) {
+    std::ifstream stream(fileName, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return !stream.bad() && stream.is_open();
+}
+
+static std::string hash(const std::string &data) {
+    llvm::MD5 md5;
+    md5.update(data);
+    llvm::MD5::MD5Result result;
+    md5.final(result);
+    llvm::SmallString<32> str;
+    llvm::MD5::stringifyResult(result, str);
+    return str.str().str();
+}
+
+static std::string hashFile(const std::string &fileName) {
+    std::string data;
+    return readFile(fileName, data) ? hash(data) : std::string();
+}
+
+CodeCache::CodeCache(std::string directory, std::uint64_t maxSize) : directory(std::move(directory)),
+        maxSize(maxSize) {
+    if (std::error_code ec = llvm::sys::fs::create_directories(this->directory)) {
+        LOG("Unable to create the cache directory " << this->directory << ": " << ec.message());
+    }
+}
+
+std::string CodeCache::getKey(const std::string &fileName, const std::string &options) const {
+    std::string data;
+    if (!readFile(fileName, data)) {
+        return std::string();
+    }
+    //the name matters for relative includes
+    return hash(QORE_VERSION "\n" LLVM_VERSION_STRING "\n" + options + "\n" + fileName + "\n" + data);
+}
+
+std::string CodeCache::lookup(const std::string &key) {
+    std::string path = getPath(key);
+    std::ifstream manifest(path + ManifestSuffix);
+    if (!manifest || !llvm::sys::fs::exists(path)) {
+        LOG("Cache miss " << key);
+        return std::string();
+    }
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::string::size_type sep = line.find(' ');
+        if (sep == std::string::npos || hashFile(line.substr(sep + 1)) != line.substr(0, sep)) {
+            LOG("Cache entry " << key << " is stale");
+            return std::string();
+        }
+    }
+
+    int fd;
+    if (!llvm::sys::fs::openFileForWrite(path + ManifestSuffix, fd, llvm::sys::fs::F_Append)) {
+        llvm::sys::fs::setLastModificationAndAccessTime(fd, llvm::sys::TimeValue::now());
+        llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    }
+    LOG("Cache hit " << key);
+    return path;
+}
+
+std::string CodeCache::createTempFile(const std::string &key) const {
+    llvm::SmallString<128> path;
+    if (llvm::sys::fs::createUniqueFile(getPath(key) + "-%%%%%%.tmp", path)) {
+        return std::string();
+    }
+    return path.str().str();
+}
+
+std::string CodeCache::store(const std::string &key, const std::string &executable, Env &env) {
+    std::ostringstream deps;
+    for (const SourceInfo &info : env.getSourceInfos()) {
+        if (!info.getFullName().empty()) {
+            std::string h = hashFile(info.getFullName());
+            if (h.empty()) {
+                return std::string();
+            }
+            deps << h << ' ' << info.getFullName() << '\n';
+        }
+    }
+
+    //the manifest is written last, an entry without it is never used
+    std::string path = getPath(key);
+    std::string manifest = executable + ManifestSuffix;
+    {
+        std::ofstream out(manifest, std::ios::binary);
+        out << deps.str();
+        if (!out) {
+            return std::string();
+        }
+    }
+    if (llvm::sys::fs::rename(executable, path) || llvm::sys::fs::rename(manifest, path + ManifestSuffix)) {
+        llvm::sys::fs::remove(manifest);
+        return std::string();
+    }
+    evict(key);
+    return path;
+}
+
+void CodeCache::evict(const std::string &keep) {
+    struct Entry {
+        std::string path;
+        std::uint64_t size;
+        llvm::sys::TimeValue lastUse;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        llvm::StringRef manifest = it->path();
+        if (!manifest.endswith(ManifestSuffix)) {
+            continue;
+        }
+        Entry e;
+        e.path = manifest.drop_back(std::char_traits<char>::length(ManifestSuffix)).str();
+        llvm::sys::fs::file_status manifestStatus, exeStatus;
+        if (it->status(manifestStatus) || llvm::sys::fs::status(e.path, exeStatus)) {
+            continue;
+        }
+        e.size = manifestStatus.getSize() + exeStatus.getSize();
+        e.lastUse = manifestStatus.getLastModificationTime();
+        total += e.size;
+        if (e.path != getPath(keep)) {
+            entries.push_back(std::move(e));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &l, const Entry &r) { return l.lastUse < r.lastUse; });
+    for (const Entry &e : entries) {
+        if (total <= maxSize) {
+            break;
+        }
+        LOG("Evicting cache entry " << e.path);
+        llvm::sys::fs::remove(e.path + ManifestSuffix);
+        llvm::sys::fs::remove(e.path);
+        total -= e.size;
+    }
+}
+///\endcond
+
+} // namespace cg
+} // namespace qore
@@ -29,158 +29,180 @@
 ///
 //------------------------------------------------------------------------------
 #include "qore/cg/CodeGen.h"
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/AssemblyAnnotationWriter.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/raw_os_ostream.h"
-#include "FunctionCompiler.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "qore/core/util/Debug.h"
+#include "Compiler.h"
+#include "Optimizer.h"
+#include "ParallelCompiler.h"
+#include "RuntimeBitcode.h"
 
 namespace qore {
 namespace cg {
 
 ///\cond
-class Compiler {
+CompileTimes CodeGen::process(Env &env, OptLevel level) {
+    CompileTimes times;
+    Stopwatch generation;
+    Compiler compiler;
+    std::unique_ptr<llvm::Module> module = compiler.compile(env);
+    RuntimeBitcode(module->getContext()).link(*module);
 
-public:
-    Compiler() : qstart(helper.createFunction("qstart", helper.lt_void, helper.lt_Env_ptr)), builder(helper.ctx) {
-        builder.SetInsertPoint(llvm::BasicBlock::Create(helper.ctx, "entry", qstart));
+    std::cerr.flush();
+    llvm::raw_os_ostream sss(std::cerr);
+    if (llvm::verifyModule(*module, &sss)) {
+        sss.flush();
+        assert(false);
     }
+    times.generation = generation.elapsed();
+    times.optimization = Optimizer(level).run(*module);
 
-    std::unique_ptr<llvm::Module> compile(Env &env) {
-        llvm::Value *rtEnv = &*qstart->arg_begin();
-        llvm::Value *rtNs = builder.CreateCall(helper.lf_env_getRootNamespace, rtEnv);
-
-        for (const SourceInfo &src : env.getSourceInfos()) {
-            llvm::Value *args[2] = { rtEnv, stringLiteral(src.getName(), "src_info") };
-            sourceInfos[&src] = builder.CreateCall(helper.lf_env_addSourceInfo, args);
-        }
-
-        for (const String &str : env.getStrings()) {
-            llvm::GlobalVariable *strGv = new llvm::GlobalVariable(*helper.module, helper.lt_qvalue, false,
-                    llvm::GlobalVariable::PrivateLinkage, llvm::Constant::getNullValue(helper.lt_qvalue), "str");
-
-
-            llvm::Value *args[2] = { rtEnv, stringLiteral(str.get(), "str_lit") };
-            llvm::Value *v = builder.CreateCall(helper.lf_env_addString, args);
-            builder.CreateStore(v, strGv);
-            strings[&str] = strGv;
-        }
-
-        compile(rtNs, env.getRootNamespace());
-        builder.CreateRetVoid();
+    module->dump();
 
-        for (auto &p : functions) {
-            FunctionCompiler fc(*p.first, strings, globals, functions, p.second, helper);
-            fc.compile();
-        }
+    Stopwatch emission;
+    std::error_code ec;
+    llvm::raw_fd_ostream os2("out.ll", ec, llvm::sys::fs::F_None);
+    std::unique_ptr<llvm::AssemblyAnnotationWriter> Annotator;
+    assert(!ec);
+    module->print(os2, Annotator.get());
+    times.emission = emission.elapsed();
+    return times;
+}
 
-        return std::move(helper.module);
+static llvm::CodeGenOpt::Level getCodeGenOptLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0:
+            return llvm::CodeGenOpt::None;
+        case OptLevel::O1:
+            return llvm::CodeGenOpt::Less;
+        case OptLevel::O2:
+            return llvm::CodeGenOpt::Default;
+        case OptLevel::O3:
+            return llvm::CodeGenOpt::Aggressive;
     }
+    QORE_UNREACHABLE("Invalid OptLevel");
+}
 
-private:
-    #define LOCATION(x) sourceInfos[&x.getLocation().getSourceInfo()], \
-        llvm::ConstantInt::get(helper.lt_int32, x.getLocation().getPacked())
-    void compile(llvm::Value *rtNs, const Namespace &ns) {
-        for (auto &n : ns.getNamespaces()) {
-            llvm::Value *args[4] = { rtNs, name(n.getFullName()), LOCATION(n) };
-            llvm::Value *rtNs2 = builder.CreateCall(helper.lf_namespace_addNamespace, args);
-            compile(rtNs2, n);
-        }
-        for (auto &gv : ns.getGlobalVariables()) {
-            llvm::Value *args[5] = { rtNs, name(gv.getFullName()), type(gv.getType()), LOCATION(gv) };
-            llvm::Value *rtGv = builder.CreateCall(helper.lf_namespace_addGlobalVariable, args);
-            llvm::GlobalVariable *g = new llvm::GlobalVariable(*helper.module, helper.lt_GlobalVariable_ptr, false,
-                    llvm::GlobalValue::PrivateLinkage, llvm::Constant::getNullValue(helper.lt_GlobalVariable_ptr),
-                    gv.getFullName());  //FIXME mangled name
-            builder.CreateStore(rtGv, g);
-            globals[&gv] = g;
-        }
-        for (auto &fg : ns.getFunctionGroups()) {
-            llvm::Value *args[2] = { rtNs, name(fg.getFullName()) };
-            llvm::Value *rtFg = builder.CreateCall(helper.lf_namespace_addFunctionGroup, args);
-            declare(rtFg, fg);
-        }
+static std::unique_ptr<llvm::TargetMachine> createTargetMachine(OptLevel level, std::string &error) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+        return nullptr;
     }
-    #undef LOCATION
+    //position independent so that the executables can be linked as PIE
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(triple, llvm::sys::getHostCPUName(), "",
+            llvm::TargetOptions(), llvm::Reloc::PIC_, llvm::CodeModel::Default, getCodeGenOptLevel(level)));
+}
 
-    void declare(llvm::Value *rtFg, const FunctionGroup &fg) {
-        for (auto &f : fg.getFunctions()) {
-            declare(fg.getFullName(), f);   //TODO mangled name
-            //generate call for lf_functionGroup_addFunction, save the pointer to the function
-        }
+bool CodeGen::emit(Env &env, const Function &entry, const std::string &path, OutputFormat format, OptLevel level,
+        unsigned threads, bool debugInfo, CompileTimes &times, std::string &error) {
+    //the optimizer needs the data layout of the target
+    std::unique_ptr<llvm::TargetMachine> tm = createTargetMachine(level, error);
+    if (!tm) {
+        return false;
     }
-
-    void declare(const std::string &name, const Function &f) {
-        std::vector<llvm::Type *> args(f.getType().getParameterCount(), helper.lt_qvalue);
-        llvm::Type *ret = f.getType().getReturnType() == Type::Nothing ? helper.lt_void : helper.lt_qvalue;
-        llvm::Function *func = llvm::Function::Create(
-                llvm::FunctionType::get(ret, args, false),
-                llvm::Function::ExternalLinkage, name, helper.module.get());
-        functions[&f] = func;
-        Index i = 0;
-        for (auto it = func->arg_begin(); it != func->arg_end(); ++it) {
-            (*it).setName(llvm::Twine("arg").concat(llvm::Twine(i++)));
+    std::string triple = tm->getTargetTriple().str();
+    llvm::DataLayout layout = tm->createDataLayout();
+
+    Stopwatch generation;
+    Compiler compiler(debugInfo);
+    compiler.getHelper().module->setTargetTriple(triple);
+    compiler.getHelper().module->setDataLayout(layout);
+    std::unique_ptr<llvm::Module> module;
+    std::chrono::microseconds partitionOptimization{0};
+    try {
+        if (threads > 1) {
+            module = ParallelCompiler(threads).compile(compiler, env, [&triple, &layout, level](Helper &helper) {
+                helper.module->setTargetTriple(triple);
+                helper.module->setDataLayout(layout);
+                RuntimeBitcode(helper.ctx).link(*helper.module);
+                return Optimizer(level).run(*helper.module);
+            }, partitionOptimization, error);
+            if (!module) {
+                error = "generated code is broken: " + error;
+                return false;
+            }
+        } else {
+            module = compiler.compile(env);
         }
+    } catch (util::NotImplemented &) {
+        error = "the code uses features which are not supported by the code generator yet";
+        return false;
     }
-
-    llvm::Value *stringLiteral(const std::string &str, const std::string &name) {
-        llvm::Constant *val = llvm::ConstantDataArray::getString(helper.ctx, str, true);
-        llvm::GlobalVariable *gv = new llvm::GlobalVariable(*helper.module, val->getType(), true,
-                llvm::GlobalValue::PrivateLinkage, val, name);
-        gv->setUnnamedAddr(true);
-        return builder.CreateConstGEP2_32(nullptr, gv, 0, 0);
+    auto it = compiler.getFunctions().find(&entry);
+    assert(it != compiler.getFunctions().end());
+    compiler.getHelper().createEntry(*module, it->second, "qmain");
+    if (threads <= 1) {
+        RuntimeBitcode(module->getContext()).link(*module);
     }
 
-    llvm::Value *name(const std::string &str) {
-        return stringLiteral(str.substr(str.rfind(':') + 1), "name");
+    llvm::raw_string_ostream os(error);
+    if (llvm::verifyModule(*module, &os)) {
+        os.flush();
+        error = "generated code is broken: " + error;
+        return false;
     }
 
-    llvm::Value *type(const Type &type) {
-        llvm::Value *&ref = types[&type];
-        if (!ref) {
-            //must be built-in, class types will be handled in a different way
-            if (type == Type::String) {
-                ref = builder.CreateCall(helper.lf_type_String);
-            } else {
-                QORE_NOT_IMPLEMENTED("");
+    //the partitions have been optimized by their threads while the stopwatch was running, only qstart and qmain are left
+    times.generation = generation.elapsed() - partitionOptimization;
+    times.optimization = partitionOptimization + Optimizer(threads > 1 ? OptLevel::O0 : level).run(*module);
+
+    Stopwatch emission;
+    std::error_code ec;
+    llvm::raw_fd_ostream out(path, ec, format == OutputFormat::IR ? llvm::sys::fs::F_Text : llvm::sys::fs::F_None);
+    if (ec) {
+        error = "cannot open " + path + ": " + ec.message();
+        return false;
+    }
+    switch (format) {
+        case OutputFormat::IR:
+            module->print(out, nullptr);
+            break;
+        case OutputFormat::Bitcode:
+            llvm::WriteBitcodeToFile(module.get(), out);
+            break;
+        case OutputFormat::Object: {
+            llvm::legacy::PassManager pm;
+            if (tm->addPassesToEmitFile(pm, out, llvm::TargetMachine::CGFT_ObjectFile)) {
+                error = "the target cannot emit object files";
+                return false;
             }
+            pm.run(*module);
+            break;
         }
-        return ref;
     }
+    times.emission = emission.elapsed();
+    return true;
+}
 
-private:
-    Helper helper;
-    std::unordered_map<const SourceInfo *, llvm::Value *> sourceInfos;
-    FunctionContext::StringsMap strings;
-    FunctionContext::GlobalsMap globals;
-    FunctionContext::FunctionsMap functions;
-    llvm::Function *qstart;
-    llvm::IRBuilder<> builder;
-    std::unordered_map<const Type *, llvm::Value *> types;
-};
-
-void CodeGen::process(Env &env) {
-    Compiler compiler;
-    std::unique_ptr<llvm::Module> module = compiler.compile(env);
-
-    module->dump();
-
-    std::cerr.flush();
-    llvm::raw_os_ostream sss(std::cerr);
-    if (llvm::verifyModule(*module, &sss)) {
-        sss.flush();
-        assert(false);
+bool CodeGen::link(const std::string &object, const std::string &output, std::string &error) {
+    //nrtmain provides main(), the runtime libraries are the same that the compiler itself is linked with
+    std::string cmd = std::string("\"" QORE_LINKER "\" " QORE_LINK_FLAGS " \"") + object + "\" -o \"" + output
+            + "\" -L\"" QORE_RUNTIME_LIBRARY_DIR "\" -lnrtmain -lnrt -lcore -lpthread";
+    LOG("Linking: " << cmd);
+    int status = std::system(cmd.c_str());
+    if (status != 0) {
+        error = "linking failed with status " + std::to_string(status) + ": " + cmd;
+        return false;
     }
-
-    std::error_code ec;
-    llvm::raw_fd_ostream os2("out.ll", ec, llvm::sys::fs::F_None);
-    std::unique_ptr<llvm::AssemblyAnnotationWriter> Annotator;
-    assert(!ec);
-    module->print(os2, Annotator.get());
+    return true;
 }
 ///\endcond
 
@@ -0,0 +1,239 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the compiler of a whole environment.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_COMPILER_H_
+#define LIB_CG_COMPILER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "qore/core/Env.h"
+#include "DebugInfo.h"
+#include "FunctionCompiler.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+class Compiler {
+
+public:
+    explicit Compiler(bool debugInfo = false) : debugInfo(debugInfo),
+            qstart(helper.createFunction("qstart", helper.lt_void, helper.lt_Env_ptr)), builder(helper.ctx) {
+        builder.SetInsertPoint(llvm::BasicBlock::Create(helper.ctx, "entry", qstart));
+    }
+
+    std::unique_ptr<llvm::Module> compile(Env &env) {
+        declare(env);
+        std::unique_ptr<DebugInfo> di;
+        if (debugInfo) {
+            di = util::make_unique<DebugInfo>(*helper.module, getMainFile(env));
+        }
+        for (auto &p : functions) {
+            FunctionCompiler fc(*p.first, strings, globals, functions, p.second, helper, di.get());
+            fc.compile();
+        }
+        if (di) {
+            di->finalize();
+        }
+        return std::move(helper.module);
+    }
+
+    //the name of the compile unit of the debug information
+    static std::string getMainFile(Env &env) {
+        auto sourceInfos = env.getSourceInfos();
+        return sourceInfos.begin() == sourceInfos.end() ? "<noname>" : sourceInfos.begin()->getName();
+    }
+
+    //generates qstart and declares all functions without generating their bodies - qstart passes constant tables
+    //describing the environment to a single runtime call
+    void declare(Env &env) {
+        std::vector<llvm::Constant *> sourceInfoRows;
+        for (const SourceInfo &src : env.getSourceInfos()) {
+            sourceInfos[&src] = sourceInfoRows.size();
+            sourceInfoRows.push_back(stringLiteral(src.getName(), "src_info"));
+        }
+
+        std::vector<llvm::Constant *> stringRows;
+        for (const String &str : env.getStrings()) {
+            llvm::GlobalVariable *strGv = new llvm::GlobalVariable(*helper.module, helper.lt_qvalue, false,
+                    llvm::GlobalVariable::PrivateLinkage, llvm::Constant::getNullValue(helper.lt_qvalue), "str");
+            strings[&str] = strGv;
+            stringRows.push_back(llvm::ConstantStruct::get(helper.lt_StringEntry, {
+                    stringLiteral(str.get(), "str_lit"),
+                    llvm::ConstantInt::get(helper.lt_qint, str.get().size()),
+                    strGv }));
+        }
+
+        compile(-1, env.getRootNamespace());
+
+        llvm::Constant *table = llvm::ConstantStruct::get(helper.lt_EnvTable, {
+                array(helper.lt_char_ptr, sourceInfoRows, "src_infos"), count(sourceInfoRows),
+                array(helper.lt_StringEntry, stringRows, "strings"), count(stringRows),
+                array(helper.lt_NamespaceEntry, namespaceRows, "namespaces"), count(namespaceRows),
+                array(helper.lt_GlobalVariableEntry, globalRows, "globals"), count(globalRows),
+                array(helper.lt_FunctionGroupEntry, functionGroupRows, "function_groups"), count(functionGroupRows) });
+        llvm::GlobalVariable *tableGv = new llvm::GlobalVariable(*helper.module, helper.lt_EnvTable, true,
+                llvm::GlobalValue::PrivateLinkage, table, "env_table");
+
+        llvm::Value *args[2] = { &*qstart->arg_begin(), tableGv };
+        builder.CreateCall(helper.lf_env_load, args);
+        builder.CreateRetVoid();
+    }
+
+    Helper &getHelper() {
+        return helper;
+    }
+
+    bool hasDebugInfo() const {
+        return debugInfo;
+    }
+
+    const FunctionContext::StringsMap &getStrings() const {
+        return strings;
+    }
+
+    const FunctionContext::GlobalsMap &getGlobals() const {
+        return globals;
+    }
+
+    const FunctionContext::FunctionsMap &getFunctions() const {
+        return functions;
+    }
+
+    //the linker may replace the declarations of functions when other modules are linked into the module
+    void updateFunction(const Function &f, llvm::Function *func) {
+        functions[&f] = func;
+    }
+
+private:
+    //appends the rows describing a namespace and its members, the index of the parent of the root namespace is -1
+    void compile(int index, const Namespace &ns) {
+        for (auto &n : ns.getNamespaces()) {
+            int childIndex = namespaceRows.size();
+            namespaceRows.push_back(llvm::ConstantStruct::get(helper.lt_NamespaceEntry, {
+                    name(n.getFullName()), int32(index), sourceInfo(n.getLocation()), location(n.getLocation()) }));
+            compile(childIndex, n);
+        }
+        for (auto &gv : ns.getGlobalVariables()) {
+            llvm::GlobalVariable *g = new llvm::GlobalVariable(*helper.module, helper.lt_GlobalVariable_ptr, false,
+                    llvm::GlobalValue::PrivateLinkage, llvm::Constant::getNullValue(helper.lt_GlobalVariable_ptr),
+                    gv.getFullName());  //FIXME mangled name
+            globals[&gv] = g;
+            globalRows.push_back(llvm::ConstantStruct::get(helper.lt_GlobalVariableEntry, {
+                    name(gv.getFullName()), int32(index), sourceInfo(gv.getLocation()), location(gv.getLocation()),
+                    type(gv.getType()), g }));
+        }
+        for (auto &fg : ns.getFunctionGroups()) {
+            functionGroupRows.push_back(llvm::ConstantStruct::get(helper.lt_FunctionGroupEntry, {
+                    name(fg.getFullName()), int32(index) }));
+            declare(fg);
+        }
+    }
+
+    void declare(const FunctionGroup &fg) {
+        for (auto &f : fg.getFunctions()) {
+            functions[&f] = helper.declareFunction(f.getMangledName(), f);
+            //generate call for lf_functionGroup_addFunction, save the pointer to the function
+        }
+    }
+
+    llvm::Constant *stringLiteral(const std::string &str, const std::string &name) {
+        llvm::Constant *val = llvm::ConstantDataArray::getString(helper.ctx, str, true);
+        llvm::GlobalVariable *gv = new llvm::GlobalVariable(*helper.module, val->getType(), true,
+                llvm::GlobalValue::PrivateLinkage, val, name);
+        gv->setUnnamedAddr(true);
+        return firstElement(gv);
+    }
+
+    llvm::Constant *name(const std::string &str) {
+        return stringLiteral(str.substr(str.rfind(':') + 1), "name");
+    }
+
+    llvm::Constant *int32(int value) {
+        return llvm::ConstantInt::get(helper.lt_int32, value);
+    }
+
+    llvm::Constant *sourceInfo(const SourceLocation &location) {
+        return int32(sourceInfos[&location.getSourceInfo()]);
+    }
+
+    llvm::Constant *location(const SourceLocation &location) {
+        return int32(location.getPacked());
+    }
+
+    llvm::Constant *count(const std::vector<llvm::Constant *> &rows) {
+        return int32(rows.size());
+    }
+
+    llvm::Constant *firstElement(llvm::GlobalVariable *gv) {
+        llvm::Constant *indices[2] = { int32(0), int32(0) };
+        return llvm::ConstantExpr::getInBoundsGetElementPtr(gv->getValueType(), gv, indices);
+    }
+
+    //creates a constant array of table rows, returns a pointer to its first element
+    llvm::Constant *array(llvm::Type *rowType, const std::vector<llvm::Constant *> &rows, const std::string &name) {
+        if (rows.empty()) {
+            return llvm::Constant::getNullValue(rowType->getPointerTo());
+        }
+        llvm::ArrayType *type = llvm::ArrayType::get(rowType, rows.size());
+        return firstElement(new llvm::GlobalVariable(*helper.module, type, true, llvm::GlobalValue::PrivateLinkage,
+                llvm::ConstantArray::get(type, rows), name));
+    }
+
+    //the runtime gets the built-in types through functions since their addresses are not constant
+    llvm::Constant *type(const Type &type) {
+        //must be built-in, class types will be handled in a different way
+        if (type == Type::String) {
+            return helper.lf_type_String;
+        }
+        QORE_NOT_IMPLEMENTED("");
+    }
+
+private:
+    bool debugInfo;
+    Helper helper;
+    std::unordered_map<const SourceInfo *, int> sourceInfos;
+    FunctionContext::StringsMap strings;
+    FunctionContext::GlobalsMap globals;
+    FunctionContext::FunctionsMap functions;
+    llvm::Function *qstart;
+    llvm::IRBuilder<> builder;
+    std::vector<llvm::Constant *> namespaceRows;
+    std::vector<llvm::Constant *> globalRows;
+    std::vector<llvm::Constant *> functionGroupRows;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_COMPILER_H_
@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the generator of DWARF debug information.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_DEBUGINFO_H_
+#define LIB_CG_DEBUGINFO_H_
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Path.h"
+#include "qore/core/FunctionGroup.h"
+#include "qore/core/SourceLocation.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Describes the generated functions and the source locations of their instructions in DWARF.
+ *
+ * Each module gets its own compile unit named after the main source file. Instructions from other source files
+ * (e.g. included ones) are attributed to their files through lexical block scopes. Instructions without a location
+ * get the line of the declaration of their function.
+ */
+class DebugInfo {
+
+public:
+    /**
+     * \brief Constructor.
+     * \param module the module to describe
+     * \param mainFile the name of the main source file
+     */
+    DebugInfo(llvm::Module &module, const std::string &mainFile) : builder(module) {
+        module.addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+        module.addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+        builder.createCompileUnit(llvm::dwarf::DW_LANG_C_plus_plus, llvm::sys::path::filename(mainFile),
+                llvm::sys::path::parent_path(mainFile), "qore " QORE_VERSION, false, "", 0);
+        this->mainFile = createFile(mainFile);
+        functionType = builder.createSubroutineType(builder.getOrCreateTypeArray({}));
+    }
+
+    /**
+     * \brief Attaches a subprogram describing a function to its LLVM function.
+     * \param func the LLVM function
+     * \param f the function
+     * \return the subprogram to use as the scope of the locations of the instructions
+     */
+    llvm::DISubprogram *createFunction(llvm::Function *func, const Function &f) {
+        const std::string &fullName = f.getGroup().getFullName();
+        std::string name = fullName.compare(0, 2, "::") == 0 ? fullName.substr(2) : fullName;
+        llvm::DIFile *file = getFile(f.getLocation().getSourceInfo());
+        unsigned line = f.getLocation().getLine();
+        llvm::DISubprogram *sp = builder.createFunction(file, name, func->getName(), file, line, functionType,
+                false, true, line);
+        func->setSubprogram(sp);
+        return sp;
+    }
+
+    /**
+     * \brief Returns the debug location of an instruction.
+     * \param location the source location of the instruction
+     * \param sp the subprogram of the function containing the instruction
+     * \return the debug location
+     */
+    llvm::DebugLoc getLocation(const SourceLocation &location, llvm::DISubprogram *sp) {
+        if (location.getSourceInfo() == SourceInfo::Invalid) {
+            return llvm::DebugLoc::get(sp->getLine(), 0, sp);
+        }
+        llvm::DIFile *file = getFile(location.getSourceInfo());
+        llvm::DIScope *scope = sp;
+        if (file != sp->getFile()) {
+            //one scope per file is enough, creating one for each instruction would bloat the metadata
+            llvm::DILexicalBlockFile *&blockFile = blockFiles[std::make_pair(sp, file)];
+            if (!blockFile) {
+                blockFile = builder.createLexicalBlockFile(sp, file);
+            }
+            scope = blockFile;
+        }
+        return llvm::DebugLoc::get(location.getLine(), location.getColumn(), scope);
+    }
+
+    /**
+     * \brief Resolves the descriptions, must be called once all functions of the module have been generated.
+     */
+    void finalize() {
+        builder.finalize();
+    }
+
+private:
+    llvm::DIFile *createFile(const std::string &name) {
+        return builder.createFile(llvm::sys::path::filename(name), llvm::sys::path::parent_path(name));
+    }
+
+    llvm::DIFile *getFile(const SourceInfo &sourceInfo) {
+        if (sourceInfo == SourceInfo::Invalid) {
+            return mainFile;
+        }
+        llvm::DIFile *&file = files[&sourceInfo];
+        if (!file) {
+            file = createFile(sourceInfo.getName());
+        }
+        return file;
+    }
+
+private:
+    llvm::DIBuilder builder;
+    llvm::DIFile *mainFile;
+    llvm::DISubroutineType *functionType;
+    std::unordered_map<const SourceInfo *, llvm::DIFile *> files;
+    std::map<std::pair<llvm::DISubprogram *, llvm::DIFile *>, llvm::DILexicalBlockFile *> blockFiles;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_DEBUGINFO_H_
@@ -43,6 +43,9 @@ public:
 
     void compile(const code::Block &block) {
         for (const code::Instruction &ins : block) {
+            if (ctx.debugInfo) {
+                builder.SetCurrentDebugLocation(ctx.debugInfo->getLocation(ins.getLocation(), ctx.subprogram));
+            }
             ins.accept(*this);
         }
     }
@@ -52,34 +55,52 @@ public:
     using ReturnType = void;
 
     void visit(const code::Branch &ins) {
-        builder.CreateCondBr(
-                builder.CreateCall(ctx.helper.lf_qvalue_to_qbool, ctx.temps[ins.getCondition().getIndex()]),
+        builder.CreateCondBr(get(ins.getCondition(), ctx.helper.lt_bool),
                 mapBlock(ins.getTrueDest(), "if.true"),
                 mapBlock(ins.getFalseDest(), "if.false"));
     }
 
     void visit(const code::ConstInt &ins) {
-        ctx.temps[ins.getDest().getIndex()] = builder.CreateCall(ctx.helper.lf_qint_to_qvalue,
-                llvm::ConstantInt::get(ctx.helper.lt_qint, ins.getValue(), true));
+        set(ins.getDest(), llvm::ConstantInt::get(ctx.helper.lt_qint, ins.getValue(), true));
     }
 
     void visit(const code::ConstString &ins) {
-        ctx.temps[ins.getDest().getIndex()] = builder.CreateLoad(ctx.strings[&ins.getString()]);
+        set(ins.getDest(), builder.CreateLoad(ctx.strings[&ins.getString()]));
+    }
+
+    void visit(const code::ConvertAndBranch &ins) {
+        llvm::Value *cond = lowerConversion(ins.getConversion(), ins.getArg());
+        if (!cond) {
+            cond = builder.CreateCall(ctx.helper.getConversion(ins.getConversion()), get(ins.getArg()));
+        }
+        builder.CreateCondBr(ctx.helper.coerce(builder, cond, ctx.helper.lt_bool),
+                mapBlock(ins.getTrueDest(), "if.true"),
+                mapBlock(ins.getFalseDest(), "if.false"));
     }
 
     void visit(const code::GlobalGet &ins) {
-        ctx.temps[ins.getDest().getIndex()] = builder.CreateCall(ctx.helper.lf_globalVariable_getValue,
-                builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()]));
+        set(ins.getDest(), builder.CreateCall(ctx.helper.lf_globalVariable_getValue,
+                builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()])));
     }
 
     void visit(const code::GlobalInit &ins) {
         llvm::Value *args[2] = {
                 builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()]),
-                ctx.temps[ins.getInitValue().getIndex()]
+                get(ins.getInitValue())
         };
         builder.CreateCall(ctx.helper.lf_globalVariable_initValue, args);
     }
 
+    void visit(const code::GlobalLoad &ins) {
+        set(ins.getDest(), builder.CreateCall(ctx.helper.lf_global_load,
+                builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()])));
+    }
+
+    void visit(const code::GlobalLoadRef &ins) {
+        set(ins.getDest(), builder.CreateCall(ctx.helper.lf_global_load_ref,
+                builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()])));
+    }
+
     void visit(const code::GlobalReadLock &ins) {
         builder.CreateCall(ctx.helper.lf_globalVariable_readLock,
                 builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()]));
@@ -93,7 +114,7 @@ public:
     void visit(const code::GlobalSet &ins) {
         llvm::Value *args[2] = {
                 builder.CreateLoad(ctx.globals[&ins.getGlobalVariable()]),
-                ctx.temps[ins.getSrc().getIndex()]
+                get(ins.getSrc())
         };
         builder.CreateCall(ctx.helper.lf_globalVariable_setValue, args);
     }
@@ -109,22 +130,38 @@ public:
     }
 
     void visit(const code::InvokeBinaryOperator &ins) {
-        llvm::Value *args[2] = { ctx.temps[ins.getLeft().getIndex()], ctx.temps[ins.getRight().getIndex()] };
-        ctx.temps[ins.getDest().getIndex()] = makeCallOrInvoke(ins, ctx.helper.getBinaryOperator(ins.getOperator()),
-                args);
+        const BinaryOperator &op = ins.getOperator();
+        if (llvm::Value *result = lowerBinaryOperator(op, ins.getLeft(), ins.getRight())) {
+            set(ins.getDest(), result);
+        } else if (op.isDynamic()) {
+            llvm::Value *args[3] = { ctx.helper.createInlineCache(sizeof(BinaryOperatorCache)),
+                    get(ins.getLeft()), get(ins.getRight()) };
+            set(ins.getDest(), makeCallOrInvoke(ins, ctx.helper.getCachedBinaryOperator(op), args));
+        } else {
+            llvm::Value *args[2] = { get(ins.getLeft()), get(ins.getRight()) };
+            set(ins.getDest(), makeCallOrInvoke(ins, ctx.helper.getBinaryOperator(op), args));
+        }
     }
 
     void visit(const code::InvokeConversion &ins) {
-        ctx.temps[ins.getDest().getIndex()] = makeCallOrInvoke(ins, ctx.helper.getConversion(ins.getConversion()),
-                ctx.temps[ins.getArg().getIndex()]);
+        const Conversion &conversion = ins.getConversion();
+        if (llvm::Value *result = lowerConversion(conversion, ins.getArg())) {
+            set(ins.getDest(), result);
+        } else if (conversion.isDynamic()) {
+            llvm::Value *args[2] = { ctx.helper.createInlineCache(sizeof(ConversionCache)), get(ins.getArg()) };
+            set(ins.getDest(), makeCallOrInvoke(ins, ctx.helper.getCachedConversion(conversion), args));
+        } else {
+            set(ins.getDest(), makeCallOrInvoke(ins, ctx.helper.getConversion(conversion),
+                    get(ins.getArg())));
+        }
     }
 
     void visit(const code::InvokeFunction &ins) {
         std::vector<llvm::Value *> args;
         for (const code::Temp &arg : ins.getArgs()) {
-            args.push_back(ctx.temps[arg.getIndex()]);
+            args.push_back(get(arg));
         }
-        ctx.temps[ins.getDest().getIndex()] = makeCallOrInvoke(ins, ctx.functions[&ins.getFunction()], args);
+        set(ins.getDest(), makeCallOrInvoke(ins, ctx.functions[&ins.getFunction()], args));
     }
 
     void visit(const code::Jump &ins) {
@@ -132,23 +169,40 @@ public:
     }
 
     void visit(const code::LocalGet &ins) {
-        ctx.temps[ins.getDest().getIndex()] = builder.CreateLoad(ctx.locals[ins.getLocalVariable().getIndex()]);
+        set(ins.getDest(), builder.CreateLoad(ctx.locals[ins.getLocalVariable().getIndex()]));
+    }
+
+    void visit(const code::LocalLoadRef &ins) {
+        llvm::Value *value = builder.CreateLoad(ctx.locals[ins.getLocalVariable().getIndex()]);
+        if (value->getType() == ctx.helper.lt_qvalue) {
+            builder.CreateCall(ctx.helper.lf_ref_inc, value);
+        }
+        set(ins.getDest(), value);
     }
 
     void visit(const code::LocalSet &ins) {
-        builder.CreateStore(ctx.temps[ins.getSrc().getIndex()], ctx.locals[ins.getLocalVariable().getIndex()]);
+        llvm::AllocaInst *local = ctx.locals[ins.getLocalVariable().getIndex()];
+        builder.CreateStore(get(ins.getSrc(), local->getAllocatedType()), local);
     }
 
     void visit(const code::RefDec &ins) {
-        makeCallOrInvoke(ins, ctx.helper.lf_ref_dec, ctx.temps[ins.getTemp().getIndex()]);
+        makeCallOrInvoke(ins, ctx.helper.lf_ref_dec, get(ins.getTemp()));
+    }
+
+    void visit(const code::RefDecDeferred &ins) {
+        builder.CreateCall(ctx.helper.lf_ref_dec_deferred, get(ins.getTemp()));
     }
 
     void visit(const code::RefDecNoexcept &ins) {
-        builder.CreateCall(ctx.helper.lf_ref_dec_noexcept, ctx.temps[ins.getTemp().getIndex()]);
+        builder.CreateCall(ctx.helper.lf_ref_dec_noexcept, get(ins.getTemp()));
     }
 
     void visit(const code::RefInc &ins) {
-        builder.CreateCall(ctx.helper.lf_ref_inc, ctx.temps[ins.getTemp().getIndex()]);
+        builder.CreateCall(ctx.helper.lf_ref_inc, get(ins.getTemp()));
+    }
+
+    void visit(const code::RefReclaim &ins) {
+        builder.CreateCall(ctx.helper.lf_ref_reclaim);
     }
 
     void visit(const code::ResumeUnwind &ins) {
@@ -157,7 +211,7 @@ public:
     }
 
     void visit(const code::Ret &ins) {
-        builder.CreateRet(ctx.temps[ins.getValue().getIndex()]);
+        builder.CreateRet(get(ins.getValue()));
     }
 
     void visit(const code::RetVoid &ins) {
@@ -170,6 +224,39 @@ public:
     ///\}
 
 private:
+    llvm::Value *get(code::Temp temp, llvm::Type *type) {
+        return ctx.helper.coerce(builder, ctx.temps[temp.getIndex()], type);
+    }
+
+    llvm::Value *get(code::Temp temp) {
+        return get(temp, ctx.helper.lt_qvalue);
+    }
+
+    void set(code::Temp temp, llvm::Value *value) {
+        ctx.temps[temp.getIndex()] = value;
+    }
+
+    /**
+     * \brief Emits native instructions for operators on int values, returns nullptr for other operators.
+     */
+    llvm::Value *lowerBinaryOperator(const BinaryOperator &op, code::Temp left, code::Temp right) {
+        if (op.getKind() == BinaryOperator::Kind::Plus && op.getLeftType() == Type::SoftInt
+                && op.getRightType() == Type::SoftInt) {
+            return builder.CreateAdd(get(left, ctx.helper.lt_qint), get(right, ctx.helper.lt_qint));
+        }
+        return nullptr;
+    }
+
+    /**
+     * \brief Emits native instructions for conversions between int and bool, returns nullptr for other conversions.
+     */
+    llvm::Value *lowerConversion(const Conversion &conversion, code::Temp arg) {
+        if (conversion.getFromType() == Type::Int && conversion.getToType() == Type::Bool) {
+            return builder.CreateICmpNE(get(arg, ctx.helper.lt_qint), llvm::ConstantInt::get(ctx.helper.lt_qint, 0));
+        }
+        return nullptr;
+    }
+
     llvm::Value *makeCallOrInvoke(const code::Instruction &ins, llvm::Function *f, llvm::ArrayRef<llvm::Value *> args) {
         if (!ins.getLpad()) {
             return builder.CreateCall(f, args);
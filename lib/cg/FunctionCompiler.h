@@ -36,6 +36,7 @@
 #include <vector>
 #include "qore/core/Function.h"
 #include "qore/core/code/Block.h"
+#include "DebugInfo.h"
 #include "Helper.h"
 
 namespace qore {
@@ -51,8 +52,9 @@ public:
 
 public:
     FunctionContext(Helper &helper, StringsMap &strings, GlobalsMap &globals, FunctionsMap &functions,
-            Size localCount, Size tempCount) : helper(helper), strings(strings), globals(globals),
-            functions(functions), locals(localCount), temps(tempCount), excSlot(nullptr) {
+            Size localCount, Size tempCount, DebugInfo *debugInfo) : helper(helper), strings(strings),
+            globals(globals), functions(functions), locals(localCount), temps(tempCount), excSlot(nullptr),
+            debugInfo(debugInfo), subprogram(nullptr) {
     }
 
 public:
@@ -63,6 +65,8 @@ public:
     std::vector<llvm::AllocaInst *> locals;
     std::vector<llvm::Value *> temps;
     llvm::Value *excSlot;
+    DebugInfo *debugInfo;
+    llvm::DISubprogram *subprogram;
     std::map<const code::Block *, llvm::BasicBlock *> blockMap;
     std::vector<const code::Block *> queue;
 };
@@ -71,21 +75,28 @@ class FunctionCompiler {
 
 public:
     FunctionCompiler(const Function &f, FunctionContext::StringsMap &strings, FunctionContext::GlobalsMap &globals,
-            FunctionContext::FunctionsMap &functions, llvm::Function *func, Helper &helper) : f(f), func(func),
-            ctx(helper, strings, globals, functions, f.getLocalVariables().size(), f.getTempCount()) {
+            FunctionContext::FunctionsMap &functions, llvm::Function *func, Helper &helper,
+            DebugInfo *debugInfo = nullptr) : f(f), func(func),
+            ctx(helper, strings, globals, functions, f.getLocalVariables().size(), f.getTempCount(), debugInfo) {
         func->setPersonalityFn(llvm::ConstantExpr::getBitCast(helper.lf_personality, helper.lt_char_ptr));
         llvm::BasicBlock *entry = llvm::BasicBlock::Create(helper.ctx, "entry", func);
         llvm::IRBuilder<> builder(entry);
+        if (debugInfo) {
+            ctx.subprogram = debugInfo->createFunction(func, f);
+            builder.SetCurrentDebugLocation(debugInfo->getLocation(f.getLocation(), ctx.subprogram));
+        }
 
         for (const LocalVariable &lv : f.getLocalVariables()) {
-            ctx.locals[lv.getIndex()] = builder.CreateAlloca(helper.lt_qvalue, nullptr, lv.getName());
+            ctx.locals[lv.getIndex()] = builder.CreateAlloca(helper.getValueType(lv.getType()), nullptr,
+                    lv.getName());
         }
         ctx.excSlot = builder.CreateAlloca(helper.lt_exc, nullptr, "exc.slot");
 
         Index i = 0;
         for (auto it = func->arg_begin(); it != func->arg_end(); ++it) {
             it->setName(llvm::Twine(ctx.locals[i]->getName()).concat(llvm::Twine(".val")));
-            builder.CreateStore(it, ctx.locals[i++]);
+            builder.CreateStore(helper.coerce(builder, &*it, ctx.locals[i]->getAllocatedType()), ctx.locals[i]);
+            ++i;
         }
 
         ctx.blockMap[&f.getEntryBlock()] = entry;
@@ -33,10 +33,16 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "qore/core/BinaryOperator.h"
+#include "qore/core/Conversion.h"
+#include "qore/core/Defs.h"
+#include "qore/core/Function.h"
+#include "qore/core/Type.h"
 #include "qore/core/util/Debug.h"
 #include "qore/core/util/Util.h"
 
@@ -47,7 +53,8 @@ namespace cg {
 class Helper {
 
 public:
-    Helper() : ctx(llvm::getGlobalContext()) {
+    //each thread generating code in parallel needs its own context
+    explicit Helper(llvm::LLVMContext &ctx = llvm::getGlobalContext()) : ctx(ctx) {
         module = util::make_unique<llvm::Module>("Q", ctx);
 
         //basic ("C") types
@@ -60,6 +67,8 @@ public:
 
         //Qore core types
         lt_qint = llvm::Type::getInt64Ty(ctx);
+        //the tagged representation of `any` values (see qore::qvalue) is opaque to the generated code, all tag
+        //manipulation happens in the runtime, so a qvalue is just a 64-bit word
         lt_qvalue = llvm::StructType::create(lt_qint, "qvalue", false);
 
         lt_Env_ptr = llvm::StructType::create(ctx, "::qore::Env")->getPointerTo();
@@ -70,6 +79,23 @@ public:
         lt_SourceInfo_ptr = llvm::StructType::create(ctx, "::qore::SourceInfo")->getPointerTo();
         lt_Type_ptr = llvm::StructType::create(ctx, "::qore::Type")->getPointerTo();
 
+        //constant tables describing the environment, see qore::nrt::EnvTable
+        llvm::Type *lt_type_fn_ptr = llvm::FunctionType::get(lt_Type_ptr, false)->getPointerTo();
+        lt_StringEntry = llvm::StructType::create(ctx, {lt_char_ptr, lt_qint, lt_qvalue->getPointerTo()},
+                "::qore::nrt::StringEntry");
+        lt_NamespaceEntry = llvm::StructType::create(ctx, {lt_char_ptr, lt_int32, lt_int32, lt_int32},
+                "::qore::nrt::NamespaceEntry");
+        lt_GlobalVariableEntry = llvm::StructType::create(ctx, {lt_char_ptr, lt_int32, lt_int32, lt_int32,
+                lt_type_fn_ptr, lt_GlobalVariable_ptr->getPointerTo()}, "::qore::nrt::GlobalVariableEntry");
+        lt_FunctionGroupEntry = llvm::StructType::create(ctx, {lt_char_ptr, lt_int32},
+                "::qore::nrt::FunctionGroupEntry");
+        lt_EnvTable = llvm::StructType::create(ctx, {
+                lt_char_ptr->getPointerTo(), lt_int32,
+                lt_StringEntry->getPointerTo(), lt_int32,
+                lt_NamespaceEntry->getPointerTo(), lt_int32,
+                lt_GlobalVariableEntry->getPointerTo(), lt_int32,
+                lt_FunctionGroupEntry->getPointerTo(), lt_int32}, "::qore::nrt::EnvTable");
+
         //personality function
         lf_personality = llvm::Function::Create(llvm::FunctionType::get(lt_int32, true),
                 llvm::Function::ExternalLinkage, "__gxx_personality_v0", module.get());
@@ -77,19 +103,10 @@ public:
         //nrt utility functions
         lf_qint_to_qvalue = createFunction("qint_to_qvalue", lt_qvalue, lt_qint);
         lf_qvalue_to_qbool = createFunction("qvalue_to_qbool", lt_bool, lt_qvalue);
+        lf_qbool_to_qvalue = createFunction("qbool_to_qvalue", lt_qvalue, lt_bool);
 
         //nrt wrappers for Env
-        lf_env_getRootNamespace = createFunction("env_getRootNamespace", lt_Namespace_ptr, lt_Env_ptr);
-        lf_env_addSourceInfo = createFunction("env_addSourceInfo", lt_SourceInfo_ptr, lt_Env_ptr, lt_char_ptr);
-        lf_env_addString = createFunction("env_addString", lt_qvalue, lt_Env_ptr, lt_char_ptr);
-
-        //nrt wrappers for Namespace
-        lf_namespace_addNamespace = createFunction("namespace_addNamespace",
-                lt_Namespace_ptr, lt_Namespace_ptr, lt_char_ptr, lt_SourceInfo_ptr, lt_int32);
-        lf_namespace_addFunctionGroup = createFunction("namespace_addFunctionGroup",
-                lt_FunctionGroup_ptr, lt_Namespace_ptr, lt_char_ptr);
-        lf_namespace_addGlobalVariable = createFunction("namespace_addGlobalVariable",
-                lt_GlobalVariable_ptr, lt_Namespace_ptr, lt_char_ptr, lt_Type_ptr, lt_SourceInfo_ptr, lt_int32);
+        lf_env_load = createFunction("env_load", lt_void, lt_Env_ptr, lt_EnvTable->getPointerTo());
 
         //nrt wrappers for GlobalVariable
         lf_globalVariable_initValue = createFunction("globalVariable_initValue",
@@ -106,9 +123,29 @@ public:
         lf_type_String = createFunction("type_String", lt_Type_ptr);
 
         //nrt instruction implementations
+        lf_global_load = createFunction("global_load", lt_qvalue, lt_GlobalVariable_ptr);
+        lf_global_load_ref = createFunction("global_load_ref", lt_qvalue, lt_GlobalVariable_ptr);
         lf_ref_dec = createFunction("ref_dec", lt_void, lt_qvalue);
+        lf_ref_dec_deferred = createFunction("ref_dec_deferred", lt_void, lt_qvalue);
         lf_ref_dec_noexcept = createFunction("ref_dec_noexcept", lt_void, lt_qvalue);
         lf_ref_inc = createFunction("ref_inc", lt_void, lt_qvalue);
+        lf_ref_reclaim = createFunction("ref_reclaim", lt_void);
+
+        //nrt wrappers for inline caches
+        lf_conversionCache_invoke = createFunction("conversionCache_invoke", lt_qvalue, lt_void_ptr, lt_Type_ptr,
+                lt_qvalue);
+        lf_binaryOperatorCache_invoke = createFunction("binaryOperatorCache_invoke", lt_qvalue, lt_void_ptr,
+                lt_int32, lt_qvalue, lt_qvalue);
+
+        //attributes of the noexcept wrappers
+        for (llvm::Function *f : {lf_qint_to_qvalue, lf_qvalue_to_qbool, lf_qbool_to_qvalue, lf_type_String,
+                lf_ref_dec_deferred, lf_ref_dec_noexcept, lf_ref_inc, lf_ref_reclaim}) {
+            f->setDoesNotThrow();
+        }
+        lf_qint_to_qvalue->setDoesNotAccessMemory();
+        lf_qvalue_to_qbool->setDoesNotAccessMemory();
+        lf_qbool_to_qvalue->setDoesNotAccessMemory();
+        lf_type_String->setDoesNotAccessMemory();
     }
 
     llvm::Function *createFunction(const std::string &name, llvm::Type *ret) {
@@ -154,10 +191,77 @@ public:
                 llvm::Function::ExternalLinkage, name, module.get());
     }
 
+    //declares the native code of a Qore function
+    llvm::Function *declareFunction(const std::string &name, const Function &f) {
+        std::vector<llvm::Type *> args(f.getType().getParameterCount(), lt_qvalue);
+        llvm::Type *ret = f.getType().getReturnType() == Type::Nothing ? lt_void : lt_qvalue;
+        llvm::Function *func = llvm::Function::Create(
+                llvm::FunctionType::get(ret, args, false),
+                llvm::Function::ExternalLinkage, name, module.get());
+        Index i = 0;
+        for (auto it = func->arg_begin(); it != func->arg_end(); ++it) {
+            (*it).setName(llvm::Twine("arg").concat(llvm::Twine(i++)));
+        }
+        return func;
+    }
+
+    //creates a function with the signature `qvalue (const qvalue *args)` which calls `func`, the result is null if
+    //`func` returns nothing
+    llvm::Function *createEntry(llvm::Module &module, llvm::Function *func, const std::string &name) {
+        llvm::Function *entry = llvm::Function::Create(
+                llvm::FunctionType::get(lt_qvalue, lt_qvalue->getPointerTo(), false),
+                llvm::GlobalValue::ExternalLinkage, name, &module);
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "entry", entry));
+        llvm::Value *argsPtr = &*entry->arg_begin();
+        std::vector<llvm::Value *> args;
+        for (unsigned i = 0; i < func->arg_size(); ++i) {
+            args.push_back(builder.CreateLoad(builder.CreateConstGEP1_32(lt_qvalue, argsPtr, i)));
+        }
+        llvm::Value *ret = builder.CreateCall(func, args);
+        builder.CreateRet(func->getReturnType()->isVoidTy() ? llvm::Constant::getNullValue(lt_qvalue) : ret);
+        return entry;
+    }
+
+    //the representation of values of given type - int and bool values are native, only values of the other types
+    //(`any`, optional and reference counted types) use lt_qvalue
+    llvm::Type *getValueType(const Type &type) {
+        if (type == Type::Int || type == Type::SoftInt) {
+            return lt_qint;
+        }
+        if (type == Type::Bool || type == Type::SoftBool) {
+            return lt_bool;
+        }
+        return lt_qvalue;
+    }
+
+    //converts a value between the native and the lt_qvalue representation
+    llvm::Value *coerce(llvm::IRBuilder<> &builder, llvm::Value *value, llvm::Type *type) {
+        llvm::Type *from = value->getType();
+        if (from == type) {
+            return value;
+        }
+        if (type == lt_qvalue && from == lt_qint) {
+            return builder.CreateInsertValue(llvm::UndefValue::get(lt_qvalue), value, 0);
+        }
+        if (type == lt_qvalue && from == lt_bool) {
+            return builder.CreateCall(lf_qbool_to_qvalue, value);
+        }
+        if (type == lt_qint && from == lt_qvalue) {
+            return builder.CreateExtractValue(value, 0);
+        }
+        if (type == lt_bool && from == lt_qvalue) {
+            return builder.CreateCall(lf_qvalue_to_qbool, value);
+        }
+        QORE_UNREACHABLE("Invalid coercion of a native value");
+    }
+
     llvm::Function *getConversion(const Conversion &conversion) {
         llvm::Function *&ref = convFunctions[&conversion];
         if (!ref) {
             ref = createFunction(conversion.getFunctionName(), lt_qvalue, lt_qvalue);
+            if (!conversion.canThrow()) {
+                ref->setDoesNotThrow();
+            }
         }
         return ref;
     }
@@ -166,10 +270,54 @@ public:
         llvm::Function *&ref = binOpFunctions[&op];
         if (!ref) {
             ref = createFunction(op.getFunctionName(), lt_qvalue, lt_qvalue, lt_qvalue);
+            if (!op.canThrow()) {
+                ref->setDoesNotThrow();
+            }
         }
         return ref;
     }
 
+    llvm::Function *getCachedConversion(const Conversion &conversion) {
+        llvm::Function *&ref = cachedConvFunctions[&conversion];
+        if (!ref) {
+            ref = createFunction(conversion.getFunctionName() + "Cached", lt_qvalue, lt_void_ptr, lt_qvalue);
+        }
+        return ref;
+    }
+
+    llvm::Function *getCachedBinaryOperator(const BinaryOperator &op) {
+        llvm::Function *&ref = cachedBinOpFunctions[&op];
+        if (!ref) {
+            ref = createFunction(op.getFunctionName() + "Cached", lt_qvalue, lt_void_ptr, lt_qvalue, lt_qvalue);
+        }
+        return ref;
+    }
+
+    const std::unordered_map<const Conversion *, llvm::Function *> &getConversions() const {
+        return convFunctions;
+    }
+
+    const std::unordered_map<const BinaryOperator *, llvm::Function *> &getBinaryOperators() const {
+        return binOpFunctions;
+    }
+
+    const std::unordered_map<const Conversion *, llvm::Function *> &getCachedConversions() const {
+        return cachedConvFunctions;
+    }
+
+    const std::unordered_map<const BinaryOperator *, llvm::Function *> &getCachedBinaryOperators() const {
+        return cachedBinOpFunctions;
+    }
+
+    //allocates storage for an inline cache of a call site - the runtime treats all zero bits as an empty cache
+    llvm::Constant *createInlineCache(Size size) {
+        llvm::Type *type = llvm::ArrayType::get(lt_qint, (size + sizeof(qint) - 1) / sizeof(qint));
+        llvm::GlobalVariable *gv = new llvm::GlobalVariable(*module, type, false, llvm::GlobalValue::PrivateLinkage,
+                llvm::Constant::getNullValue(type), "ic");
+        gv->setAlignment(sizeof(qint));
+        return llvm::ConstantExpr::getBitCast(gv, lt_void_ptr);
+    }
+
 public:
     llvm::LLVMContext &ctx;
     std::unique_ptr<llvm::Module> module;
@@ -192,6 +340,12 @@ public:
     llvm::Type *lt_Namespace_ptr;
     llvm::Type *lt_SourceInfo_ptr;
     llvm::Type *lt_Type_ptr;
+
+    llvm::StructType *lt_StringEntry;
+    llvm::StructType *lt_NamespaceEntry;
+    llvm::StructType *lt_GlobalVariableEntry;
+    llvm::StructType *lt_FunctionGroupEntry;
+    llvm::StructType *lt_EnvTable;
     ///\}
 
     ///\name Functions
@@ -200,14 +354,10 @@ public:
 
     llvm::Function *lf_qint_to_qvalue;
     llvm::Function *lf_qvalue_to_qbool;
+    llvm::Function *lf_qbool_to_qvalue;
 
-    llvm::Function *lf_env_getRootNamespace;
-    llvm::Function *lf_env_addSourceInfo;
-    llvm::Function *lf_env_addString;
+    llvm::Function *lf_env_load;
 
-    llvm::Function *lf_namespace_addNamespace;
-    llvm::Function *lf_namespace_addFunctionGroup;
-    llvm::Function *lf_namespace_addGlobalVariable;
     llvm::Function *lf_globalVariable_initValue;
     llvm::Function *lf_globalVariable_setValue;
     llvm::Function *lf_globalVariable_getValue;
@@ -218,14 +368,23 @@ public:
 
     llvm::Function *lf_type_String;
 
+    llvm::Function *lf_global_load;
+    llvm::Function *lf_global_load_ref;
     llvm::Function *lf_ref_dec;
+    llvm::Function *lf_ref_dec_deferred;
     llvm::Function *lf_ref_dec_noexcept;
     llvm::Function *lf_ref_inc;
+    llvm::Function *lf_ref_reclaim;
+
+    llvm::Function *lf_conversionCache_invoke;
+    llvm::Function *lf_binaryOperatorCache_invoke;
     ///\}
 
 private:
     std::unordered_map<const Conversion *, llvm::Function *> convFunctions;
     std::unordered_map<const BinaryOperator *, llvm::Function *> binOpFunctions;
+    std::unordered_map<const Conversion *, llvm::Function *> cachedConvFunctions;
+    std::unordered_map<const BinaryOperator *, llvm::Function *> cachedBinOpFunctions;
 };
 ///\endcond
 
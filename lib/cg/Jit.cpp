@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the in-process execution of compiled programs.
+///
+//------------------------------------------------------------------------------
+#include "qore/cg/Jit.h"
+#include <cassert>
+#include <unordered_map>
+#ifdef QORE_ENABLE_JIT
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
+#include "Compiler.h"
+#include "JitEngine.h"
+#include "Optimizer.h"
+#include "ParallelCompiler.h"
+#include "RuntimeBitcode.h"
+#endif
+
+namespace qore {
+namespace cg {
+
+///\cond
+class Jit::Impl {
+
+public:
+#ifdef QORE_ENABLE_JIT
+    Impl(OptLevel level, unsigned threads, bool debugInfo) : level(level), threads(threads), debugInfo(debugInfo),
+            bitcode(llvm::getGlobalContext()) {
+        if (debugInfo) {
+            engine.enablePerfMap();
+        }
+    }
+#else
+    Impl(OptLevel level, unsigned threads, bool debugInfo) : level(level), threads(threads), debugInfo(debugInfo) {
+    }
+#endif
+
+#ifdef QORE_ENABLE_JIT
+    bool compile(Env &env) {
+        assert(!runtime && "Jit::compile() called twice");
+        Stopwatch generation;
+        Compiler compiler(debugInfo);
+        std::unique_ptr<llvm::Module> module;
+        std::chrono::microseconds partitionOptimization{0};
+        try {
+            module = threads > 1 ? compileInParallel(compiler, env, partitionOptimization) : compiler.compile(env);
+        } catch (util::NotImplemented &) {
+            return false;
+        }
+        if (!module) {
+            return false;
+        }
+
+        Helper &helper = compiler.getHelper();
+        std::unordered_map<const Function *, std::string> names;
+        for (auto &p : compiler.getFunctions()) {
+            std::string name = "entry." + std::to_string(names.size());
+            helper.createEntry(*module, p.second, name);
+            names[p.first] = name;
+        }
+        engine.bindRuntime(helper);
+        if (threads <= 1) {
+            bitcode.link(*module);
+        }
+
+        std::string error;
+        llvm::raw_string_ostream os(error);
+        if (llvm::verifyModule(*module, &os)) {
+            LOG("Generated code is broken: " << os.str());
+            return false;
+        }
+        //the partitions have been optimized by their threads while the stopwatch was running, only qstart and the
+        //entries are left
+        times.generation = generation.elapsed() - partitionOptimization;
+        times.optimization = partitionOptimization + Optimizer(threads > 1 ? OptLevel::O0 : level).run(*module);
+
+        Stopwatch emission;
+        if (!engine.addModule(std::move(module))) {
+            return false;
+        }
+        times.emission = emission.elapsed();
+
+        runtime.reset(new Env(env.getRefCountMode()));
+        reinterpret_cast<void (*)(Env *)>(engine.getFunctionAddress("qstart"))(runtime.get());
+        for (auto &p : names) {
+            entries[p.first] = reinterpret_cast<NativeCode>(engine.getFunctionAddress(p.second));
+        }
+        return true;
+    }
+
+    std::unique_ptr<llvm::Module> compileInParallel(Compiler &compiler, Env &env,
+            std::chrono::microseconds &optimization) {
+        std::mutex mutex;
+        std::string error;
+        std::unique_ptr<llvm::Module> module = ParallelCompiler(threads).compile(compiler, env,
+                [this, &mutex](Helper &helper) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        engine.bindRuntime(helper);
+                    }
+                    RuntimeBitcode(helper.ctx).link(*helper.module);
+                    return Optimizer(level).run(*helper.module);
+                }, optimization, error);
+        if (!module) {
+            LOG("Generated code is broken: " << error);
+        }
+        return module;
+    }
+#else
+    bool compile(Env &env) {
+        return false;
+    }
+#endif
+
+public:
+    OptLevel level;
+    unsigned threads;
+    bool debugInfo;
+    CompileTimes times;
+    std::unique_ptr<Env> runtime;
+    std::unordered_map<const Function *, NativeCode> entries;
+#ifdef QORE_ENABLE_JIT
+    RuntimeBitcode bitcode;
+    JitEngine engine;
+#endif
+};
+///\endcond
+
+Jit::Jit(OptLevel level, unsigned threads, bool debugInfo) : impl(new Impl(level, threads, debugInfo)) {
+}
+
+Jit::~Jit() = default;
+
+bool Jit::compile(Env &env) {
+    return impl->compile(env);
+}
+
+Jit::NativeCode Jit::getNativeCode(const Function &f) const {
+    auto it = impl->entries.find(&f);
+    return it == impl->entries.end() ? nullptr : it->second;
+}
+
+const CompileTimes &Jit::getCompileTimes() const {
+    return impl->times;
+}
+
+Env *Jit::getRuntimeEnv() {
+    return impl->runtime.get();
+}
+
+} // namespace cg
+} // namespace qore
@@ -0,0 +1,231 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the execution engine shared by the JIT compilers.
+///
+//------------------------------------------------------------------------------
+#ifdef QORE_ENABLE_JIT
+#include "JitEngine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#ifdef __linux__
+#include <cxxabi.h>
+#include <unistd.h>
+#endif
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Object/SymbolSize.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TargetSelect.h"
+#include "qore/core/RefCounted.h"
+#include "qore/nrt/nrt.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Resolves symbols using the explicit bindings of a JitEngine, falls back to the symbols of the process.
+ */
+class RuntimeMemoryManager : public llvm::SectionMemoryManager {
+
+public:
+    explicit RuntimeMemoryManager(const std::unordered_map<std::string, uint64_t> &symbols) : symbols(symbols) {
+    }
+
+    uint64_t getSymbolAddress(const std::string &name) override {
+        auto it = symbols.find(name);
+        if (it != symbols.end()) {
+            return it->second;
+        }
+        return llvm::RTDyldMemoryManager::getSymbolAddressInProcess(name);
+    }
+
+private:
+    const std::unordered_map<std::string, uint64_t> &symbols;
+};
+
+#ifdef __linux__
+/**
+ * \brief Writes the symbols of emitted objects in the format of perf maps, one `address size name` line per function.
+ *
+ * The names are written demangled, the way reports show the functions of native C++ code.
+ */
+class PerfMapListener : public llvm::JITEventListener {
+
+public:
+    PerfMapListener() : file(std::fopen(("/tmp/perf-" + std::to_string(getpid()) + ".map").c_str(), "a")) {
+        if (!file) {
+            LOG("Unable to open the perf map");
+        }
+    }
+
+    ~PerfMapListener() {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+
+    void NotifyObjectEmitted(const llvm::object::ObjectFile &obj,
+            const llvm::RuntimeDyld::LoadedObjectInfo &info) override {
+        if (!file) {
+            return;
+        }
+        //the symbols of the copy for debuggers have the addresses at which the sections have been loaded
+        llvm::object::OwningBinary<llvm::object::ObjectFile> debugObj = info.getObjectForDebug(obj);
+        for (const auto &p : llvm::object::computeSymbolSizes(*debugObj.getBinary())) {
+            const llvm::object::SymbolRef &sym = p.first;
+            if (sym.getType() != llvm::object::SymbolRef::ST_Function || p.second == 0) {
+                continue;
+            }
+            llvm::Expected<llvm::StringRef> name = sym.getName();
+            if (!name) {
+                llvm::consumeError(name.takeError());
+                continue;
+            }
+            llvm::Expected<uint64_t> address = sym.getAddress();
+            if (!address) {
+                llvm::consumeError(address.takeError());
+                continue;
+            }
+            std::string mangled = name->str();
+            int status;
+            char *demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+            std::fprintf(file, "%llx %llx %s\n", static_cast<unsigned long long>(*address),
+                    static_cast<unsigned long long>(p.second), demangled ? demangled : mangled.c_str());
+            std::free(demangled);
+        }
+        std::fflush(file);
+    }
+
+private:
+    std::FILE *file;
+};
+#endif
+
+JitEngine::JitEngine() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+}
+
+void JitEngine::bindRuntime(Helper &helper) {
+    #define BIND(F) bind(helper.lf_ ## F, reinterpret_cast<uintptr_t>(&nrt::F))
+    BIND(qint_to_qvalue);
+    BIND(qvalue_to_qbool);
+    BIND(qbool_to_qvalue);
+    BIND(env_load);
+    BIND(globalVariable_initValue);
+    BIND(globalVariable_setValue);
+    BIND(globalVariable_getValue);
+    BIND(globalVariable_readLock);
+    BIND(globalVariable_readUnlock);
+    BIND(globalVariable_writeLock);
+    BIND(globalVariable_writeUnlock);
+    BIND(type_String);
+    BIND(global_load);
+    BIND(global_load_ref);
+    BIND(ref_dec);
+    BIND(ref_dec_deferred);
+    BIND(ref_dec_noexcept);
+    BIND(ref_inc);
+    BIND(ref_reclaim);
+    BIND(conversionCache_invoke);
+    BIND(binaryOperatorCache_invoke);
+    #undef BIND
+    //referenced only by the runtime bitcode, see RuntimeBitcode
+    symbols["refCounted_ownerSlot"] = reinterpret_cast<uintptr_t>(&refCounted_ownerSlot);
+
+    for (auto &p : helper.getConversions()) {
+        bind(p.second, reinterpret_cast<uintptr_t>(&p.first->getFunction()));
+    }
+    for (auto &p : helper.getBinaryOperators()) {
+        bind(p.second, reinterpret_cast<uintptr_t>(&p.first->getFunction()));
+    }
+    for (auto &p : helper.getCachedConversions()) {
+        llvm::Function *fn = p.second;
+        fn->setLinkage(llvm::GlobalValue::PrivateLinkage);
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(helper.ctx, "entry", fn));
+        auto it = fn->arg_begin();
+        llvm::Value *cache = &*it++;
+        llvm::Value *value = &*it;
+        llvm::Value *args[3] = { cache, address(helper, helper.lt_Type_ptr, &p.first->getToType()), value };
+        builder.CreateRet(builder.CreateCall(helper.lf_conversionCache_invoke, args));
+    }
+    for (auto &p : helper.getCachedBinaryOperators()) {
+        llvm::Function *fn = p.second;
+        fn->setLinkage(llvm::GlobalValue::PrivateLinkage);
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(helper.ctx, "entry", fn));
+        auto it = fn->arg_begin();
+        llvm::Value *cache = &*it++;
+        llvm::Value *left = &*it++;
+        llvm::Value *right = &*it;
+        llvm::Value *kind = llvm::ConstantInt::get(helper.lt_int32, static_cast<int>(p.first->getKind()));
+        llvm::Value *args[4] = { cache, kind, left, right };
+        builder.CreateRet(builder.CreateCall(helper.lf_binaryOperatorCache_invoke, args));
+    }
+}
+
+void JitEngine::enablePerfMap() {
+#ifdef __linux__
+    if (!perfMap) {
+        perfMap.reset(new PerfMapListener());
+        if (engine) {
+            engine->RegisterJITEventListener(perfMap.get());
+        }
+    }
+#endif
+}
+
+bool JitEngine::addModule(std::unique_ptr<llvm::Module> module) {
+    if (!engine) {
+        std::string error;
+        engine.reset(llvm::EngineBuilder(std::move(module))
+                .setEngineKind(llvm::EngineKind::JIT)
+                .setErrorStr(&error)
+                .setMCJITMemoryManager(std::unique_ptr<llvm::RTDyldMemoryManager>(new RuntimeMemoryManager(symbols)))
+                .create());
+        if (!engine) {
+            LOG("Unable to create the execution engine: " << error);
+            return false;
+        }
+        if (perfMap) {
+            engine->RegisterJITEventListener(perfMap.get());
+        }
+    } else {
+        engine->addModule(std::move(module));
+    }
+    engine->finalizeObject();
+    return true;
+}
+///\endcond
+
+} // namespace cg
+} // namespace qore
+#endif // QORE_ENABLE_JIT
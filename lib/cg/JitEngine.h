@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the execution engine shared by the JIT compilers.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_JITENGINE_H_
+#define LIB_CG_JITENGINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
+#include "Helper.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Executes modules in the running process using MCJIT.
+ *
+ * The runtime is linked statically with hidden visibility, so the declarations of its functions are bound to their
+ * addresses explicitly instead of being looked up in the process.
+ */
+class JitEngine {
+
+public:
+    JitEngine();
+
+    /**
+     * \brief Binds the declarations of runtime functions created by a helper to their addresses.
+     *
+     * Must be called after all code of the module has been generated. The cached variants of dynamic conversions
+     * and operators are defined in the module in terms of the generic nrt wrappers of the inline caches.
+     */
+    void bindRuntime(Helper &helper);
+
+    /**
+     * \brief Binds a declaration of a function to an address.
+     */
+    void bind(llvm::Function *f, uintptr_t address) {
+        symbols[f->getName().str()] = address;
+    }
+
+    /**
+     * \brief Appends the names and addresses of the functions of the modules added from now on to
+     * `/tmp/perf-<pid>.map`, where `perf` looks for symbols of JIT-compiled code.
+     *
+     * Does nothing on systems other than Linux.
+     */
+    void enablePerfMap();
+
+    /**
+     * \brief Generates native code for a module and makes it available for execution.
+     * \return false if the execution engine cannot be created
+     */
+    bool addModule(std::unique_ptr<llvm::Module> module);
+
+    /**
+     * \brief Returns the address of a function with external linkage in one of the added modules.
+     */
+    uint64_t getFunctionAddress(const std::string &name) {
+        return engine->getFunctionAddress(name);
+    }
+
+    /**
+     * \brief Returns a constant of given pointer type with the address of a runtime object.
+     */
+    static llvm::Constant *address(Helper &helper, llvm::Type *type, const void *ptr) {
+        return llvm::ConstantExpr::getIntToPtr(
+                llvm::ConstantInt::get(helper.lt_qint, reinterpret_cast<uintptr_t>(ptr)), type);
+    }
+
+private:
+    std::unordered_map<std::string, uint64_t> symbols;
+    std::unique_ptr<llvm::JITEventListener> perfMap;
+    std::unique_ptr<llvm::ExecutionEngine> engine;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_JITENGINE_H_
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the optimizer of generated modules.
+///
+//------------------------------------------------------------------------------
+#include "Optimizer.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "qore/core/util/Debug.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+std::chrono::microseconds Optimizer::run(llvm::Module &module) const {
+    Stopwatch stopwatch;
+    unsigned optLevel = static_cast<unsigned>(level);
+    if (optLevel == 0) {
+        return stopwatch.elapsed();
+    }
+
+    llvm::PassManagerBuilder builder;
+    builder.OptLevel = optLevel;
+    builder.SizeLevel = 0;
+    builder.Inliner = optLevel > 1 ? llvm::createFunctionInliningPass(optLevel, 0) : llvm::createAlwaysInlinerPass();
+    builder.LoopVectorize = optLevel > 1;
+    builder.SLPVectorize = optLevel > 1;
+
+    llvm::legacy::FunctionPassManager fpm(&module);
+    llvm::legacy::PassManager mpm;
+    builder.populateFunctionPassManager(fpm);
+    builder.populateModulePassManager(mpm);
+
+    fpm.doInitialization();
+    for (llvm::Function &f : module) {
+        fpm.run(f);
+    }
+    fpm.doFinalization();
+    mpm.run(module);
+
+    std::chrono::microseconds time = stopwatch.elapsed();
+    LOG("Optimized " << module.getName().str() << " at O" << optLevel << " in " << time.count() << " us");
+    return time;
+}
+///\endcond
+
+} // namespace cg
+} // namespace qore
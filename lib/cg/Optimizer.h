@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the optimizer of generated modules.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_OPTIMIZER_H_
+#define LIB_CG_OPTIMIZER_H_
+
+#include <chrono>
+#include "llvm/IR/Module.h"
+#include "qore/cg/Optimization.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+class Optimizer {
+
+public:
+    explicit Optimizer(OptLevel level) : level(level) {
+    }
+
+    /**
+     * \brief Runs the pass pipeline of the optimization level over a module.
+     * \param module the module to optimize, must have been verified
+     * \return the time spent
+     */
+    std::chrono::microseconds run(llvm::Module &module) const;
+
+private:
+    OptLevel level;
+};
+
+/**
+ * \brief Measures the time elapsed since construction.
+ */
+class Stopwatch {
+
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {
+    }
+
+    std::chrono::microseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_OPTIMIZER_H_
@@ -0,0 +1,248 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implements the parallel generation of LLVM modules.
+///
+//------------------------------------------------------------------------------
+#include "ParallelCompiler.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "qore/core/util/Debug.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+namespace {
+
+struct Partition {
+    std::vector<const Function *> functions;
+    Size size{0};
+    std::string bitcode;
+    std::chrono::microseconds optimization{0};
+    std::string error;
+    std::exception_ptr exception;
+};
+
+/**
+ * \brief The names of the symbols of the main module, copied so that the workers never touch its context.
+ */
+struct Symbols {
+    std::unordered_map<const String *, std::string> strings;
+    std::unordered_map<const GlobalVariable *, std::string> globals;
+    std::unordered_map<const Function *, std::string> functions;
+    std::string mainFile;       //!< The name of the compile units, empty if no debug information is generated.
+};
+
+Size estimateSize(const Function &f) {
+    Size size = 0;
+    for (const code::Block &b : f.getBlocks()) {
+        size += b.end() - b.begin();
+    }
+    return size;
+}
+
+/**
+ * \brief Collects the errors reported by the linker instead of letting the context print them and exit.
+ */
+class LinkerDiagnostics {
+
+public:
+    LinkerDiagnostics(llvm::LLVMContext &ctx, std::string &error) : ctx(ctx), oldHandler(ctx.getDiagnosticHandler()),
+            oldContext(ctx.getDiagnosticContext()), os(error) {
+        ctx.setDiagnosticHandler(handle, this);
+    }
+
+    ~LinkerDiagnostics() {
+        ctx.setDiagnosticHandler(oldHandler, oldContext);
+    }
+
+private:
+    static void handle(const llvm::DiagnosticInfo &info, void *context) {
+        LinkerDiagnostics *self = static_cast<LinkerDiagnostics *>(context);
+        if (info.getSeverity() == llvm::DS_Error) {
+            llvm::DiagnosticPrinterRawOStream printer(self->os);
+            info.print(printer);
+            self->os << '\n';
+            self->os.flush();
+        }
+    }
+
+private:
+    llvm::LLVMContext &ctx;
+    llvm::LLVMContext::DiagnosticHandlerTy oldHandler;
+    void *oldContext;
+    llvm::raw_string_ostream os;
+};
+
+void compilePartition(Partition &partition, const Symbols &symbols, const ParallelCompiler::Finish &finish) {
+    llvm::LLVMContext ctx;
+    Helper helper(ctx);
+    FunctionContext::StringsMap strings;
+    FunctionContext::GlobalsMap globals;
+    FunctionContext::FunctionsMap functions;
+    for (auto &p : symbols.strings) {
+        strings[p.first] = new llvm::GlobalVariable(*helper.module, helper.lt_qvalue, false,
+                llvm::GlobalValue::ExternalLinkage, nullptr, p.second);
+    }
+    for (auto &p : symbols.globals) {
+        globals[p.first] = new llvm::GlobalVariable(*helper.module, helper.lt_GlobalVariable_ptr, false,
+                llvm::GlobalValue::ExternalLinkage, nullptr, p.second);
+    }
+    for (auto &p : symbols.functions) {
+        functions[p.first] = helper.declareFunction(p.second, *p.first);
+    }
+
+    std::unique_ptr<DebugInfo> debugInfo;
+    if (!symbols.mainFile.empty()) {
+        debugInfo = util::make_unique<DebugInfo>(*helper.module, symbols.mainFile);
+    }
+    for (const Function *f : partition.functions) {
+        FunctionCompiler fc(*f, strings, globals, functions, functions[f], helper, debugInfo.get());
+        fc.compile();
+    }
+    if (debugInfo) {
+        debugInfo->finalize();
+    }
+
+    llvm::raw_string_ostream os(partition.error);
+    if (llvm::verifyModule(*helper.module, &os)) {
+        os.flush();
+        return;
+    }
+    partition.optimization = finish(helper);
+
+    llvm::raw_string_ostream out(partition.bitcode);
+    llvm::WriteBitcodeToFile(helper.module.get(), out);
+    out.flush();
+}
+
+} // namespace
+
+std::unique_ptr<llvm::Module> ParallelCompiler::compile(Compiler &compiler, Env &env, const Finish &finish,
+        std::chrono::microseconds &optimization, std::string &error) const {
+    compiler.declare(env);
+    Helper &helper = compiler.getHelper();
+
+    //the partitions refer to the strings and global variables of the main module by name
+    Symbols symbols;
+    if (compiler.hasDebugInfo()) {
+        symbols.mainFile = Compiler::getMainFile(env);
+    }
+    for (auto &p : compiler.getStrings()) {
+        p.second->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        symbols.strings[p.first] = p.second->getName().str();
+    }
+    for (auto &p : compiler.getGlobals()) {
+        p.second->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        symbols.globals[p.first] = p.second->getName().str();
+    }
+    std::vector<std::pair<Size, const Function *>> bySize;
+    for (auto &p : compiler.getFunctions()) {
+        symbols.functions[p.first] = p.second->getName().str();
+        bySize.emplace_back(estimateSize(*p.first), p.first);
+    }
+
+    //largest functions first, each to the partition with the least code so far
+    std::sort(bySize.begin(), bySize.end(), [&symbols](const std::pair<Size, const Function *> &l,
+            const std::pair<Size, const Function *> &r) {
+        return l.first != r.first ? l.first > r.first : symbols.functions.at(l.second) < symbols.functions.at(r.second);
+    });
+    std::vector<Partition> partitions(std::max<Size>(1, std::min<Size>(threads, bySize.size())));
+    for (auto &p : bySize) {
+        Partition &smallest = *std::min_element(partitions.begin(), partitions.end(),
+                [](const Partition &l, const Partition &r) { return l.size < r.size; });
+        smallest.functions.push_back(p.second);
+        smallest.size += p.first;
+    }
+
+    std::vector<std::thread> workers;
+    for (Partition &partition : partitions) {
+        workers.emplace_back([&partition, &symbols, &finish]() {
+            try {
+                compilePartition(partition, symbols, finish);
+            } catch (...) {
+                partition.exception = std::current_exception();
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    optimization = std::chrono::microseconds(0);
+    for (Partition &partition : partitions) {
+        if (partition.exception) {
+            std::rethrow_exception(partition.exception);
+        }
+        if (!partition.error.empty()) {
+            error = partition.error;
+            return nullptr;
+        }
+        optimization = std::max(optimization, partition.optimization);
+        auto module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(partition.bitcode, "partition"), helper.ctx);
+        if (!module) {
+            error = "invalid bitcode of a partition: " + module.getError().message();
+            return nullptr;
+        }
+        std::string linkError;
+        LinkerDiagnostics diagnostics(helper.ctx, linkError);
+        if (llvm::Linker::linkModules(*helper.module, std::move(module.get()))) {
+            error = "unable to link a partition: " + linkError;
+            return nullptr;
+        }
+    }
+
+    //the linker replaces the declarations of the functions defined by the partitions
+    for (auto &p : symbols.functions) {
+        compiler.updateFunction(*p.first, helper.module->getFunction(p.second));
+    }
+    for (auto &p : compiler.getStrings()) {
+        p.second->setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+    for (auto &p : compiler.getGlobals()) {
+        p.second->setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+    LOG("Compiled " << symbols.functions.size() << " functions in " << partitions.size() << " partitions");
+    return std::move(helper.module);
+}
+///\endcond
+
+} // namespace cg
+} // namespace qore
@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the parallel generation of LLVM modules.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_PARALLELCOMPILER_H_
+#define LIB_CG_PARALLELCOMPILER_H_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include "llvm/IR/Module.h"
+#include "qore/core/Env.h"
+#include "Compiler.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Generates the code of the functions of an environment on multiple threads.
+ *
+ * The functions are split into partitions of similar size. Each partition is compiled on its own thread into a
+ * module of a separate `LLVMContext` in which the strings, global variables and functions are declared by their
+ * names in the main module. The finished partitions are transferred to the context of the main module as bitcode
+ * and linked into it, so the callers get a single module just like from \ref Compiler::compile().
+ *
+ * Since the partitions are optimized separately, calls across partitions are never inlined.
+ */
+class ParallelCompiler {
+
+public:
+    /**
+     * \brief Called on the worker thread once the code of a partition has been generated.
+     *
+     * Usually links the runtime bitcode and runs the optimizer. Must not touch anything shared with the other
+     * threads without synchronization. Returns the time spent in the optimizer.
+     */
+    using Finish = std::function<std::chrono::microseconds(Helper &helper)>;
+
+public:
+    /**
+     * \brief Constructor.
+     * \param threads the maximum number of threads to use
+     */
+    explicit ParallelCompiler(unsigned threads) : threads(threads) {
+    }
+
+    /**
+     * \brief Generates `qstart` and the code of all functions.
+     *
+     * Exceptions thrown by the workers (e.g. util::NotImplemented) are rethrown.
+     * \param compiler generates `qstart` and the declarations in the main module
+     * \param env the environment to compile
+     * \param finish called for each verified partition on its worker thread
+     * \param optimization receives the longest time a partition spent in the optimizer; since the partitions are
+     * optimized concurrently, this is the part of the wall-clock time that went into optimization
+     * \param error receives the description of the problem if the code of a partition is broken or cannot be
+     * linked into the main module
+     * \return the main module with the partitions linked in or null in case of an error
+     */
+    std::unique_ptr<llvm::Module> compile(Compiler &compiler, Env &env, const Finish &finish,
+            std::chrono::microseconds &optimization, std::string &error) const;
+
+private:
+    unsigned threads;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_PARALLELCOMPILER_H_
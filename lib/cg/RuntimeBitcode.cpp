@@ -0,0 +1,309 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the linker of the runtime bitcode.
+///
+//------------------------------------------------------------------------------
+#include "RuntimeBitcode.h"
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "qore/core/Defs.h"
+#include "qore/core/util/Debug.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Collects the global values referenced by a value, looking through constant expressions and aggregates.
+ */
+static void collectReferences(const llvm::Value *v, std::unordered_set<const llvm::GlobalValue *> &refs) {
+    if (const llvm::GlobalValue *gv = llvm::dyn_cast<llvm::GlobalValue>(v)) {
+        refs.insert(gv);
+    } else if (const llvm::Constant *c = llvm::dyn_cast<llvm::Constant>(v)) {
+        for (const llvm::Value *op : c->operands()) {
+            collectReferences(op, refs);
+        }
+    }
+}
+
+static std::unordered_set<const llvm::GlobalValue *> collectReferences(const llvm::Function &f) {
+    std::unordered_set<const llvm::GlobalValue *> refs;
+    if (f.hasPersonalityFn()) {
+        collectReferences(f.getPersonalityFn(), refs);
+    }
+    for (const llvm::BasicBlock &bb : f) {
+        for (const llvm::Instruction &ins : bb) {
+            for (const llvm::Value *op : ins.operands()) {
+                collectReferences(op, refs);
+            }
+        }
+    }
+    return refs;
+}
+
+/**
+ * \brief Returns true if a linked global variable can be duplicated in the module.
+ */
+static bool isImmutable(const llvm::GlobalVariable &gv) {
+    if (!gv.isConstant() || !gv.hasInitializer()) {
+        return false;
+    }
+    std::unordered_set<const llvm::GlobalValue *> refs;
+    collectReferences(gv.getInitializer(), refs);
+    return refs.empty();
+}
+
+static llvm::Value *coerce(llvm::IRBuilder<> &builder, llvm::Value *v, llvm::Type *type) {
+    if (v->getType() == type) {
+        return v;
+    }
+    llvm::Value *slot = builder.CreateAlloca(v->getType());
+    builder.CreateStore(v, slot);
+    return builder.CreateLoad(builder.CreateBitCast(slot, type->getPointerTo()));
+}
+
+static bool isCoercible(const llvm::DataLayout &dl, llvm::Type *from, llvm::Type *to) {
+    if (from == to) {
+        return true;
+    }
+    return from->isSized() && to->isSized() && dl.getTypeStoreSize(from) == dl.getTypeStoreSize(to);
+}
+
+static bool isCoercible(const llvm::DataLayout &dl, llvm::FunctionType *from, llvm::FunctionType *to) {
+    if (from->getNumParams() != to->getNumParams() || from->isVarArg() || to->isVarArg()) {
+        return false;
+    }
+    if (from->getReturnType()->isVoidTy() != to->getReturnType()->isVoidTy()) {
+        return false;
+    }
+    if (!from->getReturnType()->isVoidTy() && !isCoercible(dl, to->getReturnType(), from->getReturnType())) {
+        return false;
+    }
+    for (unsigned i = 0; i < from->getNumParams(); ++i) {
+        if (!isCoercible(dl, from->getParamType(i), to->getParamType(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief Creates a function of given type which coerces its arguments and calls `target`.
+ */
+static llvm::Function *createThunk(llvm::Function *target, llvm::FunctionType *type) {
+    llvm::Function *thunk = llvm::Function::Create(type, llvm::GlobalValue::PrivateLinkage,
+            target->getName() + ".thunk", target->getParent());
+    thunk->addFnAttr(llvm::Attribute::AlwaysInline);
+    if (target->doesNotThrow()) {
+        thunk->setDoesNotThrow();
+    }
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(target->getContext(), "entry", thunk));
+    std::vector<llvm::Value *> args;
+    unsigned i = 0;
+    for (auto it = thunk->arg_begin(); it != thunk->arg_end(); ++it) {
+        args.push_back(coerce(builder, &*it, target->getFunctionType()->getParamType(i++)));
+    }
+    llvm::CallInst *call = builder.CreateCall(target, args);
+    call->setCallingConv(target->getCallingConv());
+    call->setAttributes(target->getAttributes());
+    if (type->getReturnType()->isVoidTy()) {
+        builder.CreateRetVoid();
+    } else {
+        builder.CreateRet(coerce(builder, call, type->getReturnType()));
+    }
+    return thunk;
+}
+
+/**
+ * \brief Replaces calls through bitcasts created by the linker for mismatched signatures with calls of thunks.
+ */
+static void createThunks(llvm::Module &module) {
+    std::vector<std::pair<llvm::ConstantExpr *, llvm::Function *>> casts;
+    for (llvm::Function &f : module) {
+        for (llvm::User *u : f.users()) {
+            llvm::ConstantExpr *ce = llvm::dyn_cast<llvm::ConstantExpr>(u);
+            if (ce && ce->getOpcode() == llvm::Instruction::BitCast) {
+                casts.emplace_back(ce, &f);
+            }
+        }
+    }
+    std::map<std::pair<llvm::Function *, llvm::Type *>, llvm::Function *> thunks;
+    for (auto &p : casts) {
+        llvm::PointerType *ptrType = llvm::cast<llvm::PointerType>(p.first->getType());
+        llvm::FunctionType *type = llvm::dyn_cast<llvm::FunctionType>(ptrType->getElementType());
+        if (!type || !isCoercible(module.getDataLayout(), type, p.second->getFunctionType())) {
+            continue;
+        }
+        llvm::Function *&thunk = thunks[std::make_pair(p.second, type)];
+        if (!thunk) {
+            thunk = createThunk(p.second, type);
+        }
+        p.first->replaceAllUsesWith(thunk);
+    }
+}
+
+RuntimeBitcode::RuntimeBitcode(llvm::LLVMContext &ctx) {
+    const char *path = std::getenv("QORE_NRT_BITCODE");
+#ifdef QORE_NRT_BITCODE
+    if (!path) {
+        path = QORE_NRT_BITCODE;
+    }
+#endif
+    if (!path) {
+        return;
+    }
+    llvm::SMDiagnostic err;
+    library = llvm::parseIRFile(path, err, ctx);
+    if (!library) {
+        LOG("Cannot load the runtime bitcode " << path << ": " << err.getMessage().str());
+    }
+}
+
+void RuntimeBitcode::link(llvm::Module &module) const {
+    if (!library) {
+        return;
+    }
+
+    //the declarations of the module are bound to the runtime, refCounted_ownerSlot is bound by JitEngine
+    std::unordered_set<std::string> resolvable{"refCounted_ownerSlot"};
+    std::unordered_set<std::string> defined;
+    for (llvm::Function &f : module) {
+        (f.isDeclaration() ? resolvable : defined).insert(f.getName().str());
+    }
+    for (llvm::GlobalVariable &gv : module.globals()) {
+        defined.insert(gv.getName().str());
+    }
+    if (module.getTargetTriple().empty()) {
+        module.setTargetTriple(library->getTargetTriple());
+    }
+    if (module.getDataLayout().isDefault()) {
+        module.setDataLayout(library->getDataLayout());
+    }
+
+    if (llvm::Linker::linkModules(module, llvm::CloneModule(library.get()), llvm::Linker::Flags::LinkOnlyNeeded)) {
+        LOG("Linking of the runtime bitcode into " << module.getName().str() << " failed");
+        return;
+    }
+
+    std::vector<llvm::Function *> linked;
+    std::unordered_set<const llvm::GlobalValue *> kept;
+    for (llvm::Function &f : module) {
+        if (!f.isDeclaration() && !defined.count(f.getName().str())) {
+            linked.push_back(&f);
+            kept.insert(&f);
+        }
+    }
+    std::vector<llvm::GlobalVariable *> linkedGlobals;
+    for (llvm::GlobalVariable &gv : module.globals()) {
+        if (!defined.count(gv.getName().str())) {
+            linkedGlobals.push_back(&gv);
+            if (isImmutable(gv)) {
+                kept.insert(&gv);
+            }
+        }
+    }
+
+    auto accepts = [&](const llvm::GlobalValue *gv) {
+        if (kept.count(gv)) {
+            return true;
+        }
+        const llvm::Function *f = llvm::dyn_cast<llvm::Function>(gv);
+        return f && (f->isIntrinsic() || resolvable.count(f->getName().str()));
+    };
+    bool changed;
+    do {
+        changed = false;
+        for (llvm::Function *f : linked) {
+            if (!kept.count(f)) {
+                continue;
+            }
+            for (const llvm::GlobalValue *ref : collectReferences(*f)) {
+                if (!accepts(ref)) {
+                    LOG("Runtime function " << f->getName().str() << " refers to " << ref->getName().str());
+                    kept.erase(f);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+
+    Size count = 0;
+    std::vector<llvm::GlobalValue *> dropped;
+    for (llvm::Function *f : linked) {
+        f->setComdat(nullptr);
+        if (!kept.count(f)) {
+            f->deleteBody();
+            dropped.push_back(f);
+        } else if (resolvable.count(f->getName().str())) {
+            f->setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+            ++count;
+        } else {
+            f->setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    for (llvm::GlobalVariable *gv : linkedGlobals) {
+        gv->setComdat(nullptr);
+        if (kept.count(gv)) {
+            gv->setLinkage(llvm::GlobalValue::InternalLinkage);
+        } else {
+            gv->setInitializer(nullptr);
+            gv->setLinkage(llvm::GlobalValue::ExternalLinkage);
+            dropped.push_back(gv);
+        }
+    }
+    //remove the dropped declarations which are no longer referenced, only the bound ones should remain
+    do {
+        changed = false;
+        for (auto it = dropped.begin(); it != dropped.end();) {
+            if ((*it)->use_empty()) {
+                (*it)->eraseFromParent();
+                it = dropped.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    } while (changed);
+    createThunks(module);
+    LOG("Linked " << count << " runtime functions into " << module.getName().str());
+}
+///\endcond
+
+} // namespace cg
+} // namespace qore
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Defines the linker of the runtime bitcode.
+///
+//------------------------------------------------------------------------------
+#ifndef LIB_CG_RUNTIMEBITCODE_H_
+#define LIB_CG_RUNTIMEBITCODE_H_
+
+#include <memory>
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+namespace qore {
+namespace cg {
+
+///\cond
+/**
+ * \brief Links the bodies of runtime functions into generated modules so that the optimizer can inline them.
+ *
+ * The bitcode of the nrt wrappers and of the operator and conversion implementations is built together with the
+ * runtime (see lib/nrt/CMakeLists.txt) and its path is compiled in as `QORE_NRT_BITCODE`. The environment variable
+ * of the same name overrides it.
+ *
+ * Only the bodies that can be executed by generated code are kept: a function may refer only to other kept
+ * functions, to constants and to functions which the module already declared (and which are therefore bound to
+ * their addresses in the process). Runtime functions get `available_externally` linkage, so they are never emitted
+ * and calls that are not inlined still go to the runtime. The remaining linked functions are dropped to
+ * declarations.
+ *
+ * Clang lowers `qvalue` to an integer in function signatures while the generated code passes the structure type;
+ * calls of the linked functions go through small always-inline thunks which coerce the arguments.
+ */
+class RuntimeBitcode {
+
+public:
+    explicit RuntimeBitcode(llvm::LLVMContext &ctx);
+
+    /**
+     * \brief Returns true if the bitcode has been loaded.
+     */
+    bool isAvailable() const {
+        return static_cast<bool>(library);
+    }
+
+    /**
+     * \brief Links the bodies of the runtime functions declared in a module.
+     *
+     * Must be called after all code has been generated and before the optimizer runs. Does nothing if the bitcode
+     * is not available.
+     */
+    void link(llvm::Module &module) const;
+
+private:
+    std::unique_ptr<llvm::Module> library;
+};
+///\endcond
+
+} // namespace cg
+} // namespace qore
+
+#endif // LIB_CG_RUNTIMEBITCODE_H_
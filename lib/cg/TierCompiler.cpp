@@ -0,0 +1,238 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the compiler of hot functions.
+///
+//------------------------------------------------------------------------------
+#include "qore/cg/TierCompiler.h"
+#ifdef QORE_ENABLE_JIT
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
+#include "FunctionCompiler.h"
+#include "JitEngine.h"
+#include "Optimizer.h"
+#include "RuntimeBitcode.h"
+#endif
+
+namespace qore {
+namespace cg {
+
+#ifdef QORE_ENABLE_JIT
+///\cond
+/**
+ * \brief Collects the runtime objects referenced by the code of a function.
+ */
+class References {
+
+public:
+    using ReturnType = void;
+
+public:
+    explicit References(const Function &f) {
+        for (const code::Block &b : f.getBlocks()) {
+            for (const code::Instruction &ins : b) {
+                ins.accept(*this);
+            }
+        }
+    }
+
+    void visit(const code::ConstString &ins) {
+        strings.insert(&ins.getString());
+    }
+
+    #define GLOBAL(K) void visit(const code::K &ins) { globals.insert(&ins.getGlobalVariable()); }
+    GLOBAL(GlobalGet)
+    GLOBAL(GlobalInit)
+    GLOBAL(GlobalLoad)
+    GLOBAL(GlobalLoadRef)
+    GLOBAL(GlobalReadLock)
+    GLOBAL(GlobalReadUnlock)
+    GLOBAL(GlobalSet)
+    GLOBAL(GlobalWriteLock)
+    GLOBAL(GlobalWriteUnlock)
+    #undef GLOBAL
+
+    void visit(const code::InvokeFunction &ins) {
+        functions.insert(&ins.getFunction());
+    }
+
+    void visit(const code::Instruction &ins) {
+    }
+
+public:
+    std::unordered_set<const String *> strings;
+    std::unordered_set<const GlobalVariable *> globals;
+    std::unordered_set<const Function *> functions;
+};
+
+class TierCompiler::Impl {
+
+public:
+    Impl(Trampoline trampoline, OptLevel level) : trampoline(trampoline), optimizer(level),
+            bitcode(llvm::getGlobalContext()), counter(0) {
+    }
+
+    NativeCode compile(const Function &f, const Linker &linker) {
+        Stopwatch generation;
+        Helper helper;
+        std::string name = "tier." + std::to_string(counter++);
+        llvm::Function *func = declare(helper, f, name, llvm::GlobalValue::ExternalLinkage);
+        llvm::Function *lf_trampoline = helper.createFunction("tier_trampoline", helper.lt_qvalue, helper.lt_void_ptr,
+                helper.lt_qvalue->getPointerTo(), helper.lt_qint);
+        engine.bind(lf_trampoline, reinterpret_cast<uintptr_t>(trampoline));
+
+        References refs(f);
+        FunctionContext::StringsMap strings;
+        FunctionContext::GlobalsMap globals;
+        FunctionContext::FunctionsMap functions;
+        for (const String *s : refs.strings) {
+            llvm::Constant *bits = llvm::ConstantInt::get(helper.lt_qint, reinterpret_cast<uintptr_t>(s));
+            strings[s] = new llvm::GlobalVariable(*helper.module, helper.lt_qvalue, true,
+                    llvm::GlobalValue::PrivateLinkage,
+                    llvm::ConstantStruct::get(llvm::cast<llvm::StructType>(helper.lt_qvalue), bits), "str");
+        }
+        for (const GlobalVariable *gv : refs.globals) {
+            globals[gv] = new llvm::GlobalVariable(*helper.module, helper.lt_GlobalVariable_ptr, true,
+                    llvm::GlobalValue::PrivateLinkage, JitEngine::address(helper, helper.lt_GlobalVariable_ptr, gv),
+                    "gv");
+        }
+        for (const Function *callee : refs.functions) {
+            functions[callee] = callee == &f ? func : createStub(helper, lf_trampoline, *callee, linker(*callee));
+        }
+
+        try {
+            FunctionCompiler fc(f, strings, globals, functions, func, helper);
+            fc.compile();
+        } catch (util::NotImplemented &) {
+            return nullptr;
+        }
+        helper.createEntry(*helper.module, func, name + ".entry");
+        engine.bindRuntime(helper);
+        bitcode.link(*helper.module);
+
+        std::string error;
+        llvm::raw_string_ostream os(error);
+        if (llvm::verifyModule(*helper.module, &os)) {
+            LOG("Generated code of " << name << " is broken: " << os.str());
+            return nullptr;
+        }
+        CompileTimes t;
+        t.generation = generation.elapsed();
+        t.optimization = optimizer.run(*helper.module);
+
+        Stopwatch emission;
+        if (!engine.addModule(std::move(helper.module))) {
+            return nullptr;
+        }
+        NativeCode code = reinterpret_cast<NativeCode>(engine.getFunctionAddress(name + ".entry"));
+        t.emission = emission.elapsed();
+        times += t;
+        return code;
+    }
+
+private:
+    static llvm::Function *declare(Helper &helper, const Function &f, const std::string &name,
+            llvm::GlobalValue::LinkageTypes linkage) {
+        std::vector<llvm::Type *> args(f.getType().getParameterCount(), helper.lt_qvalue);
+        llvm::Type *ret = f.getType().getReturnType() == Type::Nothing ? helper.lt_void : helper.lt_qvalue;
+        return llvm::Function::Create(llvm::FunctionType::get(ret, args, false), linkage, name, helper.module.get());
+    }
+
+    /**
+     * \brief Creates a function with the signature of `callee` which passes its arguments to the trampoline.
+     */
+    static llvm::Function *createStub(Helper &helper, llvm::Function *lf_trampoline, const Function &callee,
+            const void *target) {
+        llvm::Function *stub = declare(helper, callee, "stub", llvm::GlobalValue::PrivateLinkage);
+        llvm::IRBuilder<> builder(llvm::BasicBlock::Create(helper.ctx, "entry", stub));
+        Size argCount = stub->arg_size();
+        llvm::Value *args = llvm::ConstantPointerNull::get(helper.lt_qvalue->getPointerTo());
+        if (argCount) {
+            args = builder.CreateAlloca(helper.lt_qvalue, llvm::ConstantInt::get(helper.lt_int32, argCount), "args");
+            unsigned i = 0;
+            for (auto it = stub->arg_begin(); it != stub->arg_end(); ++it) {
+                builder.CreateStore(&*it, builder.CreateConstGEP1_32(helper.lt_qvalue, args, i++));
+            }
+        }
+        llvm::Value *callArgs[3] = { JitEngine::address(helper, helper.lt_void_ptr, target), args,
+                llvm::ConstantInt::get(helper.lt_qint, argCount) };
+        llvm::Value *ret = builder.CreateCall(lf_trampoline, callArgs);
+        if (stub->getReturnType()->isVoidTy()) {
+            builder.CreateRetVoid();
+        } else {
+            builder.CreateRet(ret);
+        }
+        return stub;
+    }
+
+public:
+    CompileTimes times;
+
+private:
+    Trampoline trampoline;
+    Optimizer optimizer;
+    RuntimeBitcode bitcode;
+    Index counter;
+    JitEngine engine;
+};
+///\endcond
+#else
+///\cond
+class TierCompiler::Impl {
+
+public:
+    Impl(Trampoline trampoline, OptLevel level) {
+    }
+
+    NativeCode compile(const Function &f, const Linker &linker) {
+        return nullptr;
+    }
+
+public:
+    CompileTimes times;
+};
+///\endcond
+#endif
+
+TierCompiler::TierCompiler(Trampoline trampoline, OptLevel level) : impl(new Impl(trampoline, level)) {
+}
+
+TierCompiler::~TierCompiler() = default;
+
+TierCompiler::NativeCode TierCompiler::compile(const Function &f, const Linker &linker) {
+    return impl->compile(f, linker);
+}
+
+const CompileTimes &TierCompiler::getCompileTimes() const {
+    return impl->times;
+}
+
+} // namespace cg
+} // namespace qore
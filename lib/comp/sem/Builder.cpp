@@ -54,6 +54,7 @@ code::Block *Builder::getLandingPad2(std::vector<LocalsStackItem>::reverse_itera
 
     code::Block *savedCurrent = currentBlock;
     code::Block *block = createBlock();
+    block->setLocation(location);
     currentBlock = block;
 
     if (unlockLValue) {
@@ -79,13 +80,14 @@ void Builder::buildLocalsDerefForRet() {
         if (it->lv && it->lv->getType().isRefCounted()) {
             TempHelper temp(*this);
             currentBlock->appendLocalGet(temp, *it->lv);
-            currentBlock->appendRefDec(temp, getLandingPad2(it + 1));
+            appendRefDec(temp, it + 1);
         }
     }
 }
 
 void Builder::localsPush(const LocalVariableInfo &lv) {
     code::Block *b = createBlock();
+    b->setLocation(location);
     {
         TempHelper temp(*this);
         b->appendLocalGet(temp, lv.getRt());
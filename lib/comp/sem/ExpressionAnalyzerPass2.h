@@ -90,6 +90,18 @@ public:
         node.accept(a);
     }
 
+    /**
+     * \brief Determines whether the temporary holding the value of an expression needs to be dereferenced.
+     *
+     * String literals are immortal so their values do not need to be dereferenced even though their type
+     * is reference counted.
+     * \param expr the expression
+     * \return true if the value of the expression needs to be dereferenced
+     */
+    static bool needsDeref(const Expression &expr) {
+        return refCounted(expr) && expr.getKind() != Expression::Kind::StringLiteralRef;
+    }
+
     ///\name Implementation of Expression visitor
     ///\{
     using ReturnType = void;
@@ -113,7 +125,7 @@ public:
     void visit(const CompoundAssignmentExpression &expr) {
         TempHelper right(builder);
         evaluate(right, expr.getRight());
-        right.derefNeeded(refCounted(expr.getRight()));
+        right.derefNeeded(needsDeref(expr.getRight()));
 
         TempHelper old(builder);
         LValue left(builder, expr.getLeft());
@@ -133,7 +145,7 @@ public:
         for (const Expression &arg : expr.getArgs()) {
             args.emplace_back(builder);
             evaluate(args.back(), arg);
-            args.back().derefNeeded(refCounted(arg));
+            args.back().derefNeeded(needsDeref(arg));
         }
         builder.createInvokeFunction(dest, expr.getFunction(), args);
         dest.derefNeeded(expr.getFunction().getType().getReturnType().isRefCounted());
@@ -164,11 +176,11 @@ public:
 
         TempHelper left(builder);
         evaluate(left, expr.getLeft());
-        left.derefNeeded(refCounted(expr.getLeft()));
+        left.derefNeeded(needsDeref(expr.getLeft()));
 
         TempHelper right(builder);
         evaluate(right, expr.getRight());
-        right.derefNeeded(refCounted(expr.getRight()));
+        right.derefNeeded(needsDeref(expr.getRight()));
 
         builder.createInvokeBinaryOperator(dest, expr.getOperator(), left, right);
         dest.derefNeeded(refCounted(expr));
@@ -179,7 +191,7 @@ public:
 
         TempHelper arg(builder);
         evaluate(arg, expr.getArg());
-        arg.derefNeeded(refCounted(expr.getArg()));
+        arg.derefNeeded(needsDeref(expr.getArg()));
 
         builder.createInvokeConversion(dest, expr.getConversion(), arg);
         dest.derefNeeded(refCounted(expr));
@@ -219,8 +231,8 @@ public:
 
     void visit(const StringLiteralRefExpression &expr) {
         noSideEffect();
+        //string literals are immortal, no need to increase the reference count
         builder.createConstString(dest, expr.getString());
-        builder.createRefInc(dest);
     }
     ///\}
 
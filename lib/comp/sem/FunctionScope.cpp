@@ -75,7 +75,7 @@ void FunctionScope::analyze(std::vector<Statement::Ptr> *initializers) {
 
     Statement::Ptr body = StatementAnalyzerPass1::analyze(core, *this, *node.body);
 
-    FunctionBuilder b(rt);
+    FunctionBuilder b(rt, core.getContext().getEnv().getRefCountMode());
 
     for (auto &lv : locals) {
         //change type if lv is shared
@@ -118,6 +118,10 @@ void FunctionScope::analyze(std::vector<Statement::Ptr> *initializers) {
             QORE_UNREACHABLE("");   //missing return statement
         }
     }
+
+    rt.elideRefCounts();
+    rt.fuseInstructions();
+    rt.compactTemps();
 }
 
 } // namespace sem
@@ -84,7 +84,8 @@ public:
     using ReturnType = Statement::Ptr;
 
     Statement::Ptr visit(const ast::ExpressionStatement &node) {
-        return ExpressionStatement::create(ExpressionAnalyzerPass1::eval(core, scope, *node.expression));
+        return ExpressionStatement::create(node.getStart(),
+                ExpressionAnalyzerPass1::eval(core, scope, *node.expression));
     }
 
     Statement::Ptr visit(const ast::CompoundStatement &node) {
@@ -101,12 +102,12 @@ public:
             if (scope.getReturnType() != Type::Nothing) {
                 QORE_UNREACHABLE("report error");
             }
-            return ReturnStatement::create();
+            return ReturnStatement::create(node.getStart());
         }
         if (scope.getReturnType() == Type::Nothing) {
             QORE_UNREACHABLE("report error");
         }
-        return ReturnStatement::create(
+        return ReturnStatement::create(node.getStart(),
                 ExpressionAnalyzerPass1::evalAndConvert(core, scope, scope.getReturnType(), *node.expression));
     }
 
@@ -116,7 +117,8 @@ public:
                 *node.condition);
         Statement::Ptr b1 = analyzeWithNewBlock(core, inner, *node.stmtTrue);
         Statement::Ptr b2 = node.stmtFalse ? analyzeWithNewBlock(core, inner, *node.stmtFalse) : nullptr;
-        return CompoundStatement::create(IfStatement::create(std::move(cond), std::move(b1), std::move(b2)));
+        return CompoundStatement::create(IfStatement::create(node.getStart(), std::move(cond), std::move(b1),
+                std::move(b2)));
     }
 
     Statement::Ptr visit(const ast::TryStatement &node) {
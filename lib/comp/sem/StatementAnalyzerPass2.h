@@ -73,16 +73,19 @@ public:
     }
 
     void visit(const ExpressionStatement &stmt) {
+        builder.setLocation(stmt.getLocation());
         ExpressionAnalyzerPass2::eval(core, builder, stmt.getExpression());
     }
 
     void visit(const GlobalVariableInitializationStatement &stmt) {
+        builder.setLocation(stmt.getLocation());
         TempHelper temp(builder);
         ExpressionAnalyzerPass2::eval(core, builder, temp, stmt.getExpression());
         builder.createGlobalInit(stmt.getGlobalVariable(), temp);
     }
 
     void visit(const IfStatement &stmt) {
+        builder.setLocation(stmt.getLocation());
         code::Block *trueBlock = builder.createBlock();
         code::Block *falseBlock = builder.createBlock();
         {
@@ -118,10 +121,11 @@ public:
     }
 
     void visit(const ReturnStatement &stmt) {
+        builder.setLocation(stmt.getLocation());
         if (stmt.getExpression()) {
             TempHelper temp(builder);
             ExpressionAnalyzerPass2::eval(core, builder, temp, *stmt.getExpression());
-            temp.derefNeeded(stmt.getExpression()->getType().isRefCounted());
+            temp.derefNeeded(ExpressionAnalyzerPass2::needsDeref(*stmt.getExpression()));
             builder.createRet(temp);
             temp.derefDone();
         } else {
@@ -43,29 +43,40 @@ std::ostream &operator<<(std::ostream &os, BinaryOperator::Kind kind) {
     }
 }
 
-const BinaryOperator &BinaryOperator::find(Kind kind, const Type &left, const Type &right) {
-    if (kind == Kind::Plus) {
-        if (left == Type::Any || right == Type::Any) {
-            return AnyPlusAny;
-        }
-        if (left == Type::String || right == Type::String) {
-            return SoftStringPlusSoftString;
-        }
-        if (left == Type::Int || right == Type::Int) {
-            return SoftIntPlusSoftInt;
+BinaryOperator::Table::Table(std::initializer_list<Rule> rules) {
+    for (auto &matrix : entries) {
+        for (auto &row : matrix) {
+            for (const BinaryOperator *&e : row) {
+                e = nullptr;
+            }
         }
     }
-    if (kind == Kind::PlusEquals) {
-        if (left == Type::Any) {
-            return AnyPlusEqualsAny;
-        }
-        if (left == Type::String) {
-            return SoftStringPlusSoftString;
-        }
-        if (left == Type::Int) {
-            return SoftIntPlusSoftInt;
+    for (const Rule &rule : rules) {
+        for (const Cell &cell : rule.cells) {
+            auto &matrix = entries[static_cast<int>(cell.kind)];
+            for (int l = 0; l < Type::KindCount; ++l) {
+                if (cell.left != nullptr && static_cast<int>(cell.left->kind) != l) {
+                    continue;
+                }
+                for (int r = 0; r < Type::KindCount; ++r) {
+                    if (cell.right != nullptr && static_cast<int>(cell.right->kind) != r) {
+                        continue;
+                    }
+                    if (matrix[l][r] == nullptr) {
+                        matrix[l][r] = &rule.op;
+                    }
+                }
+            }
         }
     }
+}
+
+const BinaryOperator &BinaryOperator::find(Kind kind, const Type &left, const Type &right) {
+    const BinaryOperator *op
+            = DispatchTable.entries[static_cast<int>(kind)][static_cast<int>(left.kind)][static_cast<int>(right.kind)];
+    if (op != nullptr) {
+        return *op;
+    }
     QORE_NOT_IMPLEMENTED("Operator " << left.getName() << " " << kind << " " << right.getName());
 }
 
@@ -29,53 +29,32 @@
 ///
 //------------------------------------------------------------------------------
 #include "qore/core/Conversion.h"
+#include <cassert>
 
 namespace qore {
 
-const Conversion *Conversion::find(const Type &src, const Type &dest) {
-    //XXX can be replaced with a table
-    if (src == dest) {
-        return nullptr;
-    }
-    if (dest == Type::String) {
-        if (src == Type::String) {
-            return nullptr;
-        }
-        if (src == Type::Any) {
-            return &AnyToString;
-        }
-    }
-    if (dest == Type::SoftString) {
-        if (src == Type::String) {
-            return nullptr;
-        }
-        if (src == Type::Int) {
-            return &IntToString;
-        }
-        if (src == Type::Any) {
-            return &AnyToString;
+Conversion::Table::Table(std::initializer_list<Rule> rules) {
+    for (auto &row : entries) {
+        for (Entry &e : row) {
+            e = {nullptr, false};
         }
     }
-    if (dest == Type::SoftBool) {
-        if (src == Type::Int) {
-            return &IntToBool;
+    for (const Rule &rule : rules) {
+        for (const Type *to : rule.to) {
+            Entry &e = entries[static_cast<int>(rule.from.kind)][static_cast<int>(to->kind)];
+            assert(!e.exists && "Duplicate conversion rule");
+            e = {rule.conversion, true};
         }
     }
-    if (dest == Type::SoftInt) {
-        if (src == Type::Int) {
-            return nullptr;
-        }
-        if (src == Type::String) {
-            return &StringToInt;
-        }
+}
+
+const Conversion *Conversion::find(const Type &src, const Type &dest) {
+    if (src == dest) {
+        return nullptr;
     }
-    if (dest == Type::Any) {
-        if (src == Type::Int) {
-            return &IntToAny;
-        }
-        if (src == Type::String) {
-            return nullptr;
-        }
+    const Table::Entry &e = DispatchTable.entries[static_cast<int>(src.kind)][static_cast<int>(dest.kind)];
+    if (e.exists) {
+        return e.conversion;
     }
     QORE_NOT_IMPLEMENTED("Conversion " << src.getName() << " to " << dest.getName());
 }
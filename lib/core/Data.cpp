@@ -53,28 +53,69 @@ namespace qore {
     TYPE(SoftString,    "softstring");
 #undef TYPE
 
+/*
+ * Each CONVERSION row defines a conversion and lists the destination types for which Conversion::find() returns it.
+ * IDENTITY rows list the destination types the original type converts to without any code.
+ */
+#define CONVERSIONS(CONVERSION, IDENTITY)                                                                           \
+               /*from       to          canThrow    implicit conversion to*/                                       \
+    CONVERSION(Any,         String,     true,       &Type::String, &Type::SoftString)                               \
+    CONVERSION(Int,         Any,        true,       &Type::Any)                                                     \
+    CONVERSION(Int,         Bool,       false,      &Type::SoftBool)                                                \
+    CONVERSION(Int,         String,     true,       &Type::SoftString)                                              \
+    CONVERSION(String,      Int,        true,       &Type::SoftInt)                                                 \
+    IDENTITY(  Int,                                 &Type::SoftInt)                                                 \
+    IDENTITY(  String,                              &Type::Any, &Type::SoftString)
+
 #define CONVERSION2(NAME, FROM, TO, THROWS) const Conversion Conversion::NAME("convert" #NAME, \
-        impl::convert ## NAME, Type::FROM, Type::TO, THROWS)
-#define CONVERSION(FROM, TO, THROWS) CONVERSION2(FROM ## To ## TO, FROM, TO, THROWS)
-             //from     to          canThrow
-    CONVERSION(Any,     String,     true);
-    CONVERSION(Int,     Any,        true);
-    CONVERSION(Int,     Bool,       false);
-    CONVERSION(Int,     String,     true);
-    CONVERSION(String,  Int,        true);
+        impl::convert ## NAME, Type::FROM, Type::TO, THROWS);
+#define CONVERSION(FROM, TO, THROWS, ...) CONVERSION2(FROM ## To ## TO, FROM, TO, THROWS)
+#define IDENTITY(FROM, ...)
+    CONVERSIONS(CONVERSION, IDENTITY)
+#undef IDENTITY
 #undef CONVERSION
 #undef CONVERSION2
 
+#define CONVERSION(FROM, TO, THROWS, ...) {Type::FROM, {__VA_ARGS__}, &FROM ## To ## TO},
+#define IDENTITY(FROM, ...) {Type::FROM, {__VA_ARGS__}, nullptr},
+const Conversion::Table Conversion::DispatchTable{
+    CONVERSIONS(CONVERSION, IDENTITY)
+};
+#undef IDENTITY
+#undef CONVERSION
+#undef CONVERSIONS
+
+/*
+ * Each row defines a binary operator and lists the cells of the dispatch table in which BinaryOperator::find()
+ * returns it as {kind, left, right}, where nullptr matches any operand type. When more cells cover the same
+ * combination of types, the first one wins, so the rows are in order of decreasing priority.
+ */
+#define BINOPS(BINOP)                                                                                               \
+          /*left            kind        right       result  canThrow*/                                              \
+    BINOP(Any,              Plus,       Any,        Any,    true,                                                   \
+            {Kind::Plus, &Type::Any, nullptr}, {Kind::Plus, nullptr, &Type::Any})                                   \
+    BINOP(Any,              PlusEquals, Any,        Any,    true,                                                   \
+            {Kind::PlusEquals, &Type::Any, nullptr})                                                                \
+    BINOP(SoftString,       Plus,       SoftString, String, true,                                                   \
+            {Kind::Plus, &Type::String, nullptr}, {Kind::Plus, nullptr, &Type::String},                             \
+            {Kind::PlusEquals, &Type::String, nullptr})                                                             \
+    BINOP(SoftInt,          Plus,       SoftInt,    Int,    false,                                                  \
+            {Kind::Plus, &Type::Int, nullptr}, {Kind::Plus, nullptr, &Type::Int},                                   \
+            {Kind::PlusEquals, &Type::Int, nullptr})
+
 #define BINOP2(NAME, KIND, LEFT, RIGHT, RESULT, THROWS)   const BinaryOperator BinaryOperator::NAME("binOp" #NAME, \
-        impl::binOp ## NAME, BinaryOperator::Kind::KIND, Type::LEFT, Type::RIGHT, Type::RESULT, THROWS)
-#define BINOP(LEFT, KIND, RIGHT, RESULT, THROWS) BINOP2(LEFT ## KIND ## RIGHT, KIND, LEFT, RIGHT, RESULT, THROWS)
-        //left          kind        right       result  canThrow
-    BINOP(Any,          Plus,       Any,        Any,    true);
-    BINOP(Any,          PlusEquals, Any,        Any,    true);
-    BINOP(SoftString,   Plus,       SoftString, String, true);
-    BINOP(SoftInt,      Plus,       SoftInt,    Int,    false);
+        impl::binOp ## NAME, BinaryOperator::Kind::KIND, Type::LEFT, Type::RIGHT, Type::RESULT, THROWS);
+#define BINOP(LEFT, KIND, RIGHT, RESULT, THROWS, ...) BINOP2(LEFT ## KIND ## RIGHT, KIND, LEFT, RIGHT, RESULT, THROWS)
+    BINOPS(BINOP)
 #undef BINOP
 #undef BINOP2
+
+#define BINOP(LEFT, KIND, RIGHT, RESULT, THROWS, ...) {LEFT ## KIND ## RIGHT, {__VA_ARGS__}},
+const BinaryOperator::Table BinaryOperator::DispatchTable{
+    BINOPS(BINOP)
+};
+#undef BINOP
+#undef BINOPS
 /// \endcond NoDoxygen
 
 } // namespace qore
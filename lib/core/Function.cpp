@@ -0,0 +1,1041 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of Function methods.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/Function.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "qore/core/FunctionGroup.h"
+#include "qore/core/code/Liveness.h"
+
+namespace qore {
+
+/// \cond NoDoxygen
+namespace {
+
+/**
+ * \brief Appends a copy of each visited instruction to a block, renumbering the temporaries.
+ *
+ * Landing pads found in \p dropped are replaced with nullptr in the copies.
+ */
+class InstructionCopier {
+
+public:
+    using ReturnType = void;
+
+public:
+    InstructionCopier(code::Block &dest, const std::vector<Index> &map,
+            const std::unordered_set<const code::Block *> *dropped = nullptr) : dest(dest), map(map), dropped(dropped) {
+    }
+
+    void visit(const code::Branch &ins) {
+        dest.appendBranch(rename(ins.getCondition()), ins.getTrueDest(), ins.getFalseDest());
+    }
+
+    void visit(const code::ConstInt &ins) {
+        dest.appendConstInt(rename(ins.getDest()), ins.getValue());
+    }
+
+    void visit(const code::ConstNothing &ins) {
+        dest.appendConstNothing(rename(ins.getDest()));
+    }
+
+    void visit(const code::ConstString &ins) {
+        dest.appendConstString(rename(ins.getDest()), ins.getString());
+    }
+
+    void visit(const code::ConvertAndBranch &ins) {
+        dest.appendConvertAndBranch(ins.getConversion(), rename(ins.getArg()), ins.getTrueDest(), ins.getFalseDest());
+    }
+
+    void visit(const code::GlobalGet &ins) {
+        dest.appendGlobalGet(rename(ins.getDest()), ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalInit &ins) {
+        dest.appendGlobalInit(ins.getGlobalVariable(), rename(ins.getInitValue()));
+    }
+
+    void visit(const code::GlobalLoad &ins) {
+        dest.appendGlobalLoad(rename(ins.getDest()), ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalLoadRef &ins) {
+        dest.appendGlobalLoadRef(rename(ins.getDest()), ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalReadLock &ins) {
+        dest.appendGlobalReadLock(ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalReadUnlock &ins) {
+        dest.appendGlobalReadUnlock(ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalSet &ins) {
+        dest.appendGlobalSet(ins.getGlobalVariable(), rename(ins.getSrc()));
+    }
+
+    void visit(const code::GlobalWriteLock &ins) {
+        dest.appendGlobalWriteLock(ins.getGlobalVariable());
+    }
+
+    void visit(const code::GlobalWriteUnlock &ins) {
+        dest.appendGlobalWriteUnlock(ins.getGlobalVariable());
+    }
+
+    void visit(const code::InvokeBinaryOperator &ins) {
+        dest.appendInvokeBinaryOperator(rename(ins.getDest()), ins.getOperator(), rename(ins.getLeft()),
+                rename(ins.getRight()), lpad(ins));
+    }
+
+    void visit(const code::InvokeConversion &ins) {
+        dest.appendInvokeConversion(rename(ins.getDest()), ins.getConversion(), rename(ins.getArg()), lpad(ins));
+    }
+
+    void visit(const code::InvokeFunction &ins) {
+        std::vector<code::Temp> args;
+        for (code::Temp t : ins.getArgs()) {
+            args.push_back(rename(t));
+        }
+        dest.appendInvokeFunction(rename(ins.getDest()), ins.getFunction(), std::move(args), lpad(ins));
+    }
+
+    void visit(const code::Jump &ins) {
+        dest.appendJump(ins.getDest());
+    }
+
+    void visit(const code::LocalGet &ins) {
+        dest.appendLocalGet(rename(ins.getDest()), ins.getLocalVariable());
+    }
+
+    void visit(const code::LocalLoadRef &ins) {
+        dest.appendLocalLoadRef(rename(ins.getDest()), ins.getLocalVariable());
+    }
+
+    void visit(const code::LocalSet &ins) {
+        dest.appendLocalSet(ins.getLocalVariable(), rename(ins.getSrc()));
+    }
+
+    void visit(const code::RefDec &ins) {
+        dest.appendRefDec(rename(ins.getTemp()), lpad(ins));
+    }
+
+    void visit(const code::RefDecDeferred &ins) {
+        dest.appendRefDecDeferred(rename(ins.getTemp()));
+    }
+
+    void visit(const code::RefDecNoexcept &ins) {
+        dest.appendRefDecNoexcept(rename(ins.getTemp()));
+    }
+
+    void visit(const code::RefInc &ins) {
+        dest.appendRefInc(rename(ins.getTemp()));
+    }
+
+    void visit(const code::RefReclaim &ins) {
+        dest.appendRefReclaim();
+    }
+
+    void visit(const code::ResumeUnwind &ins) {
+        dest.appendResumeUnwind();
+    }
+
+    void visit(const code::Ret &ins) {
+        dest.appendRet(rename(ins.getValue()));
+    }
+
+    void visit(const code::RetVoid &ins) {
+        dest.appendRetVoid();
+    }
+
+    void visit(const code::Instruction &ins) {
+        QORE_NOT_IMPLEMENTED("Instruction::Kind " << static_cast<int>(ins.getKind()));
+    }
+
+private:
+    code::Temp rename(code::Temp t) const {
+        return code::Temp(map[t.getIndex()]);
+    }
+
+    const code::Block *lpad(const code::Instruction &ins) const {
+        return dropped && dropped->count(ins.getLpad()) ? nullptr : ins.getLpad();
+    }
+
+private:
+    code::Block &dest;
+    const std::vector<Index> &map;
+    const std::unordered_set<const code::Block *> *dropped;
+};
+
+using Kind = code::Instruction::Kind;
+
+template<typename T>
+const T &as(const code::Instruction *ins) {
+    return static_cast<const T &>(*ins);
+}
+
+/**
+ * \brief Tries to fuse the instructions starting at given position into a single superinstruction.
+ * \param code the instructions of the block
+ * \param i the index of the first instruction to consider
+ * \param liveOut the temporaries live at the end of the block
+ * \param dest the block to append the superinstruction to
+ * \return the number of instructions fused or 0 if no pattern matched
+ */
+Size fuse(const std::vector<const code::Instruction *> &code, Index i, const code::Liveness::Set &liveOut,
+        code::Block &dest) {
+    auto kindAt = [&](Index j, Kind kind) { return j < code.size() && code[j]->getKind() == kind; };
+
+    //GlobalReadLock gv; GlobalGet t, gv; [RefInc t;] GlobalReadUnlock gv
+    if (kindAt(i, Kind::GlobalReadLock) && kindAt(i + 1, Kind::GlobalGet)) {
+        GlobalVariable &gv = as<code::GlobalReadLock>(code[i]).getGlobalVariable();
+        const code::GlobalGet &get = as<code::GlobalGet>(code[i + 1]);
+        if (&get.getGlobalVariable() == &gv) {
+            if (kindAt(i + 2, Kind::RefInc) && as<code::RefInc>(code[i + 2]).getTemp() == get.getDest()
+                    && kindAt(i + 3, Kind::GlobalReadUnlock)
+                    && &as<code::GlobalReadUnlock>(code[i + 3]).getGlobalVariable() == &gv) {
+                dest.appendGlobalLoadRef(get.getDest(), gv);
+                return 4;
+            }
+            if (kindAt(i + 2, Kind::GlobalReadUnlock)
+                    && &as<code::GlobalReadUnlock>(code[i + 2]).getGlobalVariable() == &gv) {
+                dest.appendGlobalLoad(get.getDest(), gv);
+                return 3;
+            }
+        }
+    }
+
+    //LocalGet t, lv; RefInc t
+    if (kindAt(i, Kind::LocalGet) && kindAt(i + 1, Kind::RefInc)) {
+        const code::LocalGet &get = as<code::LocalGet>(code[i]);
+        if (as<code::RefInc>(code[i + 1]).getTemp() == get.getDest()) {
+            dest.appendLocalLoadRef(get.getDest(), get.getLocalVariable());
+            return 2;
+        }
+    }
+
+    //InvokeConversion t, conv, a; Branch t, T, F - only if nothing else reads t
+    if (kindAt(i, Kind::InvokeConversion) && kindAt(i + 1, Kind::Branch)) {
+        const code::InvokeConversion &conv = as<code::InvokeConversion>(code[i]);
+        const code::Branch &branch = as<code::Branch>(code[i + 1]);
+        if (!conv.getLpad() && !conv.getConversion().isDynamic() && branch.getCondition() == conv.getDest()
+                && !liveOut[conv.getDest().getIndex()]) {
+            dest.appendConvertAndBranch(conv.getConversion(), conv.getArg(), branch.getTrueDest(),
+                    branch.getFalseDest());
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief Computes where the values of local variables may still be observed, see \ref RefCountElision.
+ *
+ * This is a backward dataflow analysis over all blocks of a function, including the edges from instructions to their
+ * landing pads. A read of a local variable counts only if it observes the value - a \ref code::LocalGet whose
+ * temporary is used by nothing but reference count decrements merely releases the reference held by the variable
+ * (e.g. at the end of its scope or before it is assigned a new value).
+ */
+class LocalLiveness {
+
+public:
+    using Set = std::vector<bool>;
+
+public:
+    explicit LocalLiveness(const Function &f) : localCount(0) {
+        for (const LocalVariable &lv : f.getLocalVariables()) {
+            localCount = std::max(localCount, lv.getIndex() + 1);
+        }
+        code::Liveness temps(f);
+        std::vector<const code::Block *> blocks;
+        for (const code::Block &b : f.getBlocks()) {
+            blocks.push_back(&b);
+            std::vector<const code::Instruction *> &c = instructions[&b];
+            for (const code::Instruction &ins : b) {
+                c.push_back(&ins);
+            }
+            findReleases(b, temps.getLiveOut(b));
+        }
+        for (const code::Block *b : blocks) {
+            liveIn[b] = Set(localCount);
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+                Set in = transfer(**it, 0, liveOut(**it));
+                if (in != liveIn[*it]) {
+                    liveIn[*it] = std::move(in);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Determines whether the value of a local variable may be observed after an instruction, either by the
+     * following code or by the landing pad of the instruction.
+     * \param b the block
+     * \param position the position of the instruction in the block
+     * \param local the index of the local variable
+     * \return true if the value of the local variable may be observed
+     */
+    bool isLiveAfter(const code::Block &b, Index position, Index local) const {
+        Set live = transfer(b, position + 1, liveOut(b));
+        const code::Block *lpad = instructions.at(&b)[position]->getLpad();
+        return live[local] || (lpad && liveIn.at(lpad)[local]);
+    }
+
+private:
+    Set liveOut(const code::Block &b) const {
+        Set out(localCount);
+        const std::vector<const code::Instruction *> &c = instructions.at(&b);
+        if (c.empty()) {
+            return out;
+        }
+        auto merge = [&](const code::Block &succ) {
+            const Set &in = liveIn.at(&succ);
+            for (Index i = 0; i < localCount; ++i) {
+                out[i] = out[i] || in[i];
+            }
+        };
+        const code::Instruction *last = c.back();
+        switch (last->getKind()) {
+            case Kind::Branch:
+                merge(as<code::Branch>(last).getTrueDest());
+                merge(as<code::Branch>(last).getFalseDest());
+                break;
+            case Kind::ConvertAndBranch:
+                merge(as<code::ConvertAndBranch>(last).getTrueDest());
+                merge(as<code::ConvertAndBranch>(last).getFalseDest());
+                break;
+            case Kind::Jump:
+                merge(as<code::Jump>(last).getDest());
+                break;
+            default:
+                break;
+        }
+        return out;
+    }
+
+    /**
+     * \brief Computes the live set before the instruction at given position by scanning the block backwards.
+     */
+    Set transfer(const code::Block &b, Index position, Set live) const {
+        auto rel = releases.find(&b);
+        const std::vector<const code::Instruction *> &c = instructions.at(&b);
+        for (Index i = c.size(); i-- > position;) {
+            const code::Instruction *ins = c[i];
+            if (ins->getKind() == Kind::LocalSet) {
+                live[as<code::LocalSet>(ins).getLocalVariable().getIndex()] = false;
+            } else if (ins->getKind() == Kind::LocalGet) {
+                if (rel == releases.end() || !rel->second.count(i)) {
+                    live[as<code::LocalGet>(ins).getLocalVariable().getIndex()] = true;
+                }
+            } else if (ins->getKind() == Kind::LocalLoadRef) {
+                live[as<code::LocalLoadRef>(ins).getLocalVariable().getIndex()] = true;
+            }
+            if (ins->getLpad()) {
+                auto it = liveIn.find(ins->getLpad());
+                if (it != liveIn.end()) {
+                    for (Index l = 0; l < localCount; ++l) {
+                        live[l] = live[l] || it->second[l];
+                    }
+                }
+            }
+        }
+        return live;
+    }
+
+    /**
+     * \brief Finds the instances of \ref code::LocalGet in a block that only release the reference held by the
+     * variable.
+     */
+    void findReleases(const code::Block &b, const code::Liveness::Set &tempsLiveOut) {
+        const std::vector<const code::Instruction *> &c = instructions.at(&b);
+        std::vector<code::Temp> uses, defs;
+        for (Index i = 0; i < c.size(); ++i) {
+            if (c[i]->getKind() != Kind::LocalGet) {
+                continue;
+            }
+            code::Temp t = as<code::LocalGet>(c[i]).getDest();
+            bool release = true;
+            bool redefined = false;
+            for (Index j = i + 1; release && !redefined && j < c.size(); ++j) {
+                uses.clear();
+                defs.clear();
+                code::Liveness::getAccess(*c[j], uses, defs);
+                release = !std::count(uses.begin(), uses.end(), t) || isDec(*c[j]);
+                if (release && c[j]->getLpad()) {
+                    release = onlyDecs(*c[j]->getLpad(), t);
+                }
+                redefined = std::count(defs.begin(), defs.end(), t) > 0;
+            }
+            if (release && (redefined || !tempsLiveOut[t.getIndex()])) {
+                releases[&b].insert(i);
+            }
+        }
+    }
+
+    static bool isDec(const code::Instruction &ins) {
+        return ins.getKind() == Kind::RefDec || ins.getKind() == Kind::RefDecDeferred
+                || ins.getKind() == Kind::RefDecNoexcept;
+    }
+
+    static bool onlyDecs(const code::Block &b, code::Temp t) {
+        std::vector<code::Temp> uses, defs;
+        for (const code::Instruction &ins : b) {
+            uses.clear();
+            defs.clear();
+            code::Liveness::getAccess(ins, uses, defs);
+            if (std::count(defs.begin(), defs.end(), t)) {
+                return true;
+            }
+            if (std::count(uses.begin(), uses.end(), t) && !isDec(ins)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    Size localCount;
+    std::unordered_map<const code::Block *, std::vector<const code::Instruction *>> instructions;
+    std::unordered_map<const code::Block *, std::set<Index>> releases;
+    std::unordered_map<const code::Block *, Set> liveIn;
+};
+
+/**
+ * \brief Finds the reference count instructions that can be removed without changing the observable behavior,
+ * see \ref Function::elideRefCounts().
+ *
+ * Each block is scanned forward while tracking where the value of each temporary came from. Blocks reached by jumps
+ * start with nothing known since the builder never keeps temporaries alive across jumps. Landing pads are analyzed
+ * together with the single instruction that refers to them, using the state before that instruction. Whether a
+ * local variable is observed after a call is answered by \ref LocalLiveness, which covers all paths of the function.
+ */
+class RefCountElision {
+
+public:
+    using ReturnType = void;
+
+    /**
+     * \brief Removal decisions, indexed by the block and the position of the instruction within the block.
+     */
+    using Removals = std::unordered_map<const code::Block *, std::set<Index>>;
+
+public:
+    RefCountElision(Size tempCount, const LocalLiveness &liveness, Removals &removals) : origins(tempCount),
+            liveness(liveness), removals(removals) {
+    }
+
+    /**
+     * \brief Marks landing pads that cannot be analyzed together with the instruction that refers to them because
+     * they are shared or also reachable by a jump.
+     * \param b the block
+     */
+    void markShared(const code::Block *b) {
+        shared.insert(b);
+    }
+
+    void analyze(const code::Block &b) {
+        std::fill(origins.begin(), origins.end(), Origin());
+        locals.clear();
+        lpads.clear();
+        block = &b;
+        position = 0;
+        for (const code::Instruction &ins : b) {
+            //every increment that is open when the instruction throws must be released by its landing pad
+            lpad = ins.getLpad() ? enterLpad(*ins.getLpad()) : nullptr;
+            forEachOpenInc([this](Inc &inc) { inc.lpads.push_back(lpad); });
+            ins.accept(*this);
+            if (lpad && isRemoved(b, position)) {
+                //a removed decrement is no longer a point where an exception can occur
+                forEachOpenInc([this](Inc &inc) { inc.lpads.pop_back(); });
+            }
+            ++position;
+        }
+    }
+
+    void visit(const code::ConstInt &ins) {
+        setOrigin(ins.getDest(), Origin::immortal());
+    }
+
+    void visit(const code::ConstNothing &ins) {
+        setOrigin(ins.getDest(), Origin::immortal());
+    }
+
+    void visit(const code::ConstString &ins) {
+        setOrigin(ins.getDest(), Origin::immortal());
+    }
+
+    void visit(const code::GlobalGet &ins) {
+        //the global variable may be modified by another thread at any time
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::GlobalInit &ins) {
+        consume(ins.getInitValue());
+    }
+
+    void visit(const code::GlobalLoad &ins) {
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::GlobalLoadRef &ins) {
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::GlobalSet &ins) {
+        consume(ins.getSrc());
+    }
+
+    void visit(const code::InvokeBinaryOperator &ins) {
+        lend({ins.getLeft(), ins.getRight()});
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::InvokeConversion &ins) {
+        lend({ins.getArg()});
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::InvokeFunction &ins) {
+        lend(ins.getArgs());
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::LocalGet &ins) {
+        setOrigin(ins.getDest(), Origin::fromLocal(ins.getLocalVariable().getIndex()));
+    }
+
+    void visit(const code::LocalLoadRef &ins) {
+        //the increment is part of the superinstruction and cannot be removed on its own
+        setOrigin(ins.getDest(), Origin());
+    }
+
+    void visit(const code::LocalSet &ins) {
+        consume(ins.getSrc());
+        Index index = ins.getLocalVariable().getIndex();
+        for (Origin &o : origins) {
+            if (o.kind == Origin::Kind::Local && o.local == index) {
+                o = Origin();
+            }
+        }
+        locals.erase(index);
+    }
+
+    void visit(const code::RefDec &ins) {
+        dec(ins.getTemp());
+    }
+
+    void visit(const code::RefDecDeferred &ins) {
+        dec(ins.getTemp());
+    }
+
+    void visit(const code::RefDecNoexcept &ins) {
+        dec(ins.getTemp());
+    }
+
+    void visit(const code::RefInc &ins) {
+        const Origin &o = origins[ins.getTemp().getIndex()];
+        if (o.kind == Origin::Kind::Immortal) {
+            remove(*block, position);
+        } else if (o.kind == Origin::Kind::Local) {
+            LocalState &l = locals[o.local];
+            if (!l.released) {
+                l.incs.push_back(Inc{position, {}, false, 0, false});
+            }
+        }
+    }
+
+    void visit(const code::Ret &ins) {
+        consume(ins.getValue());
+    }
+
+    void visit(const code::Instruction &ins) {
+    }
+
+private:
+    struct Origin {
+        enum class Kind { Unknown, Immortal, Local };
+
+        Kind kind;
+        Index local;
+
+        Origin() : kind(Kind::Unknown), local(0) {
+        }
+
+        static Origin immortal() {
+            Origin o;
+            o.kind = Kind::Immortal;
+            return o;
+        }
+
+        static Origin fromLocal(Index index) {
+            Origin o;
+            o.kind = Kind::Local;
+            o.local = index;
+            return o;
+        }
+    };
+
+    /**
+     * \brief Reference count decrements in a landing pad that release a reference to the value of a local variable.
+     */
+    struct LpadRecord {
+        const code::Block *block;
+        std::vector<std::pair<Index, Index>> candidates;    //position in the lpad and index of the local variable
+    };
+
+    /**
+     * \brief A reference count increment that has not been matched with a decrement yet.
+     */
+    struct Inc {
+        Index position;
+        std::vector<LpadRecord *> lpads;                    //landing pads of the instructions executed since
+        bool lent;                                          //the value was passed to a callee since
+        Index lentAt;                                       //position of the last such call
+        bool aliased;                                       //the value was passed more than once or together with
+                                                            //another reference to it
+    };
+
+    struct LocalState {
+        std::vector<Inc> incs;
+        bool released = false;
+    };
+
+private:
+    void setOrigin(code::Temp t, Origin o) {
+        origins[t.getIndex()] = o;
+    }
+
+    void consume(code::Temp t) {
+        const Origin &o = origins[t.getIndex()];
+        if (o.kind == Origin::Kind::Local) {
+            auto it = locals.find(o.local);
+            if (it != locals.end()) {
+                //the increments now belong to the new owner
+                it->second.incs.clear();
+            }
+        }
+    }
+
+    /**
+     * \brief Records that values are passed to an operator, conversion or function.
+     *
+     * The callee sees the reference count and may modify a value it believes to be unique in place (e.g.
+     * String::append()). The open increments of a local variable's value can therefore only be removed if nothing
+     * observes the variable after the call, i.e. the call is the last use of the value and the variable's own
+     * reference is in effect moved to the callee.
+     */
+    void lend(const std::vector<code::Temp> &args) {
+        std::map<Index, Size> uses;
+        for (code::Temp t : args) {
+            const Origin &o = origins[t.getIndex()];
+            if (o.kind == Origin::Kind::Local) {
+                ++uses[o.local];
+            }
+        }
+        for (auto &u : uses) {
+            auto it = locals.find(u.first);
+            if (it != locals.end()) {
+                bool aliased = u.second > 1 || it->second.incs.size() > 1;
+                for (Inc &inc : it->second.incs) {
+                    //a value passed to several callees could be modified by one of them before the next one runs
+                    inc.aliased = inc.aliased || aliased || inc.lent;
+                    inc.lent = true;
+                    inc.lentAt = position;
+                }
+            }
+        }
+    }
+
+    void dec(code::Temp t) {
+        const Origin &o = origins[t.getIndex()];
+        if (o.kind == Origin::Kind::Immortal) {
+            remove(*block, position);
+        } else if (o.kind == Origin::Kind::Local) {
+            LocalState &l = locals[o.local];
+            if (l.incs.empty()) {
+                //this releases the reference held by the local variable itself
+                l.released = true;
+                return;
+            }
+            Inc inc = std::move(l.incs.back());
+            l.incs.pop_back();
+            if (lpad) {
+                //the landing pad of the decrement itself does not matter if the decrement is removed
+                inc.lpads.pop_back();
+            }
+            if (inc.lent && (inc.aliased || liveness.isLiveAfter(*block, inc.lentAt, o.local))) {
+                return;
+            }
+            if (claim(inc, o.local)) {
+                remove(*block, inc.position);
+                remove(*block, position);
+            }
+        }
+    }
+
+    /**
+     * \brief Claims one decrement of the value of a local variable in each landing pad that was active while the
+     * increment was open.
+     * \return false if some landing pad has no such decrement, in which case nothing is claimed
+     */
+    bool claim(const Inc &inc, Index local) {
+        std::vector<std::pair<LpadRecord *, std::vector<std::pair<Index, Index>>::iterator>> claims;
+        for (LpadRecord *r : inc.lpads) {
+            auto it = std::find_if(r->candidates.begin(), r->candidates.end(),
+                    [local](const std::pair<Index, Index> &c) { return c.second == local; });
+            if (it == r->candidates.end()) {
+                return false;
+            }
+            claims.emplace_back(r, it);
+        }
+        for (auto &c : claims) {
+            remove(*c.first->block, c.second->first);
+            c.first->candidates.erase(c.second);
+        }
+        return true;
+    }
+
+    template<typename F>
+    void forEachOpenInc(F f) {
+        if (lpad) {
+            for (auto &l : locals) {
+                for (Inc &inc : l.second.incs) {
+                    f(inc);
+                }
+            }
+        }
+    }
+
+    LpadRecord *enterLpad(const code::Block &pad) {
+        lpads.emplace_back();
+        LpadRecord &r = lpads.back();
+        r.block = &pad;
+        if (shared.count(&pad)) {
+            //no candidates - the increments open here cannot be removed
+            return &r;
+        }
+        Index i = 0;
+        for (const code::Instruction &ins : pad) {
+            code::Temp t(0);
+            switch (ins.getKind()) {
+                case Kind::RefDec:
+                    t = as<code::RefDec>(&ins).getTemp();
+                    break;
+                case Kind::RefDecDeferred:
+                    t = as<code::RefDecDeferred>(&ins).getTemp();
+                    break;
+                case Kind::RefDecNoexcept:
+                    t = as<code::RefDecNoexcept>(&ins).getTemp();
+                    break;
+                default:
+                    ++i;
+                    continue;
+            }
+            const Origin &o = origins[t.getIndex()];
+            if (o.kind == Origin::Kind::Immortal) {
+                remove(pad, i);
+            } else if (o.kind == Origin::Kind::Local) {
+                r.candidates.emplace_back(i, o.local);
+            }
+            ++i;
+        }
+        return &r;
+    }
+
+    void remove(const code::Block &b, Index i) {
+        removals[&b].insert(i);
+    }
+
+    bool isRemoved(const code::Block &b, Index i) const {
+        auto it = removals.find(&b);
+        return it != removals.end() && it->second.count(i);
+    }
+
+private:
+    std::vector<Origin> origins;
+    const LocalLiveness &liveness;
+    Removals &removals;
+    std::unordered_set<const code::Block *> shared;
+    std::map<Index, LocalState> locals;
+    std::deque<LpadRecord> lpads;
+    const code::Block *block;
+    Index position;
+    LpadRecord *lpad;
+};
+
+void mangleSourceName(std::string &out, const std::string &name) {
+    out += std::to_string(name.size());
+    out += name;
+}
+
+} // namespace
+/// \endcond NoDoxygen
+
+std::string Function::getMangledName() const {
+    std::vector<std::string> names;
+    const std::string &fullName = group.getFullName();
+    for (std::string::size_type pos = 0; pos < fullName.size();) {
+        std::string::size_type end = fullName.find("::", pos);
+        if (end == std::string::npos) {
+            end = fullName.size();
+        }
+        if (end > pos) {
+            names.push_back(fullName.substr(pos, end - pos));
+        }
+        pos = end + 2;
+    }
+
+    std::string out = "_Z";
+    if (names.size() > 1) {
+        out += 'N';
+    }
+    for (const std::string &name : names) {
+        mangleSourceName(out, name);
+    }
+    if (names.size() > 1) {
+        out += 'E';
+    }
+    if (type.getParameterCount() == 0) {
+        out += 'v';
+    }
+    for (Index i = 0; i < type.getParameterCount(); ++i) {
+        out += 'u';
+        mangleSourceName(out, type.getParameterType(i).getName());
+    }
+    return out;
+}
+
+Size Function::elideRefCounts() {
+    if (blocks.empty()) {
+        return 0;
+    }
+
+    //landing pads are analyzed with the instruction that refers to them, unless they are not unique to it
+    std::unordered_map<const code::Block *, Size> lpadRefs;
+    std::unordered_set<const code::Block *> jumpTargets;
+    for (const code::Block &b : getBlocks()) {
+        for (const code::Instruction &ins : b) {
+            if (ins.getLpad()) {
+                ++lpadRefs[ins.getLpad()];
+            }
+            switch (ins.getKind()) {
+                case Kind::Branch:
+                    jumpTargets.insert(&as<code::Branch>(&ins).getTrueDest());
+                    jumpTargets.insert(&as<code::Branch>(&ins).getFalseDest());
+                    break;
+                case Kind::ConvertAndBranch:
+                    jumpTargets.insert(&as<code::ConvertAndBranch>(&ins).getTrueDest());
+                    jumpTargets.insert(&as<code::ConvertAndBranch>(&ins).getFalseDest());
+                    break;
+                case Kind::Jump:
+                    jumpTargets.insert(&as<code::Jump>(&ins).getDest());
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    RefCountElision::Removals removals;
+    LocalLiveness liveness(*this);
+    RefCountElision elision(tempCount, liveness, removals);
+    for (auto &p : lpadRefs) {
+        if (p.second > 1 || jumpTargets.count(p.first)) {
+            elision.markShared(p.first);
+        }
+    }
+    for (const code::Block &b : getBlocks()) {
+        if (!lpadRefs.count(&b)) {
+            elision.analyze(b);
+        }
+    }
+
+    Size count = 0;
+    for (auto &p : removals) {
+        count += p.second.size();
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    std::vector<Index> identity(tempCount);
+    for (Index t = 0; t < tempCount; ++t) {
+        identity[t] = t;
+    }
+    auto rewrite = [&](code::Block &b, const std::unordered_set<const code::Block *> *dropped) {
+        auto it = removals.find(&b);
+        code::Block rewritten;
+        InstructionCopier copier(rewritten, identity, dropped);
+        Index i = 0;
+        for (const code::Instruction &ins : b) {
+            if (it == removals.end() || !it->second.count(i)) {
+                rewritten.setLocation(ins.getLocation());
+                ins.accept(copier);
+            }
+            ++i;
+        }
+        b.swapInstructions(rewritten);
+    };
+
+    //landing pads left with nothing to do but resume unwinding are no longer needed
+    std::unordered_set<const code::Block *> dropped;
+    for (code::Block::Ptr &b : blocks) {
+        if (lpadRefs.count(b.get())) {
+            if (removals.count(b.get())) {
+                rewrite(*b, nullptr);
+            }
+            Size size = 0;
+            for (const code::Instruction &ins : *b) {
+                size += ins.getKind() == Kind::ResumeUnwind ? 1 : 2;
+            }
+            if (size == 1 && !jumpTargets.count(b.get())) {
+                dropped.insert(b.get());
+            }
+        }
+    }
+    for (code::Block::Ptr &b : blocks) {
+        if (!lpadRefs.count(b.get())) {
+            rewrite(*b, &dropped);
+        }
+    }
+    return count;
+}
+
+void Function::fuseInstructions() {
+    if (blocks.empty()) {
+        return;
+    }
+    code::Liveness liveness(*this);
+    std::vector<Index> identity(tempCount);
+    for (Index t = 0; t < tempCount; ++t) {
+        identity[t] = t;
+    }
+
+    for (code::Block::Ptr &b : blocks) {
+        std::vector<const code::Instruction *> code;
+        for (const code::Instruction &ins : *b) {
+            code.push_back(&ins);
+        }
+        const code::Liveness::Set &liveOut = liveness.getLiveOut(*b);
+
+        code::Block rewritten;
+        InstructionCopier copier(rewritten, identity);
+        bool changed = false;
+        for (Index i = 0; i < code.size();) {
+            //a superinstruction takes the location of the first of the fused instructions
+            rewritten.setLocation(code[i]->getLocation());
+            if (Size n = fuse(code, i, liveOut, rewritten)) {
+                i += n;
+                changed = true;
+            } else {
+                code[i++]->accept(copier);
+            }
+        }
+        if (changed) {
+            b->swapInstructions(rewritten);
+        }
+    }
+}
+
+void Function::compactTemps() {
+    if (blocks.empty() || tempCount == 0) {
+        return;
+    }
+
+    //number the instructions of all blocks and collect the positions at which each temporary is in use
+    code::Liveness liveness(*this);
+    std::vector<std::vector<Index>> positions(tempCount);
+    Index position = 0;
+    for (const code::Block &b : getBlocks()) {
+        for (const code::Liveness::Set &occupied : liveness.getOccupied(b)) {
+            for (Index t = 0; t < tempCount; ++t) {
+                if (occupied[t]) {
+                    positions[t].push_back(position);
+                }
+            }
+            ++position;
+        }
+    }
+
+    std::vector<Index> order;
+    for (Index t = 0; t < tempCount; ++t) {
+        if (!positions[t].empty()) {
+            order.push_back(t);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](Index a, Index b) {
+        return positions[a][0] < positions[b][0];
+    });
+
+    //linear scan - each temporary gets the lowest slot that is free at all of its positions
+    std::vector<code::Liveness::Set> slots;
+    std::vector<Index> map(tempCount, 0);
+    for (Index t : order) {
+        Index slot = 0;
+        while (slot < slots.size()
+                && std::any_of(positions[t].begin(), positions[t].end(), [&](Index p) { return slots[slot][p]; })) {
+            ++slot;
+        }
+        if (slot == slots.size()) {
+            slots.emplace_back(position);
+        }
+        for (Index p : positions[t]) {
+            slots[slot][p] = true;
+        }
+        map[t] = slot;
+    }
+
+    if (slots.size() >= tempCount) {
+        return;
+    }
+
+    for (code::Block::Ptr &b : blocks) {
+        code::Block rewritten;
+        InstructionCopier copier(rewritten, map);
+        for (const code::Instruction &ins : *b) {
+            rewritten.setLocation(ins.getLocation());
+            ins.accept(copier);
+        }
+        b->swapInstructions(rewritten);
+    }
+    tempCount = slots.size();
+}
+
+} // namespace qore
@@ -0,0 +1,192 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of polymorphic inline caches.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/InlineCache.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "impl/BinaryOperators.h"
+#include "impl/Conversions.h"
+#include "qore/core/Any.h"
+
+namespace qore {
+
+constexpr int InlineCache::Capacity;
+
+static std::atomic<Size> finishedHits(0);      //!< Hits counted by threads that have already finished.
+static std::atomic<Size> finishedMisses(0);    //!< Misses counted by threads that have already finished.
+
+/**
+ * \brief Counters of a single thread, added to the global ones when the thread finishes.
+ */
+struct ThreadStats : InlineCache::Stats {
+    ThreadStats() : InlineCache::Stats{0, 0} {
+    }
+
+    ~ThreadStats() {
+        finishedHits.fetch_add(hits, std::memory_order_relaxed);
+        finishedMisses.fetch_add(misses, std::memory_order_relaxed);
+    }
+};
+
+static thread_local ThreadStats threadStats;
+
+InlineCache::Stats InlineCache::getStats() {
+    return Stats{finishedHits.load(std::memory_order_relaxed) + threadStats.hits,
+            finishedMisses.load(std::memory_order_relaxed) + threadStats.misses};
+}
+
+void InlineCache::hit() noexcept {
+    ++threadStats.hits;
+}
+
+void InlineCache::miss() noexcept {
+    ++threadStats.misses;
+}
+
+/**
+ * \brief Finds or creates the unique instance of an immutable cache entry.
+ *
+ * Entries are shared by all caches and live until the program terminates. Their number is bounded by the number
+ * of combinations of types that appeared in the program.
+ * \tparam E the type of the entry
+ * \tparam K the type of the key
+ * \tparam F the type of the factory function
+ * \param key the key identifying the entry
+ * \param create a function that creates the entry if it does not exist yet
+ * \return the unique entry for the key
+ */
+template<typename E, typename K, typename F>
+static const E *intern(const K &key, F create) {
+    static std::mutex mutex;
+    static std::map<K, std::unique_ptr<E>> entries;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<E> &ptr = entries[key];
+    if (!ptr) {
+        ptr.reset(create());
+    }
+    return ptr.get();
+}
+
+/**
+ * \brief Stores an entry into the first free slot of an inline cache.
+ *
+ * Does nothing if the entry is already present (another thread may have installed it in the meantime) or if all
+ * slots are taken.
+ * \param slots the slots of the cache
+ * \param entry the interned entry to install
+ */
+template<typename E>
+static void install(std::atomic<const E *> (&slots)[InlineCache::Capacity], const E *entry) {
+    for (std::atomic<const E *> &slot : slots) {
+        const E *expected = nullptr;
+        if (slot.compare_exchange_strong(expected, entry, std::memory_order_acq_rel) || expected == entry) {
+            return;
+        }
+    }
+}
+
+/**
+ * \brief The operation resolved for a combination of types of operands.
+ */
+struct BinaryOperatorCache::Entry {
+    const Type &left;                       //!< The actual type of the left operand.
+    const Type &right;                      //!< The actual type of the right operand.
+    const BinaryOperator &op;               //!< The binary operator applicable to the types.
+    const Conversion *leftConversion;       //!< The conversion of the left operand.
+    const Conversion *rightConversion;      //!< The conversion of the right operand.
+};
+
+qvalue BinaryOperatorCache::invoke(BinaryOperator::Kind kind, qvalue left, qvalue right) {
+    const Type &leftType = Any::typeOf(left);
+    const Type &rightType = Any::typeOf(right);
+
+    bool megamorphic = true;
+    for (const std::atomic<const Entry *> &slot : entries) {
+        const Entry *e = slot.load(std::memory_order_acquire);
+        if (e == nullptr) {
+            megamorphic = false;
+            break;
+        }
+        if (e->left == leftType && e->right == rightType) {
+            hit();
+            return impl::binOpResolved(e->op, e->leftConversion, e->rightConversion, left, right);
+        }
+    }
+
+    miss();
+    const BinaryOperator &op = BinaryOperator::find(kind, leftType, rightType);
+    const Conversion *leftConversion = Conversion::find(leftType, op.getLeftType());
+    const Conversion *rightConversion = Conversion::find(rightType, op.getRightType());
+    if (!megamorphic) {
+        install(entries, intern<Entry>(std::make_tuple(static_cast<int>(kind), &leftType, &rightType), [&]() {
+            return new Entry{leftType, rightType, op, leftConversion, rightConversion};
+        }));
+    }
+    return impl::binOpResolved(op, leftConversion, rightConversion, left, right);
+}
+
+/**
+ * \brief The conversion resolved for an actual type of the value.
+ */
+struct ConversionCache::Entry {
+    const Type &from;                       //!< The actual type of the value.
+    const Conversion *conversion;           //!< The conversion or nullptr for an identity conversion.
+};
+
+qvalue ConversionCache::invoke(const Type &type, qvalue value) {
+    const Type &valueType = Any::typeOf(value);
+
+    bool megamorphic = true;
+    for (const std::atomic<const Entry *> &slot : entries) {
+        const Entry *e = slot.load(std::memory_order_acquire);
+        if (e == nullptr) {
+            megamorphic = false;
+            break;
+        }
+        if (e->from == valueType) {
+            hit();
+            return impl::convertAny(value, type, e->conversion);
+        }
+    }
+
+    miss();
+    const Conversion *conversion = Conversion::find(valueType, type);
+    if (!megamorphic) {
+        install(entries, intern<Entry>(std::make_tuple(&valueType, &type), [&]() {
+            return new Entry{valueType, conversion};
+        }));
+    }
+    return impl::convertAny(value, type, conversion);
+}
+
+} // namespace qore
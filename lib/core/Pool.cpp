@@ -0,0 +1,344 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the pool allocator.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/Pool.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace qore {
+
+constexpr Size Pool::Granularity;
+constexpr Size Pool::MaxSize;
+
+static constexpr Size ClassCount = Pool::MaxSize / Pool::Granularity;   //!< The number of size classes.
+static constexpr Size SlabSize = 64 * 1024;             //!< The size and alignment of a slab.
+static constexpr Size SlabHeaderSize = 64;              //!< Space reserved for Slab at the start of each slab.
+static constexpr Size SlabsPerChunk = 16;               //!< The number of slabs obtained from the system at once.
+static constexpr Size BatchSize = 64;                   //!< The number of objects returned to another heap at once.
+
+static std::atomic<Size> reservedSize(0);
+
+/**
+ * \brief Represents a heap used by one thread.
+ *
+ * Only the owning thread accesses the local free lists, the remote lists can be pushed to by any thread.
+ */
+class Pool::Heap {
+
+public:
+    /**
+     * \brief A free slot.
+     */
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    /**
+     * \brief The header stored at the beginning of each slab.
+     */
+    struct Slab {
+        Heap *heap;                                     //!< The heap owning the slab.
+        Index sizeClass;                                //!< The size class of all slots in the slab.
+    };
+
+public:
+    /**
+     * \brief Returns the heap of the current thread.
+     * \return the heap of the current thread or `nullptr` if the thread does not have one (yet)
+     */
+    static Heap *&current() noexcept {
+        static thread_local Heap *heap = nullptr;
+        return heap;
+    }
+
+    /**
+     * \brief Assigns a heap to the current thread.
+     * \return the heap of the current thread or `nullptr` if the thread is terminating
+     */
+    static Heap *attach() {
+        if (terminating) {
+            return nullptr;
+        }
+        Heap *heap;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex());
+            std::vector<Heap *> &p = pool();
+            if (p.empty()) {
+                heap = new Heap();
+            } else {
+                heap = p.back();
+                p.pop_back();
+            }
+        }
+        current() = heap;
+        guard.heap = heap;
+        return heap;
+    }
+
+    /**
+     * \brief Allocates memory for objects created while their thread is terminating.
+     * \param sizeClass the size class
+     * \return the allocated memory
+     */
+    static void *allocateOrphan(Index sizeClass) {
+        //all frees of these objects go through the remote lists since the heap is never current
+        static std::mutex *m = new std::mutex();
+        static Heap *orphan = new Heap();
+        std::unique_lock<std::mutex> lock(*m);
+        return orphan->allocate(sizeClass);
+    }
+
+    /**
+     * \brief Returns the slab containing given memory.
+     * \param ptr memory allocated from a slab
+     * \return the slab containing `ptr`
+     */
+    static Slab *slabOf(void *ptr) noexcept {
+        return reinterpret_cast<Slab *>(reinterpret_cast<std::uintptr_t>(ptr) & ~(SlabSize - 1));
+    }
+
+    /**
+     * \brief Allocates a slot. Must be called by the owning thread.
+     * \param sizeClass the size class
+     * \return the allocated slot
+     */
+    void *allocate(Index sizeClass) {
+        FreeNode *n = local[sizeClass];
+        if (!n) {
+            //pick up all objects freed by other threads at once
+            n = remote[sizeClass].exchange(nullptr, std::memory_order_acquire);
+            if (!n) {
+                return bumpAllocate(sizeClass);
+            }
+        }
+        local[sizeClass] = n->next;
+        return n;
+    }
+
+    /**
+     * \brief Frees a slot owned by this heap. Must be called by the owning thread.
+     * \param sizeClass the size class
+     * \param n the slot
+     */
+    void free(Index sizeClass, FreeNode *n) noexcept {
+        n->next = local[sizeClass];
+        local[sizeClass] = n;
+    }
+
+    /**
+     * \brief Frees a slot owned by another heap. Must be called by the thread owning this heap.
+     *
+     * The slot is added to a batch which is handed over to the owner once it is full or when a slot owned by
+     * a different heap is freed.
+     * \param owner the heap owning the slot
+     * \param sizeClass the size class
+     * \param n the slot
+     */
+    void freeRemote(Heap *owner, Index sizeClass, FreeNode *n) noexcept {
+        Batch &b = batches[sizeClass];
+        if (b.owner != owner) {
+            flush(sizeClass);
+            b.owner = owner;
+        }
+        if (!b.head) {
+            b.tail = n;
+        }
+        n->next = b.head;
+        b.head = n;
+        if (++b.count == BatchSize) {
+            flush(sizeClass);
+        }
+    }
+
+    /**
+     * \brief Hands over a list of slots to this heap. Can be called by any thread.
+     * \param sizeClass the size class
+     * \param head the first slot of the list
+     * \param tail the last slot of the list
+     */
+    void pushRemote(Index sizeClass, FreeNode *head, FreeNode *tail) noexcept {
+        FreeNode *old = remote[sizeClass].load(std::memory_order_relaxed);
+        do {
+            tail->next = old;
+        } while (!remote[sizeClass].compare_exchange_weak(old, head, std::memory_order_release,
+                std::memory_order_relaxed));
+    }
+
+private:
+    /**
+     * \brief Slots freed by this heap's thread that belong to another heap.
+     */
+    struct Batch {
+        Heap *owner;
+        FreeNode *head;
+        FreeNode *tail;
+        Size count;
+    };
+
+    Heap() : local(), bump(), bumpEnd(), batches(), remote() {
+    }
+
+    void *bumpAllocate(Index sizeClass) {
+        Size slotSize = (sizeClass + 1) * Granularity;
+        if (static_cast<Size>(bumpEnd[sizeClass] - bump[sizeClass]) < slotSize) {
+            char *s = newSlab();
+            Slab *slab = reinterpret_cast<Slab *>(s);
+            slab->heap = this;
+            slab->sizeClass = sizeClass;
+            bump[sizeClass] = s + SlabHeaderSize;
+            bumpEnd[sizeClass] = s + SlabSize;
+        }
+        void *p = bump[sizeClass];
+        bump[sizeClass] += slotSize;
+        return p;
+    }
+
+    void flush(Index sizeClass) noexcept {
+        Batch &b = batches[sizeClass];
+        if (b.head) {
+            b.owner->pushRemote(sizeClass, b.head, b.tail);
+            b.head = b.tail = nullptr;
+            b.count = 0;
+        }
+    }
+
+    void release() {
+        for (Index c = 0; c < ClassCount; ++c) {
+            flush(c);
+        }
+        std::unique_lock<std::mutex> lock(poolMutex());
+        pool().push_back(this);
+    }
+
+    static char *newSlab() {
+        static std::mutex *m = new std::mutex();
+        static char *next = nullptr;
+        static char *end = nullptr;
+        std::unique_lock<std::mutex> lock(*m);
+        if (next == end) {
+            //one extra slab allows aligning the start of the chunk
+            char *chunk = static_cast<char *>(::operator new((SlabsPerChunk + 1) * SlabSize));
+            std::uintptr_t a = (reinterpret_cast<std::uintptr_t>(chunk) + SlabSize - 1) & ~(SlabSize - 1);
+            next = chunk + (a - reinterpret_cast<std::uintptr_t>(chunk));
+            end = next + SlabsPerChunk * SlabSize;
+            reservedSize.fetch_add((SlabsPerChunk + 1) * SlabSize, std::memory_order_relaxed);
+        }
+        char *s = next;
+        next += SlabSize;
+        return s;
+    }
+
+    static std::mutex &poolMutex() {
+        static std::mutex *m = new std::mutex();
+        return *m;
+    }
+
+    static std::vector<Heap *> &pool() {
+        static std::vector<Heap *> *p = new std::vector<Heap *>();
+        return *p;
+    }
+
+    /**
+     * \brief Returns the heap to the pool when the thread terminates.
+     */
+    class Guard {
+    public:
+        Guard() : heap(nullptr) {
+        }
+
+        ~Guard() {
+            terminating = true;
+            current() = nullptr;
+            if (heap) {
+                heap->release();
+            }
+        }
+
+        Heap *heap;
+    };
+
+private:
+    FreeNode *local[ClassCount];
+    char *bump[ClassCount];
+    char *bumpEnd[ClassCount];
+    Batch batches[ClassCount];
+    char padding[64];                                   //!< Keeps the remote lists away from the local state.
+    std::atomic<FreeNode *> remote[ClassCount];
+
+    static thread_local Guard guard;
+    static thread_local bool terminating;
+};
+
+thread_local Pool::Heap::Guard Pool::Heap::guard;
+thread_local bool Pool::Heap::terminating = false;
+
+void *Pool::allocate(Size size) {
+    if (size > MaxSize) {
+        return ::operator new(size);
+    }
+    Index sizeClass = size ? (size - 1) / Granularity : 0;
+    Heap *heap = Heap::current();
+    if (!heap) {
+        heap = Heap::attach();
+        if (!heap) {
+            return Heap::allocateOrphan(sizeClass);
+        }
+    }
+    return heap->allocate(sizeClass);
+}
+
+void Pool::deallocate(void *ptr, Size size) noexcept {
+    if (!ptr) {
+        return;
+    }
+    if (size > MaxSize) {
+        ::operator delete(ptr);
+        return;
+    }
+    Heap::Slab *slab = Heap::slabOf(ptr);
+    Heap::FreeNode *n = static_cast<Heap::FreeNode *>(ptr);
+    Heap *heap = Heap::current();
+    if (slab->heap == heap) {
+        heap->free(slab->sizeClass, n);
+    } else if (heap) {
+        heap->freeRemote(slab->heap, slab->sizeClass, n);
+    } else {
+        slab->heap->pushRemote(slab->sizeClass, n, n);
+    }
+}
+
+Size Pool::getReservedSize() noexcept {
+    return reservedSize.load(std::memory_order_relaxed);
+}
+
+} // namespace qore
@@ -0,0 +1,312 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the biased reference counting.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/RefCounted.h"
+#include <mutex>
+#include <vector>
+
+namespace qore {
+
+constexpr Size RefCounted::DeferredBatchSize;
+constexpr std::intptr_t RefCounted::Merged;
+constexpr std::intptr_t RefCounted::Queued;
+constexpr std::intptr_t RefCounted::Immortal;
+constexpr std::intptr_t RefCounted::FlagMask;
+constexpr int RefCounted::CountShift;
+constexpr std::intptr_t RefCounted::SharedUnit;
+
+/**
+ * \brief Represents a thread that owns reference-counted objects.
+ *
+ * Records are never deallocated - when a thread terminates, its record is returned to a pool and later adopted by
+ * another thread together with the ownership of all objects that still refer to it. This guarantees that other
+ * threads can always queue objects to the owner record.
+ */
+class RefCounted::Owner {
+
+public:
+    /**
+     * \brief Returns the owner record of the current thread, creating it if necessary. Merges queued objects.
+     * \return the owner record of the current thread or `nullptr` if the thread is terminating
+     */
+    static Owner *current() {
+        Owner *&owner = currentOwner();
+        if (owner) {
+            if (owner->pending.load(std::memory_order_acquire)) {
+                owner->processQueue();
+            }
+            return owner;
+        }
+        if (terminating) {
+            return nullptr;
+        }
+        owner = acquire();
+        guard.owner = owner;
+        return owner;
+    }
+
+    /**
+     * \brief Queues an object whose shared counter became negative for explicit merge by the owner.
+     * \param obj the object to queue
+     */
+    void enqueue(RefCounted *obj) {
+        std::unique_lock<std::recursive_mutex> lock(mutex);
+        if (alive) {
+            queue.push_back(obj);
+            pending.store(true, std::memory_order_release);
+        } else {
+            //no thread owns the record at the moment - the lock prevents adoption so it is safe to merge here
+            obj->mergeQueued();
+        }
+    }
+
+private:
+    Owner() : alive(false), pending(false) {
+    }
+
+    void processQueue() {
+        std::vector<RefCounted *> objs;
+        {
+            std::unique_lock<std::recursive_mutex> lock(mutex);
+            objs.swap(queue);
+            pending.store(false, std::memory_order_relaxed);
+        }
+        for (RefCounted *obj : objs) {
+            obj->mergeQueued();
+        }
+    }
+
+    static Owner *acquire() {
+        Owner *owner;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex());
+            std::vector<Owner *> &p = pool();
+            if (p.empty()) {
+                owner = new Owner();
+            } else {
+                owner = p.back();
+                p.pop_back();
+            }
+        }
+        std::unique_lock<std::recursive_mutex> lock(owner->mutex);
+        owner->alive = true;
+        return owner;
+    }
+
+    void release() {
+        while (true) {
+            {
+                std::unique_lock<std::recursive_mutex> lock(mutex);
+                if (queue.empty()) {
+                    alive = false;
+                    pending.store(false, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            processQueue();
+        }
+        std::unique_lock<std::mutex> lock(poolMutex());
+        pool().push_back(this);
+    }
+
+    static std::mutex &poolMutex() {
+        static std::mutex *m = new std::mutex();
+        return *m;
+    }
+
+    static std::vector<Owner *> &pool() {
+        static std::vector<Owner *> *p = new std::vector<Owner *>();
+        return *p;
+    }
+
+    /**
+     * \brief Returns the owner record to the pool when the thread terminates.
+     */
+    class Guard {
+    public:
+        Guard() : owner(nullptr) {
+        }
+
+        ~Guard() {
+            terminating = true;
+            currentOwner() = nullptr;
+            if (owner) {
+                owner->release();
+            }
+        }
+
+        Owner *owner;
+    };
+
+private:
+    std::recursive_mutex mutex;
+    bool alive;
+    std::atomic<bool> pending;
+    std::vector<RefCounted *> queue;
+
+    static thread_local Guard guard;
+    static thread_local bool terminating;
+};
+
+thread_local RefCounted::Owner::Guard RefCounted::Owner::guard;
+thread_local bool RefCounted::Owner::terminating = false;
+
+/**
+ * \brief Holds the objects released by decRefCountDeferred() until they are destroyed.
+ *
+ * Each thread has its own table, any objects left in it are destroyed when the thread terminates.
+ */
+class RefCounted::ZeroCountTable {
+
+public:
+    /**
+     * \brief Returns the table of the current thread.
+     * \return the table of the current thread
+     */
+    static ZeroCountTable &current() {
+        static thread_local ZeroCountTable table;
+        return table;
+    }
+
+    ~ZeroCountTable() {
+        drain();
+    }
+
+    /**
+     * \brief Adds an object whose reference count dropped to zero, drains the table if it is full.
+     * \param obj the object to add
+     */
+    void add(RefCounted *obj) {
+        objs.push_back(obj);
+        if (objs.size() >= DeferredBatchSize) {
+            drain();
+        }
+    }
+
+    /**
+     * \brief Destroys all objects in the table, including those released by their destructors.
+     */
+    void drain() {
+        while (!objs.empty()) {
+            std::vector<RefCounted *> batch;
+            batch.reserve(DeferredBatchSize);
+            batch.swap(objs);
+            for (RefCounted *obj : batch) {
+                delete obj;
+            }
+        }
+    }
+
+    Size size() const {
+        return objs.size();
+    }
+
+private:
+    ZeroCountTable() {
+        objs.reserve(DeferredBatchSize);
+    }
+
+private:
+    std::vector<RefCounted *> objs;
+};
+
+RefCounted::RefCounted() : owner(Owner::current()), biased(1), shared(0) {
+    if (!owner) {
+        //created by a terminating thread, start in the merged state
+        biased = 0;
+        shared.store(SharedUnit | Merged, std::memory_order_relaxed);
+    }
+}
+
+void *refCounted_ownerSlot() noexcept {
+    return &RefCounted::currentOwner();
+}
+
+void RefCounted::reclaimDeferred() noexcept {
+    ZeroCountTable::current().drain();
+}
+
+Size RefCounted::getDeferredCount() noexcept {
+    return ZeroCountTable::current().size();
+}
+
+void RefCounted::destroy(bool deferred) noexcept {
+    if (deferred) {
+        ZeroCountTable::current().add(this);
+    } else {
+        delete this;
+    }
+}
+
+void RefCounted::mergeOwn(bool deferred) noexcept {
+    std::intptr_t old = shared.fetch_or(Merged, std::memory_order_acq_rel);
+    if ((old & ~FlagMask) == 0 && !(old & Queued)) {
+        destroy(deferred);
+    }
+    //if the object is queued, it will be deleted (if needed) by processQueue()
+}
+
+void RefCounted::mergeQueued() noexcept {
+    std::intptr_t b = static_cast<std::intptr_t>(biased) << CountShift;
+    biased = 0;
+    std::intptr_t old = shared.load(std::memory_order_relaxed);
+    std::intptr_t n;
+    do {
+        n = ((old + b) | Merged) & ~Queued;
+    } while (!shared.compare_exchange_weak(old, n, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if ((n & ~FlagMask) == 0) {
+        delete this;
+    }
+}
+
+void RefCounted::decShared(bool deferred) noexcept {
+    std::intptr_t old = shared.load(std::memory_order_relaxed);
+    std::intptr_t n;
+    do {
+        if (old & Immortal) {
+            return;
+        }
+        n = old - SharedUnit;
+        if (!(n & Merged) && n < 0) {
+            n |= Queued;
+        }
+    } while (!shared.compare_exchange_weak(old, n, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    if (n & Merged) {
+        if ((n & ~FlagMask) == 0 && !(n & Queued)) {
+            destroy(deferred);
+        }
+    } else if ((n & Queued) && !(old & Queued)) {
+        owner->enqueue(this);
+    }
+}
+
+} // namespace qore
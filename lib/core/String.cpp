@@ -29,16 +29,125 @@
 ///
 //------------------------------------------------------------------------------
 #include "qore/core/String.h"
+#include <algorithm>
 #include <iostream>
-#include <sstream>
+#include <mutex>
+#include <vector>
+#include "qore/core/util/Numeric.h"
 
 namespace qore {
 
-qint String::toInt() const {
-    std::stringstream s(str);
-    qint i;
-    s >> i;
-    return i;
+constexpr Size String::RopeThreshold;
+
+/**
+ * \brief Returns the mutex guarding the flattening of given rope.
+ *
+ * Uses a fixed number of mutexes selected by the address of the string to avoid a mutex per instance.
+ * \param str the string
+ * \return the mutex to use
+ */
+static std::mutex &getFlattenMutex(const String *str) {
+    static std::mutex mutexes[64];
+    return mutexes[(reinterpret_cast<std::uintptr_t>(str) >> 4) % 64];
+}
+
+String::String(String *left, String *right) : left(left), right(right), length(left->length + right->length),
+        flat(false), intValue(0), intValueValid(false) {
+    left->incRefCount();
+    right->incRefCount();
+    LOG(this << " created from " << left << " and " << right);
+}
+
+String::String(qint value) : str(util::intLength(value), '\0'), left(nullptr), right(nullptr), length(str.size()),
+        flat(true), intValue(value), intValueValid(true) {
+    util::formatInt(value, &str[0]);
+    LOG(this << " created from " << value);
+}
+
+String::~String() {
+    releaseChildren();
+    LOG(this << " destroyed");
+}
+
+String *String::append(String *right) {
+    if (isUnique()) {
+        //nobody else can observe this instance, therefore it can be modified in place
+        const std::string &r = right->get();
+        get();
+        releaseChildren();
+        Size newLength = length + r.size();
+        if (str.capacity() < newLength) {
+            str.reserve(std::max(newLength, 2 * str.capacity()));
+        }
+        if (right == this) {
+            //r refers to str whose buffer may have just been reallocated
+            str.append(str, 0, newLength - length);
+        } else {
+            str.append(r);
+        }
+        length = newLength;
+        intValueValid.store(false, std::memory_order_relaxed);
+        incRefCount();
+        return this;
+    }
+    if (length + right->length < RopeThreshold) {
+        return new String(get() + right->get());
+    }
+    return new String(this, right);
+}
+
+void String::flatten() const {
+    std::lock_guard<std::mutex> lock(getFlattenMutex(this));
+    if (flat.load(std::memory_order_relaxed)) {
+        return;
+    }
+    //the children of rope nodes are immutable, so they can be traversed without locking
+    std::string result;
+    result.reserve(length);
+    std::vector<const String *> stack{right, left};
+    while (!stack.empty()) {
+        const String *s = stack.back();
+        stack.pop_back();
+        if (s->left && !s->flat.load(std::memory_order_acquire)) {
+            stack.push_back(s->right);
+            stack.push_back(s->left);
+        } else {
+            result.append(s->str);
+        }
+    }
+    str = std::move(result);
+    flat.store(true, std::memory_order_release);
+}
+
+void String::releaseChildren() {
+    if (!left) {
+        return;
+    }
+    //ropes are not balanced and can be very deep, so the children of nodes that are about to be destroyed are
+    //released here instead of recursively by their destructors
+    std::vector<String *> stack{right, left};
+    left = right = nullptr;
+    while (!stack.empty()) {
+        String *s = stack.back();
+        stack.pop_back();
+        if (s->left && s->isUnique()) {
+            stack.push_back(s->right);
+            stack.push_back(s->left);
+            s->left = s->right = nullptr;
+        }
+        s->decRefCount();
+    }
+}
+
+String *String::fromInt(qint value) {
+    return new String(value);
+}
+
+qint String::parseInt() const {
+    qint value = util::parseInt(get());
+    intValue.store(value, std::memory_order_relaxed);
+    intValueValid.store(true, std::memory_order_release);
+    return value;
 }
 
 } // namespace qore
@@ -0,0 +1,251 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the liveness analysis.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/code/Liveness.h"
+#include <vector>
+
+namespace qore {
+namespace code {
+
+/// \cond NoDoxygen
+namespace {
+
+class AccessCollector {
+
+public:
+    using ReturnType = void;
+
+public:
+    AccessCollector(std::vector<Temp> &uses, std::vector<Temp> &defs) : uses(uses), defs(defs) {
+    }
+
+    void visit(const Branch &ins) {
+        uses.push_back(ins.getCondition());
+    }
+
+    void visit(const ConstInt &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const ConstNothing &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const ConstString &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const ConvertAndBranch &ins) {
+        uses.push_back(ins.getArg());
+    }
+
+    void visit(const GlobalGet &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const GlobalInit &ins) {
+        uses.push_back(ins.getInitValue());
+    }
+
+    void visit(const GlobalLoad &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const GlobalLoadRef &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const GlobalSet &ins) {
+        uses.push_back(ins.getSrc());
+    }
+
+    void visit(const InvokeBinaryOperator &ins) {
+        uses.push_back(ins.getLeft());
+        uses.push_back(ins.getRight());
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const InvokeConversion &ins) {
+        uses.push_back(ins.getArg());
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const InvokeFunction &ins) {
+        uses.insert(uses.end(), ins.getArgs().begin(), ins.getArgs().end());
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const LocalGet &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const LocalLoadRef &ins) {
+        defs.push_back(ins.getDest());
+    }
+
+    void visit(const LocalSet &ins) {
+        uses.push_back(ins.getSrc());
+    }
+
+    void visit(const RefDec &ins) {
+        uses.push_back(ins.getTemp());
+    }
+
+    void visit(const RefDecDeferred &ins) {
+        uses.push_back(ins.getTemp());
+    }
+
+    void visit(const RefDecNoexcept &ins) {
+        uses.push_back(ins.getTemp());
+    }
+
+    void visit(const RefInc &ins) {
+        uses.push_back(ins.getTemp());
+    }
+
+    void visit(const Ret &ins) {
+        uses.push_back(ins.getValue());
+    }
+
+    void visit(const Instruction &ins) {
+        //no temporaries
+    }
+
+private:
+    std::vector<Temp> &uses;
+    std::vector<Temp> &defs;
+};
+
+} // namespace
+/// \endcond NoDoxygen
+
+Liveness::Liveness(const Function &f) : tempCount(f.getTempCount()) {
+    for (const Block &b : f.getBlocks()) {
+        blockIndex[&b] = blocks.size();
+        blocks.push_back(&b);
+    }
+    liveIn.resize(blocks.size(), Set(tempCount));
+    liveOut.resize(blocks.size(), Set(tempCount));
+
+    //blocks are mostly created in the order of the source code, so visiting them backwards converges quickly
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (Index i = blocks.size(); i-- > 0;) {
+            const Block &b = *blocks[i];
+            Set out(tempCount);
+            const Instruction *last = nullptr;
+            for (const Instruction &ins : b) {
+                last = &ins;
+            }
+            if (last) {
+                auto merge = [&](const Block &succ) {
+                    const Set &in = liveIn[indexOf(succ)];
+                    for (Index t = 0; t < tempCount; ++t) {
+                        if (in[t]) {
+                            out[t] = true;
+                        }
+                    }
+                };
+                if (last->getKind() == Instruction::Kind::Branch) {
+                    merge(static_cast<const Branch *>(last)->getTrueDest());
+                    merge(static_cast<const Branch *>(last)->getFalseDest());
+                } else if (last->getKind() == Instruction::Kind::ConvertAndBranch) {
+                    merge(static_cast<const ConvertAndBranch *>(last)->getTrueDest());
+                    merge(static_cast<const ConvertAndBranch *>(last)->getFalseDest());
+                } else if (last->getKind() == Instruction::Kind::Jump) {
+                    merge(static_cast<const Jump *>(last)->getDest());
+                }
+            }
+            Set in = transfer(b, out, nullptr);
+            if (in != liveIn[i] || out != liveOut[i]) {
+                liveIn[i] = std::move(in);
+                liveOut[i] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+}
+
+std::vector<Liveness::Set> Liveness::getOccupied(const Block &b) const {
+    std::vector<Set> occupied;
+    transfer(b, getLiveOut(b), &occupied);
+    return occupied;
+}
+
+Liveness::Set Liveness::transfer(const Block &b, const Set &out, std::vector<Set> *occupied) const {
+    std::vector<const Instruction *> code;
+    for (const Instruction &ins : b) {
+        code.push_back(&ins);
+    }
+    if (occupied) {
+        occupied->resize(code.size());
+    }
+
+    Set live = out;
+    std::vector<Temp> uses;
+    std::vector<Temp> defs;
+    for (Index i = code.size(); i-- > 0;) {
+        const Instruction &ins = *code[i];
+        uses.clear();
+        defs.clear();
+        getAccess(ins, uses, defs);
+        for (Temp t : defs) {
+            live[t.getIndex()] = false;
+        }
+        for (Temp t : uses) {
+            live[t.getIndex()] = true;
+        }
+        if (ins.getLpad()) {
+            const Set &lpadIn = liveIn[indexOf(*ins.getLpad())];
+            for (Index t = 0; t < tempCount; ++t) {
+                if (lpadIn[t]) {
+                    live[t] = true;
+                }
+            }
+        }
+        if (occupied) {
+            Set &o = (*occupied)[i];
+            o = live;
+            for (Temp t : defs) {
+                o[t.getIndex()] = true;
+            }
+        }
+    }
+    return live;
+}
+
+void Liveness::getAccess(const Instruction &ins, std::vector<Temp> &uses, std::vector<Temp> &defs) {
+    AccessCollector collector(uses, defs);
+    ins.accept(collector);
+}
+
+} // namespace code
+} // namespace qore
@@ -32,49 +32,85 @@
 #include <cassert>
 #include "Conversions.h"
 #include "qore/core/BinaryOperator.h"
+#include "qore/core/Conversion.h"
+#include "qore/core/InlineCache.h"
 #include "qore/core/String.h"
 #include "qore/core/Type.h"
 
 namespace qore {
 namespace impl {
 
+/**
+ * \brief Converts an operand of type `any` to the type expected by a binary operator.
+ *
+ * Unlike convertAny(), does not increase the reference count if no conversion is needed so that the operator
+ * can determine whether the operand is shared (see String::append()).
+ * \param value the value of the operand of type `any`
+ * \param type the type expected by the operator
+ * \param conversion the conversion of the actual type of `value` to `type` as returned by Conversion::find()
+ * \return the operand, responsible for decreasing the reference count if needed
+ */
+static auto_ptr<qvalue> convertOperand(qvalue value, const Type &type, const Conversion *conversion) {
+    if (value.isHeapObject() && type.isRefCounted() && conversion == nullptr) {
+        return auto_ptr<qvalue>(value, false);
+    }
+    return auto_ptr<qvalue>(convertAny(value, type, conversion), type.isRefCounted());
+}
+
 /**
  * \brief Performs a binary operation determined at runtime based on the actual types of operands.
  * \param kind the kind of the binary operator to perform
- * \param l the value of the left operand, must be reference counted (the `p` member is active) but may be `nullptr`
- * \param r the value of the right operand, must be reference counted (the `p` member is active) but may be `nullptr`
+ * \param l the value of the left operand of type `any` (see \ref qvalue for the representation)
+ * \param r the value of the right operand of type `any` (see \ref qvalue for the representation)
  * \return the result of the operation with reference count increased (it is always reference counted)
  * \throws Exception if the specified kind of binary operator does not apply for the types of the values
  */
 static qvalue binOpGeneric(BinaryOperator::Kind kind, qvalue l, qvalue r) {
-    const BinaryOperator &op = BinaryOperator::find(kind,
-            l.p ? l.p->getType() : Type::Nothing, r.p ? r.p->getType() : Type::Nothing);
+    const BinaryOperator &op = BinaryOperator::find(kind, Any::typeOf(l), Any::typeOf(r));
+    return binOpResolved(op, Conversion::find(Any::typeOf(l), op.getLeftType()),
+            Conversion::find(Any::typeOf(r), op.getRightType()), l, r);
+}
 
+qvalue binOpResolved(const BinaryOperator &op, const Conversion *leftConversion,
+        const Conversion *rightConversion, qvalue l, qvalue r) {
     auto_ptr<qvalue> result;
     {
-        auto_ptr<qvalue> left(convertAny(l, op.getLeftType()), op.getLeftType().isRefCounted());
+        auto_ptr<qvalue> left(convertOperand(l, op.getLeftType(), leftConversion));
         {
-            auto_ptr<qvalue> right(convertAny(r, op.getRightType()), op.getRightType().isRefCounted());
+            auto_ptr<qvalue> right(convertOperand(r, op.getRightType(), rightConversion));
             result = auto_ptr<qvalue>(op.getFunction()(*left, *right), op.getResultType().isRefCounted());
         }
     }
     if (op.getResultType() == Type::Int) {
         return convertIntToAny(*result);
     }
-    //XXX boxing of float and bool
+    if (op.getResultType() == Type::Bool) {
+        return qvalue::tagBool((*result).b);
+    }
+    //XXX boxing of float
     return result.release();
 }
 
 qvalue binOpAnyPlusAny(qvalue left, qvalue right) {
-    LOG("binOpAnyPlusAny: " << left.p << " + " << right.p);
+    LOG("binOpAnyPlusAny: " << Any::typeOf(left) << " + " << Any::typeOf(right));
     return binOpGeneric(BinaryOperator::Kind::Plus, left, right);
 }
 
 qvalue binOpAnyPlusEqualsAny(qvalue left, qvalue right) {
-    LOG("binOpAnyPlusEqualsAny: " << left.p << " + " << right.p);
+    LOG("binOpAnyPlusEqualsAny: " << Any::typeOf(left) << " + " << Any::typeOf(right));
     return binOpGeneric(BinaryOperator::Kind::PlusEquals, left, right);
 }
 
+qvalue binOpAnyPlusAnyCached(BinaryOperatorCache *cache, qvalue left, qvalue right) {
+    LOG("binOpAnyPlusAnyCached: " << Any::typeOf(left) << " + " << Any::typeOf(right));
+    return cache->invoke(BinaryOperator::Kind::Plus, left, right);
+}
+
+qvalue binOpAnyPlusEqualsAnyCached(BinaryOperatorCache *cache, qvalue left, qvalue right) {
+    LOG("binOpAnyPlusEqualsAnyCached: " << Any::typeOf(left) << " + " << Any::typeOf(right));
+    return cache->invoke(BinaryOperator::Kind::PlusEquals, left, right);
+}
+
 qvalue binOpSoftStringPlusSoftString(qvalue left, qvalue right) {
     assert(left.p->getType() == Type::String && right.p->getType() == Type::String);
     LOG("binOpSoftStringPlusSoftString(" << left.p << ", " << right.p << ")");
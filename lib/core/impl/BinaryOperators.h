@@ -34,6 +34,11 @@
 #include "qore/core/Value.h"
 
 namespace qore {
+
+class BinaryOperator;
+class BinaryOperatorCache;
+class Conversion;
+
 namespace impl {
 
 ///\name Binary operators
@@ -61,6 +66,36 @@ extern "C" qvalue binOpSoftStringPlusSoftString(qvalue left, qvalue right);
 extern "C" qvalue binOpSoftIntPlusSoftInt(qvalue left, qvalue right) noexcept;
 ///\}
 
+///\name Cached binary operators
+///\{
+/**
+ * \brief Performs a binary operation on operands of type `any` using a polymorphic inline cache.
+ *
+ * For each binary operator with both operands of Type::Any, there is a variant named
+ * `binOpAny<Kind>AnyCached` which is used by generated code. The first argument points to the
+ * (zero-initialized) cache owned by the call site.
+ * \param cache the inline cache of the call site
+ * \param left the value of the left operand
+ * \param right the value of the right operand
+ * \return the result of the binary operation
+ */
+extern "C" qvalue binOpAnyPlusAnyCached(BinaryOperatorCache *cache, qvalue left, qvalue right);
+extern "C" qvalue binOpAnyPlusEqualsAnyCached(BinaryOperatorCache *cache, qvalue left, qvalue right);
+///\}
+
+/**
+ * \brief Performs a binary operation on operands of type `any` using an already resolved operator.
+ * \param op the binary operator as returned by BinaryOperator::find() for the actual types of the operands
+ * \param leftConversion the conversion of the left operand to the type expected by `op`
+ * \param rightConversion the conversion of the right operand to the type expected by `op`
+ * \param left the value of the left operand of type `any` (see \ref qvalue for the representation)
+ * \param right the value of the right operand of type `any` (see \ref qvalue for the representation)
+ * \return the result of the operation with reference count increased (it is always reference counted)
+ * \throws Exception if the operation fails
+ */
+qvalue binOpResolved(const BinaryOperator &op, const Conversion *leftConversion,
+        const Conversion *rightConversion, qvalue left, qvalue right);
+
 } // namespace impl
 } // namespace qore
 
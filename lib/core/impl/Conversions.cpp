@@ -31,6 +31,7 @@
 #include "Conversions.h"
 #include <cassert>
 #include "qore/core/Conversion.h"
+#include "qore/core/InlineCache.h"
 #include "qore/core/Int.h"
 #include "qore/core/String.h"
 
@@ -38,30 +39,42 @@ namespace qore {
 namespace impl {
 
 qvalue convertAny(qvalue src, const Type &type) {
-    const Type &srcType = src.p ? src.p->getType() : Type::Nothing;
-    const Conversion *conversion = Conversion::find(srcType, type);
+    return convertAny(src, type, Conversion::find(Any::typeOf(src), type));
+}
 
-    if (srcType == Type::Int) {
+qvalue convertAny(qvalue src, const Type &type, const Conversion *conversion) {
+    if (src.isTaggedInt()) {
+        src.i = src.untagInt();
+    } else if (src.isTaggedBool()) {
+        src.b = src.untagBool();
+    } else if (src.isHeapObject() && src.p->getType() == Type::Int) {
         src.i = static_cast<Int *>(src.p)->get();
     }
-    //XXX unboxing of bool and float
+    //XXX unboxing of float
 
     if (conversion != nullptr) {
         src = conversion->getFunction()(src);
-    } else if (type.isRefCounted()) {
+    } else if (type.isRefCounted() && src.isHeapObject()) {
         src.p->incRefCount();
     }
     return src;
 }
 
 qvalue convertAnyToString(qvalue value) {
-    LOG("convertAnyToString(" << value.p << ")");
+    LOG("convertAnyToString(" << Any::typeOf(value) << ")");
     return convertAny(value, Type::String);
 }
 
+qvalue convertAnyToStringCached(ConversionCache *cache, qvalue value) {
+    LOG("convertAnyToStringCached(" << Any::typeOf(value) << ")");
+    return cache->invoke(Type::String, value);
+}
+
 qvalue convertIntToAny(qvalue value) {
     LOG("convertIntToAny(" << value.i << ")");
-    //XXX instances can be cached if Int is immutable
+    if (qvalue::fitsTaggedInt(value.i)) {
+        return qvalue::tagInt(value.i);
+    }
     qvalue result;
     result.p = new Int(value.i);
     return result;
@@ -77,7 +90,7 @@ qvalue convertIntToBool(qvalue value) noexcept {
 qvalue convertIntToString(qvalue value) {
     LOG("convertIntToString(" << value.i << ")");
     qvalue result;
-    result.p = new String(std::to_string(value.i));
+    result.p = String::fromInt(value.i);
     return result;
 }
 
@@ -33,6 +33,11 @@
 #include "qore/core/Value.h"
 #include "qore/core/Type.h"
 
+namespace qore {
+class Conversion;
+class ConversionCache;
+} // namespace qore
+
 namespace qore {
 namespace impl {
 
@@ -64,13 +69,37 @@ extern "C" qvalue convertStringToInt(qvalue value);
 
 /**
  * \brief Converts a runtime value declared in the script as `any` to the specified type.
- * \param src the value to convert, must be reference counted (the `p` member is active) but may be `nullptr`
+ * \param src the value of type `any` to convert (see \ref qvalue for the representation)
  * \param type the destination type
  * \return a value of type `type` with reference count increased (if `type` is reference counted)
  * \throws Exception if no conversion exists
  */
 qvalue convertAny(qvalue src, const Type &type);
 
+/**
+ * \brief Converts a runtime value declared in the script as `any` using an already resolved conversion.
+ * \param src the value of type `any` to convert (see \ref qvalue for the representation)
+ * \param type the destination type
+ * \param conversion the conversion of the actual type of `src` to `type` as returned by Conversion::find()
+ * \return a value of type `type` with reference count increased (if `type` is reference counted)
+ * \throws Exception if the conversion fails
+ */
+qvalue convertAny(qvalue src, const Type &type, const Conversion *conversion);
+
+///\name Cached conversion functions
+///\{
+/**
+ * \brief Converts a value of type `any` using a polymorphic inline cache.
+ *
+ * For each conversion from Type::Any, there is a variant named `convert<ArgType>To<ResultType>Cached` which
+ * is used by generated code. The first argument points to the (zero-initialized) cache owned by the call site.
+ * \param cache the inline cache of the call site
+ * \param value the value to convert
+ * \return the result of the conversion
+ */
+extern "C" qvalue convertAnyToStringCached(ConversionCache *cache, qvalue value);
+///\}
+
 } // namespace impl
 } // namespace qore
 
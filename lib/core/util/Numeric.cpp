@@ -0,0 +1,199 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Conversions between numbers and their textual representation.
+///
+//------------------------------------------------------------------------------
+#include "qore/core/util/Numeric.h"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace qore {
+namespace util {
+
+static inline bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static inline int hexDigit(char c) {
+    if (isDigit(c)) {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/**
+ * \brief Determines whether all eight bytes of a chunk are decimal digits.
+ * \param chunk eight characters loaded as a little-endian word
+ * \return true if all eight characters are digits
+ */
+static inline bool allDigits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL;
+}
+
+/**
+ * \brief Converts eight decimal digits to their value using SWAR.
+ * \param chunk eight digits loaded as a little-endian word
+ * \return the value of the digits
+ */
+static inline uint64_t parseEightDigits(uint64_t chunk) {
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    return (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+            + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+}
+#define QORE_SWAR_DIGITS
+#endif
+
+qint parseInt(const char *begin, const char *end) noexcept {
+    const char *p = begin;
+    while (p < end && isSpace(*p)) {
+        ++p;
+    }
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p++ == '-';
+    }
+
+    //the magnitude of the limit in the direction of the sign
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<qint>::max()) + (negative ? 1 : 0);
+    uint64_t value = 0;
+    bool overflow = false;
+
+    if (end - p > 2 && p[0] == '0' && (p[1] | 0x20) == 'x' && hexDigit(p[2]) >= 0) {
+        p += 2;
+        for (int d; p < end && (d = hexDigit(*p)) >= 0; ++p) {
+            if (value > (limit - d) >> 4) {
+                overflow = true;
+                break;
+            }
+            value = (value << 4) | d;
+        }
+    } else {
+#ifdef QORE_SWAR_DIGITS
+        //value < 10^10 guarantees that value * 10^8 + 99999999 does not overflow the limit
+        while (end - p >= 8 && value < 10000000000ULL) {
+            uint64_t chunk;
+            memcpy(&chunk, p, 8);
+            if (!allDigits(chunk)) {
+                break;
+            }
+            value = value * 100000000ULL + parseEightDigits(chunk);
+            p += 8;
+        }
+#endif
+        for (; p < end && isDigit(*p); ++p) {
+            unsigned d = *p - '0';
+            if (value > (limit - d) / 10) {
+                overflow = true;
+                break;
+            }
+            value = value * 10 + d;
+        }
+    }
+
+    if (overflow) {
+        return negative ? std::numeric_limits<qint>::min() : std::numeric_limits<qint>::max();
+    }
+    return negative ? static_cast<qint>(0 - value) : static_cast<qint>(value);
+}
+
+static const char digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static inline Size countDigits(uint64_t v) {
+    static const uint64_t powersOf10[] = {0, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+        100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+        1000000000000000000ULL, 10000000000000000000ULL};
+#ifdef __GNUC__
+    //1233 / 4096 approximates log10(2), the estimate is either exact or one less than the number of digits
+    Size t = ((64 - __builtin_clzll(v | 1)) * 1233) >> 12;
+    return t + (v >= powersOf10[t] ? 1 : 0);
+#else
+    Size n = 1;
+    while (n < 20 && v >= powersOf10[n]) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+static inline uint64_t magnitude(qint value) {
+    return value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+}
+
+Size intLength(qint value) noexcept {
+    return (value < 0 ? 1 : 0) + countDigits(magnitude(value));
+}
+
+Size formatInt(qint value, char *buffer) noexcept {
+    uint64_t u = magnitude(value);
+    Size sign = value < 0 ? 1 : 0;
+    Size length = sign + countDigits(u);
+    char *p = buffer + length;
+    while (u >= 100) {
+        Size i = (u % 100) * 2;
+        u /= 100;
+        p -= 2;
+        memcpy(p, digitPairs + i, 2);
+    }
+    if (u >= 10) {
+        p -= 2;
+        memcpy(p, digitPairs + u * 2, 2);
+    } else {
+        *--p = static_cast<char>('0' + u);
+    }
+    if (sign) {
+        buffer[0] = '-';
+    }
+    return length;
+}
+
+} // namespace util
+} // namespace qore
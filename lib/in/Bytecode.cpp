@@ -0,0 +1,410 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Lowering of basic blocks to bytecode.
+///
+//------------------------------------------------------------------------------
+#include "qore/in/Bytecode.h"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include "qore/in/Tiering.h"
+
+namespace qore {
+namespace in {
+
+constexpr int Bytecode::OpcodeCount;
+
+///\cond
+class BytecodeBuilder {
+
+public:
+    using ReturnType = void;
+
+public:
+    BytecodeBuilder(Bytecode &bc, const Bytecode::Resolver &resolver)
+            : bc(bc), resolver(resolver), dispatchTable(Bytecode::getDispatchTable()), next(nullptr), start(0) {
+    }
+
+    void build(const code::Block &entryBlock) {
+        layout(entryBlock);
+        for (Index i = 0; i < order.size(); ++i) {
+            next = i + 1 < order.size() ? order[i + 1] : nullptr;
+            blockOffsets[order[i]] = bc.code.size();
+            for (const code::Instruction &ins : *order[i]) {
+                start = bc.code.size();
+                ins.accept(*this);
+                if (ins.getLpad()) {
+                    ranges.push_back(Range{start, bc.code.size(), ins.getLpad()});
+                }
+            }
+        }
+        for (const Fixup &f : fixups) {
+            bc.code[f.word].offset = static_cast<std::ptrdiff_t>(blockOffsets[f.dest])
+                    - static_cast<std::ptrdiff_t>(f.start);
+            if (f.word == f.start + 1 && bc.code[f.word].offset <= 0 && isJump(bc.code[f.start])) {
+                //backward jumps count the iterations of loops for tiering
+                setOpcode(bc.code[f.start], Bytecode::Opcode::JumpBack);
+            }
+        }
+        for (const Range &r : ranges) {
+            Index lpad = blockOffsets[r.lpad];
+            if (!bc.handlers.empty() && bc.handlers.back().end == r.begin && bc.handlers.back().lpad == lpad) {
+                bc.handlers.back().end = r.end;
+            } else {
+                bc.handlers.push_back(Bytecode::Handler{r.begin, r.end, lpad});
+            }
+        }
+    }
+
+    void visit(const code::Branch &ins) {
+        emit(Bytecode::Opcode::Branch);
+        emitIndex(ins.getCondition());
+        emitJump(ins.getTrueDest());
+        emitJump(ins.getFalseDest());
+    }
+
+    void visit(const code::ConstInt &ins) {
+        emit(Bytecode::Opcode::ConstInt);
+        emitIndex(ins.getDest());
+        emit().value = ins.getValue();
+    }
+
+    void visit(const code::ConstNothing &ins) {
+        emit(Bytecode::Opcode::ConstNothing);
+        emitIndex(ins.getDest());
+    }
+
+    void visit(const code::ConstString &ins) {
+        emit(Bytecode::Opcode::ConstString);
+        emitIndex(ins.getDest());
+        emit().string = &ins.getString();
+    }
+
+    void visit(const code::ConvertAndBranch &ins) {
+        emit(Bytecode::Opcode::ConvertAndBranch);
+        emit().conversion = &ins.getConversion().getFunction();
+        emitIndex(ins.getArg());
+        emitJump(ins.getTrueDest());
+        emitJump(ins.getFalseDest());
+    }
+
+    void visit(const code::GlobalGet &ins) {
+        emit(Bytecode::Opcode::GlobalGet);
+        emitIndex(ins.getDest());
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalInit &ins) {
+        emit(Bytecode::Opcode::GlobalInit);
+        emit().global = &ins.getGlobalVariable();
+        emitIndex(ins.getInitValue());
+    }
+
+    void visit(const code::GlobalLoad &ins) {
+        emit(Bytecode::Opcode::GlobalLoad);
+        emitIndex(ins.getDest());
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalLoadRef &ins) {
+        emit(Bytecode::Opcode::GlobalLoadRef);
+        emitIndex(ins.getDest());
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalReadLock &ins) {
+        emit(Bytecode::Opcode::GlobalReadLock);
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalReadUnlock &ins) {
+        emit(Bytecode::Opcode::GlobalReadUnlock);
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalSet &ins) {
+        emit(Bytecode::Opcode::GlobalSet);
+        emit().global = &ins.getGlobalVariable();
+        emitIndex(ins.getSrc());
+    }
+
+    void visit(const code::GlobalWriteLock &ins) {
+        emit(Bytecode::Opcode::GlobalWriteLock);
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::GlobalWriteUnlock &ins) {
+        emit(Bytecode::Opcode::GlobalWriteUnlock);
+        emit().global = &ins.getGlobalVariable();
+    }
+
+    void visit(const code::InvokeBinaryOperator &ins) {
+        const BinaryOperator &op = ins.getOperator();
+        if (op.isDynamic()) {
+            emit(Bytecode::Opcode::InvokeBinaryOperatorCached);
+            emitIndex(ins.getDest());
+            emit().binaryOperatorCache = &ins.getCache();
+            emit().binaryOperatorKind = op.getKind();
+        } else {
+            emit(Bytecode::Opcode::InvokeBinaryOperator);
+            emitIndex(ins.getDest());
+            emit().binaryOperator = &op.getFunction();
+        }
+        emitIndex(ins.getLeft());
+        emitIndex(ins.getRight());
+    }
+
+    void visit(const code::InvokeConversion &ins) {
+        const Conversion &conversion = ins.getConversion();
+        if (conversion.isDynamic()) {
+            emit(Bytecode::Opcode::InvokeConversionCached);
+            emitIndex(ins.getDest());
+            emit().conversionCache = &ins.getCache();
+            emit().type = &conversion.getToType();
+        } else {
+            emit(Bytecode::Opcode::InvokeConversion);
+            emitIndex(ins.getDest());
+            emit().conversion = &conversion.getFunction();
+        }
+        emitIndex(ins.getArg());
+    }
+
+    void visit(const code::InvokeFunction &ins) {
+        emit(Bytecode::Opcode::InvokeFunction);
+        emitIndex(ins.getDest());
+        emit().function = &resolver(ins.getFunction());
+        emit().count = ins.getArgs().size();
+        for (code::Temp arg : ins.getArgs()) {
+            emitIndex(arg);
+        }
+    }
+
+    void visit(const code::Jump &ins) {
+        if (&ins.getDest() != next) {
+            emit(Bytecode::Opcode::Jump);
+            emitJump(ins.getDest());
+        }
+    }
+
+    void visit(const code::LocalGet &ins) {
+        emit(Bytecode::Opcode::LocalGet);
+        emitIndex(ins.getDest());
+        emit().index = ins.getLocalVariable().getIndex();
+    }
+
+    void visit(const code::LocalLoadRef &ins) {
+        emit(Bytecode::Opcode::LocalLoadRef);
+        emitIndex(ins.getDest());
+        emit().index = ins.getLocalVariable().getIndex();
+    }
+
+    void visit(const code::LocalSet &ins) {
+        emit(Bytecode::Opcode::LocalSet);
+        emit().index = ins.getLocalVariable().getIndex();
+        emitIndex(ins.getSrc());
+    }
+
+    void visit(const code::RefDec &ins) {
+        emit(Bytecode::Opcode::RefDec);
+        emitIndex(ins.getTemp());
+    }
+
+    void visit(const code::RefDecDeferred &ins) {
+        emit(Bytecode::Opcode::RefDecDeferred);
+        emitIndex(ins.getTemp());
+    }
+
+    void visit(const code::RefDecNoexcept &ins) {
+        emit(Bytecode::Opcode::RefDecNoexcept);
+        emitIndex(ins.getTemp());
+    }
+
+    void visit(const code::RefInc &ins) {
+        emit(Bytecode::Opcode::RefInc);
+        emitIndex(ins.getTemp());
+    }
+
+    void visit(const code::RefReclaim &ins) {
+        emit(Bytecode::Opcode::RefReclaim);
+    }
+
+    void visit(const code::ResumeUnwind &ins) {
+        emit(Bytecode::Opcode::ResumeUnwind);
+    }
+
+    void visit(const code::Ret &ins) {
+        emit(Bytecode::Opcode::Ret);
+        emitIndex(ins.getValue());
+    }
+
+    void visit(const code::RetVoid &ins) {
+        emit(Bytecode::Opcode::RetVoid);
+    }
+
+private:
+    struct Fixup {
+        Index word;
+        Index start;
+        const code::Block *dest;
+    };
+
+    struct Range {
+        Index begin;
+        Index end;
+        const code::Block *lpad;
+    };
+
+    /**
+     * \brief Determines the order of blocks so that the target of an unconditional jump directly follows the jump
+     * whenever possible.
+     */
+    void layout(const code::Block &entryBlock) {
+        std::vector<const code::Block *> stack{&entryBlock};
+        while (!stack.empty()) {
+            const code::Block *b = stack.back();
+            stack.pop_back();
+            if (!blockOffsets.insert(std::make_pair(b, 0)).second) {
+                continue;
+            }
+            order.push_back(b);
+            //successors pushed last are placed first
+            const code::Instruction *last = nullptr;
+            for (const code::Instruction &ins : *b) {
+                if (ins.getLpad()) {
+                    stack.push_back(ins.getLpad());
+                }
+                last = &ins;
+            }
+            if (last && last->getKind() == code::Instruction::Kind::Branch) {
+                const code::Branch &branch = static_cast<const code::Branch &>(*last);
+                stack.push_back(&branch.getFalseDest());
+                stack.push_back(&branch.getTrueDest());
+            } else if (last && last->getKind() == code::Instruction::Kind::ConvertAndBranch) {
+                const code::ConvertAndBranch &branch = static_cast<const code::ConvertAndBranch &>(*last);
+                stack.push_back(&branch.getFalseDest());
+                stack.push_back(&branch.getTrueDest());
+            } else if (last && last->getKind() == code::Instruction::Kind::Jump) {
+                stack.push_back(&static_cast<const code::Jump &>(*last).getDest());
+            }
+        }
+    }
+
+    Bytecode::Word &emit() {
+        bc.code.emplace_back();
+        Bytecode::Word &w = bc.code.back();
+        w.value = 0;
+        return w;
+    }
+
+    void emit(Bytecode::Opcode opcode) {
+        setOpcode(emit(), opcode);
+    }
+
+    void setOpcode(Bytecode::Word &w, Bytecode::Opcode opcode) {
+        if (dispatchTable) {
+            w.handler = dispatchTable[static_cast<int>(opcode)];
+        } else {
+            w.opcode = opcode;
+        }
+    }
+
+    bool isJump(const Bytecode::Word &w) {
+        if (dispatchTable) {
+            return w.handler == dispatchTable[static_cast<int>(Bytecode::Opcode::Jump)];
+        }
+        return w.opcode == Bytecode::Opcode::Jump;
+    }
+
+    void emitIndex(code::Temp temp) {
+        emit().index = temp.getIndex();
+    }
+
+    void emitJump(const code::Block &dest) {
+        fixups.push_back(Fixup{bc.code.size(), start, &dest});
+        emit();
+    }
+
+private:
+    Bytecode &bc;
+    const Bytecode::Resolver &resolver;
+    const void *const *dispatchTable;
+    std::vector<const code::Block *> order;
+    std::unordered_map<const code::Block *, Index> blockOffsets;
+    std::vector<Fixup> fixups;
+    std::vector<Range> ranges;
+    const code::Block *next;
+    Index start;
+};
+///\endcond
+
+void Bytecode::lower(const code::Block &entryBlock, Size tempCount, Size localCount, const Resolver &resolver) {
+    assert(code.empty());
+    this->tempCount = tempCount;
+    this->localCount = localCount;
+    BytecodeBuilder(*this, resolver).build(entryBlock);
+}
+
+void Bytecode::enableTiering(const Function &f, Program &program) {
+    this->function = &f;
+    this->program = &program;
+    callThreshold = program.getTiering()->getOptions().callThreshold;
+    backEdgeThreshold = program.getTiering()->getOptions().backEdgeThreshold;
+}
+
+Bytecode::NativeCode Bytecode::promote() const {
+    //the counters of concurrent threads may reach the threshold at the same time, only one of them compiles
+    if (program && !promoting.exchange(true)) {
+        NativeCode code = program->getTiering()->compile(*function, *program);
+        if (code) {
+            nativeCode.store(code, std::memory_order_release);
+        }
+    }
+    return getNativeCode();
+}
+
+const Bytecode &Program::getBytecode(const Function &f) {
+    Bytecode::Ptr &ptr = functions[&f];
+    if (!ptr) {
+        ptr = Bytecode::Ptr(new Bytecode());
+        Bytecode &bc = *ptr;
+        if (tiering) {
+            bc.enableTiering(f, *this);
+        }
+        bc.lower(f.getEntryBlock(), f.getTempCount(), f.getLocalVariables().size(),
+                [this](const Function &callee) -> const Bytecode & { return getBytecode(callee); });
+        return bc;
+    }
+    return *ptr;
+}
+
+qvalue Program::run(const Function &f) {
+    return getBytecode(f).call(nullptr, 0);
+}
+
+} // namespace in
+} // namespace qore
@@ -0,0 +1,396 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Threaded interpreter of the bytecode.
+///
+//------------------------------------------------------------------------------
+#include "qore/in/Bytecode.h"
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include "qore/core/Exception.h"
+#include "qore/in/Stack.h"
+
+#if defined(__GNUC__) && !defined(QORE_SWITCH_DISPATCH)
+#define QORE_THREADED_DISPATCH
+#endif
+
+namespace qore {
+namespace in {
+
+/// \cond NoDoxygen
+#ifdef QORE_THREADED_DISPATCH
+#define OP(NAME)            L_ ## NAME:
+#define NEXT(N)             pc += N; goto *pc->handler
+#define DISPATCH_BEGIN      goto *pc->handler;
+#define DISPATCH_END
+#else
+#define OP(NAME)            case Bytecode::Opcode::NAME:
+#define NEXT(N)             pc += N; continue
+#define DISPATCH_BEGIN      for (;;) { switch (pc->opcode) {
+#define DISPATCH_END        default: QORE_UNREACHABLE("Invalid opcode " << static_cast<int>(pc->opcode)); } }
+#endif
+
+#define TEMP(N)             temps[pc[N].index]
+/// \endcond NoDoxygen
+
+/**
+ * \brief Executes bytecode.
+ *
+ * Handlers read the operands relative to `pc` and advance it only after the instruction has completed, so that
+ * `pc` identifies the instruction which has thrown an exception.
+ *
+ * Calls do not recurse, the state of the caller is saved in the stack's activation records and the callee is
+ * executed by the same loop. The loop returns when the activation it has been started with returns.
+ * \param bc the bytecode to execute or `nullptr` to just return the dispatch table
+ * \param stack the stack with the window of the activation already entered
+ * \param base the index of the window of the activation
+ * \param result receives the return value
+ * \return the table of handler addresses indexed by \ref Bytecode::Opcode if `bc` is `nullptr` and threaded
+ * dispatch is supported, `nullptr` otherwise
+ */
+static const void *const *interpret(const Bytecode *bc, Stack *stack, Index base, qvalue *result) {
+#ifdef QORE_THREADED_DISPATCH
+    static const void *const dispatchTable[] = {
+        &&L_Branch, &&L_ConstInt, &&L_ConstNothing, &&L_ConstString, &&L_ConvertAndBranch, &&L_GlobalGet,
+        &&L_GlobalInit, &&L_GlobalLoad, &&L_GlobalLoadRef, &&L_GlobalReadLock, &&L_GlobalReadUnlock, &&L_GlobalSet,
+        &&L_GlobalWriteLock, &&L_GlobalWriteUnlock, &&L_InvokeBinaryOperator, &&L_InvokeBinaryOperatorCached,
+        &&L_InvokeConversion, &&L_InvokeConversionCached, &&L_InvokeFunction, &&L_Jump, &&L_JumpBack,
+        &&L_LocalGet, &&L_LocalLoadRef, &&L_LocalSet, &&L_RefDec, &&L_RefDecDeferred, &&L_RefDecNoexcept,
+        &&L_RefInc, &&L_RefReclaim, &&L_ResumeUnwind, &&L_Ret, &&L_RetVoid,
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == Bytecode::OpcodeCount,
+            "Dispatch table does not match opcodes");
+    if (!bc) {
+        return dispatchTable;
+    }
+#else
+    if (!bc) {
+        return nullptr;
+    }
+#endif
+
+    const Size entryDepth = stack->getDepth();
+    const Index entryBase = base;
+    const Bytecode::Word *code = bc->getCode().data();
+    const Bytecode::Word *pc = code;
+    qvalue *locals = stack->at(base);
+    qvalue *temps = locals + bc->getLocalCount();
+    qvalue ret;
+    std::exception_ptr currentException;
+
+    /// \cond NoDoxygen
+    //switches to the activation with given bytecode and window, pc must be set afterwards
+    #define SWITCH_TO(BC, BASE) \
+        bc = (BC); \
+        code = bc->getCode().data(); \
+        base = (BASE); \
+        locals = stack->at(base); \
+        temps = locals + bc->getLocalCount();
+    /// \endcond NoDoxygen
+
+    while (true) {
+        try {
+            DISPATCH_BEGIN
+
+            OP(Branch) {
+                pc += TEMP(1).b ? pc[2].offset : pc[3].offset;
+                NEXT(0);
+            }
+            OP(ConstInt) {
+                TEMP(1).i = pc[2].value;
+                NEXT(3);
+            }
+            OP(ConstNothing) {
+                TEMP(1).p = nullptr;
+                NEXT(2);
+            }
+            OP(ConstString) {
+                TEMP(1).p = pc[2].string;
+                NEXT(3);
+            }
+            OP(ConvertAndBranch) {
+                pc += pc[1].conversion(TEMP(2)).b ? pc[3].offset : pc[4].offset;
+                NEXT(0);
+            }
+            OP(GlobalGet) {
+                TEMP(1) = pc[2].global->getValue();
+                NEXT(3);
+            }
+            OP(GlobalInit) {
+                pc[1].global->initValue(TEMP(2));
+                NEXT(3);
+            }
+            OP(GlobalLoad) {
+                GlobalVariable *gv = pc[2].global;
+                gv->readLock();
+                TEMP(1) = gv->getValue();
+                gv->readUnlock();
+                NEXT(3);
+            }
+            OP(GlobalLoadRef) {
+                GlobalVariable *gv = pc[2].global;
+                gv->readLock();
+                qvalue v = gv->getValue();
+                if (v.isHeapObject()) {
+                    v.p->incRefCount();
+                }
+                gv->readUnlock();
+                TEMP(1) = v;
+                NEXT(3);
+            }
+            OP(GlobalReadLock) {
+                pc[1].global->readLock();
+                NEXT(2);
+            }
+            OP(GlobalReadUnlock) {
+                pc[1].global->readUnlock();
+                NEXT(2);
+            }
+            OP(GlobalSet) {
+                pc[1].global->setValue(TEMP(2));
+                NEXT(3);
+            }
+            OP(GlobalWriteLock) {
+                pc[1].global->writeLock();
+                NEXT(2);
+            }
+            OP(GlobalWriteUnlock) {
+                pc[1].global->writeUnlock();
+                NEXT(2);
+            }
+            OP(InvokeBinaryOperator) {
+                TEMP(1) = pc[2].binaryOperator(TEMP(3), TEMP(4));
+                NEXT(5);
+            }
+            OP(InvokeBinaryOperatorCached) {
+                TEMP(1) = pc[2].binaryOperatorCache->invoke(pc[3].binaryOperatorKind, TEMP(4), TEMP(5));
+                NEXT(6);
+            }
+            OP(InvokeConversion) {
+                TEMP(1) = pc[2].conversion(TEMP(3));
+                NEXT(4);
+            }
+            OP(InvokeConversionCached) {
+                TEMP(1) = pc[2].conversionCache->invoke(*pc[3].type, TEMP(4));
+                NEXT(5);
+            }
+            OP(InvokeFunction) {
+                const Bytecode *callee = pc[2].function;
+                Size argCount = pc[3].count;
+                Bytecode::NativeCode native = callee->getNativeCode();
+                if (!native && callee->countCall()) {
+                    native = callee->promote();
+                }
+                if (native) {
+                    //native code does not use the stack, the window only holds the arguments during the call
+                    Index argsBase = stack->enter(argCount);
+                    locals = stack->at(base);
+                    temps = locals + bc->getLocalCount();
+                    qvalue *args = stack->at(argsBase);
+                    for (Index i = 0; i < argCount; ++i) {
+                        args[i] = TEMP(4 + i);
+                    }
+                    qvalue r;
+                    try {
+                        r = native(args);
+                    } catch (...) {
+                        stack->leave(argsBase);
+                        throw;
+                    }
+                    stack->leave(argsBase);
+                    //the native code may have called interpreted functions which reallocated the stack
+                    locals = stack->at(base);
+                    temps = locals + bc->getLocalCount();
+                    TEMP(1) = r;
+                    NEXT(4 + argCount);
+                }
+                Index calleeBase = stack->enter(callee->getFrameSize());
+                //the stack may have been reallocated
+                locals = stack->at(base);
+                temps = locals + bc->getLocalCount();
+                qvalue *args = stack->at(calleeBase);
+                for (Index i = 0; i < argCount; ++i) {
+                    args[i] = TEMP(4 + i);
+                }
+                stack->pushActivation(bc, pc - code, base, std::move(currentException));
+                currentException = nullptr;
+                SWITCH_TO(callee, calleeBase);
+                pc = code;
+                NEXT(0);
+            }
+            OP(Jump) {
+                NEXT(pc[1].offset);
+            }
+            OP(JumpBack) {
+                //the current activation stays interpreted even if the function gets promoted
+                if (bc->countBackEdge()) {
+                    bc->promote();
+                }
+                NEXT(pc[1].offset);
+            }
+            OP(LocalGet) {
+                TEMP(1) = locals[pc[2].index];
+                NEXT(3);
+            }
+            OP(LocalLoadRef) {
+                qvalue v = locals[pc[2].index];
+                if (v.isHeapObject()) {
+                    v.p->incRefCount();
+                }
+                TEMP(1) = v;
+                NEXT(3);
+            }
+            OP(LocalSet) {
+                locals[pc[1].index] = TEMP(2);
+                NEXT(3);
+            }
+            OP(RefDec) {
+                qvalue v = TEMP(1);
+                if (v.isHeapObject()) {
+                    v.p->decRefCount();
+                    //FIXME if an exception was created, throw it
+                }
+                NEXT(2);
+            }
+            OP(RefDecDeferred) {
+                qvalue v = TEMP(1);
+                if (v.isHeapObject()) {
+                    v.p->decRefCountDeferred();
+                }
+                NEXT(2);
+            }
+            OP(RefDecNoexcept) {
+                qvalue v = TEMP(1);
+                if (v.isHeapObject()) {
+                    v.p->decRefCount();
+                }
+                NEXT(2);
+            }
+            OP(RefInc) {
+                qvalue v = TEMP(1);
+                if (v.isHeapObject()) {
+                    v.p->incRefCount();
+                }
+                NEXT(2);
+            }
+            OP(RefReclaim) {
+                RefCounted::reclaimDeferred();
+                NEXT(1);
+            }
+            OP(ResumeUnwind) {
+                assert(currentException);
+                std::rethrow_exception(currentException);
+            }
+            OP(Ret) {
+                ret = TEMP(1);
+                goto L_return;
+            }
+            OP(RetVoid) {
+                ret.p = nullptr;
+                goto L_return;
+            }
+
+            DISPATCH_END
+
+        L_return:
+            stack->leave(base);
+            if (stack->getDepth() < entryDepth) {
+                *result = ret;
+                return nullptr;
+            }
+            {
+                Stack::Activation caller = stack->popActivation();
+                currentException = std::move(caller.exception);
+                SWITCH_TO(caller.bytecode, caller.base);
+                pc = code + caller.pc;
+                TEMP(1) = ret;
+                NEXT(4 + pc[3].count);
+            }
+        } catch (Exception &) {
+            //find the innermost activation with a landing pad for the current instruction
+            while (true) {
+                Index offset = pc - code;
+                const std::vector<Bytecode::Handler> &handlers = bc->getHandlers();
+                auto it = std::upper_bound(handlers.begin(), handlers.end(), offset,
+                        [](Index o, const Bytecode::Handler &h) { return o < h.end; });
+                if (it != handlers.end() && offset >= it->begin) {
+                    //activations entered by the throwing instruction (if any) are gone
+                    stack->unwindTo(base + bc->getFrameSize(), stack->getDepth());
+                    //the exception is kept for the ResumeUnwind instruction at the end of the landing pad
+                    currentException = std::current_exception();
+                    pc = code + it->lpad;
+                    break;
+                }
+                if (stack->getDepth() == entryDepth) {
+                    stack->leave(base);
+                    throw;
+                }
+                stack->leave(base);
+                Stack::Activation caller = stack->popActivation();
+                SWITCH_TO(caller.bytecode, caller.base);
+                pc = code + caller.pc;
+            }
+        } catch (...) {
+            //not a Qore exception (e.g. std::bad_alloc) - landing pads are not run, but the stack must be restored to
+            //the state before the call, otherwise later calls on this thread would see stale activations
+            stack->discard(entryBase, entryDepth);
+            throw;
+        }
+    }
+    #undef SWITCH_TO
+}
+
+#undef TEMP
+#undef DISPATCH_END
+#undef DISPATCH_BEGIN
+#undef NEXT
+#undef OP
+
+const void *const *Bytecode::getDispatchTable() {
+    return interpret(nullptr, nullptr, 0, nullptr);
+}
+
+qvalue Bytecode::call(const qvalue *args, Size argCount) const {
+    assert(!code.empty() && argCount <= localCount);
+    NativeCode native = getNativeCode();
+    if (!native && countCall()) {
+        native = promote();
+    }
+    if (native) {
+        return native(args);
+    }
+    Stack &stack = Stack::getCurrent();
+    Index base = stack.enter(getFrameSize());
+    std::copy(args, args + argCount, stack.at(base));
+    qvalue result;
+    interpret(this, &stack, base, &result);
+    return result;
+}
+
+} // namespace in
+} // namespace qore
@@ -30,16 +30,14 @@
 //------------------------------------------------------------------------------
 #include "qore/in/Interpreter.h"
 
-#include <vector>
-#include "qore/in/FunctionInterpreter.h"
+#include "qore/in/Bytecode.h"
 
 namespace qore {
 namespace in {
 
 void interpret(Function &f) {
-    Frame frame(f.getTempCount(), f.getLocalVariables().size());
-    FunctionInterpreter fi(frame, f.getEntryBlock());
-    fi.run();
+    Program program;
+    program.run(f);
 }
 
 } // namespace in
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the promotion of hot functions to native code.
+///
+//------------------------------------------------------------------------------
+#include "qore/in/Tiering.h"
+#include "qore/core/util/Debug.h"
+
+namespace qore {
+namespace in {
+
+Tiering::Stats Tiering::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+qvalue Tiering::invoke(const void *bytecode, const qvalue *args, Size argCount) {
+    return static_cast<const Bytecode *>(bytecode)->call(args, argCount);
+}
+
+Bytecode::NativeCode Tiering::compile(const Function &f, Program &program) {
+    //compilers are generally not thread-safe, hot functions are compiled one at a time
+    std::lock_guard<std::mutex> lock(mutex);
+    Bytecode::NativeCode code = compiler(f, program);
+    if (code) {
+        LOG("Promoted function " << &f << " to native code");
+        ++stats.promotions;
+        stats.promoted.push_back(&f);
+    } else {
+        ++stats.failures;
+    }
+    return code;
+}
+
+} // namespace in
+} // namespace qore
@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief The entry point of executables produced by the ahead-of-time compiler.
+///
+//------------------------------------------------------------------------------
+#include <iostream>
+#include "qore/core/Env.h"
+#include "qore/core/Exception.h"
+#include "qore/core/Value.h"
+
+/// \cond NoDoxygen
+extern "C" void qstart(qore::Env *env);
+extern "C" qore::qvalue qmain(const qore::qvalue *args);
+
+int main() {
+    qore::Env env;
+    qstart(&env);
+    try {
+        qmain(nullptr);
+    } catch (qore::Exception &) {
+        std::cerr << "Unhandled exception\n";
+        return 1;
+    }
+    return 0;
+}
+/// \endcond NoDoxygen
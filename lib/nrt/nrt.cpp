@@ -29,42 +29,45 @@
 ///
 //------------------------------------------------------------------------------
 #include "qore/nrt/nrt.h"
+#include <string>
+#include <vector>
 #include "qore/core/Env.h"
 
 namespace qore {
 namespace nrt {
 
 // cppcheck-suppress unusedFunction
-Namespace *env_getRootNamespace(Env *env) {
-    return &env->getRootNamespace();
-}
-
-// cppcheck-suppress unusedFunction
-SourceInfo *env_addSourceInfo(Env *env, const char *name) {
-    return &env->addSourceInfo(name);
-}
-
-// cppcheck-suppress unusedFunction
-qvalue env_addString(Env *env, const char *str) {
-    qvalue v;
-    v.p = &env->addString(str);
-    return v;
-}
-
-// cppcheck-suppress unusedFunction
-Namespace *namespace_addNamespace(Namespace *ns, const char *name, SourceInfo *sourceInfo, int location) {
-    return &ns->addNamespace(name, SourceLocation(*sourceInfo, location));
-}
-
-// cppcheck-suppress unusedFunction
-FunctionGroup *namespace_addFunctionGroup(Namespace *ns, const char *name) {
-    return &ns->addFunctionGroup(name);
-}
+void env_load(Env *env, const EnvTable *table) {
+    env->reserve(table->sourceInfoCount, table->stringCount);
+    std::vector<SourceInfo *> sourceInfos;
+    sourceInfos.reserve(table->sourceInfoCount);
+    for (int i = 0; i < table->sourceInfoCount; ++i) {
+        sourceInfos.push_back(&env->addSourceInfo(table->sourceInfos[i]));
+    }
+    for (int i = 0; i < table->stringCount; ++i) {
+        const StringEntry &e = table->strings[i];
+        e.slot->p = &env->addString(std::string(e.value, e.length));
+    }
 
-// cppcheck-suppress unusedFunction
-GlobalVariable *namespace_addGlobalVariable(Namespace *ns, const char *name, const Type *type,
-        SourceInfo *sourceInfo, int location) {
-    return &ns->addGlobalVariable(name, *type, SourceLocation(*sourceInfo, location));
+    std::vector<Namespace *> namespaces;
+    namespaces.reserve(table->namespaceCount);
+    auto ns = [env, &namespaces](int index) -> Namespace & {
+        return index < 0 ? env->getRootNamespace() : *namespaces[index];
+    };
+    for (int i = 0; i < table->namespaceCount; ++i) {
+        const NamespaceEntry &e = table->namespaces[i];
+        namespaces.push_back(&ns(e.parent).addNamespace(e.name, SourceLocation(*sourceInfos[e.sourceInfo],
+                e.location)));
+    }
+    for (int i = 0; i < table->globalVariableCount; ++i) {
+        const GlobalVariableEntry &e = table->globalVariables[i];
+        *e.slot = &ns(e.ns).addGlobalVariable(e.name, *e.type(), SourceLocation(*sourceInfos[e.sourceInfo],
+                e.location));
+    }
+    for (int i = 0; i < table->functionGroupCount; ++i) {
+        const FunctionGroupEntry &e = table->functionGroups[i];
+        ns(e.ns).addFunctionGroup(e.name);
+    }
 }
 
 // cppcheck-suppress unusedFunction
@@ -103,43 +106,91 @@ void globalVariable_writeUnlock(GlobalVariable *gv) {
 }
 
 // cppcheck-suppress unusedFunction
-const Type *type_String() {
+const Type *type_String() noexcept {
     return &Type::String;
 }
 
+// cppcheck-suppress unusedFunction
+qvalue global_load(GlobalVariable *gv) {
+    gv->readLock();
+    qvalue value = gv->getValue();
+    gv->readUnlock();
+    return value;
+}
+
+// cppcheck-suppress unusedFunction
+qvalue global_load_ref(GlobalVariable *gv) {
+    gv->readLock();
+    qvalue value = gv->getValue();
+    if (value.isHeapObject()) {
+        value.p->incRefCount();
+    }
+    gv->readUnlock();
+    return value;
+}
+
 // cppcheck-suppress unusedFunction
 void ref_dec(qvalue value) {
-    if (value.p) {
+    if (value.isHeapObject()) {
         value.p->decRefCount();
         //FIXME if an exception was created, throw it
     }
 }
 
 // cppcheck-suppress unusedFunction
-void ref_dec_noexcept(qvalue value) {
-    if (value.p) {
+void ref_dec_deferred(qvalue value) noexcept {
+    if (value.isHeapObject()) {
+        value.p->decRefCountDeferred();
+    }
+}
+
+// cppcheck-suppress unusedFunction
+void ref_dec_noexcept(qvalue value) noexcept {
+    if (value.isHeapObject()) {
         value.p->decRefCount();
     }
 }
 
 // cppcheck-suppress unusedFunction
-void ref_inc(qvalue value) {
-    if (value.p) {
+void ref_inc(qvalue value) noexcept {
+    if (value.isHeapObject()) {
         value.p->incRefCount();
     }
 }
 
 // cppcheck-suppress unusedFunction
-qvalue qint_to_qvalue(qint i) {
+void ref_reclaim() noexcept {
+    RefCounted::reclaimDeferred();
+}
+
+// cppcheck-suppress unusedFunction
+qvalue conversionCache_invoke(ConversionCache *cache, const Type *type, qvalue value) {
+    return cache->invoke(*type, value);
+}
+
+// cppcheck-suppress unusedFunction
+qvalue binaryOperatorCache_invoke(BinaryOperatorCache *cache, int kind, qvalue left, qvalue right) {
+    return cache->invoke(static_cast<BinaryOperator::Kind>(kind), left, right);
+}
+
+// cppcheck-suppress unusedFunction
+qvalue qint_to_qvalue(qint i) noexcept {
     qvalue v;
     v.i = i;
     return v;
 }
 
 // cppcheck-suppress unusedFunction
-qbool qvalue_to_qbool(qvalue v) {
+qbool qvalue_to_qbool(qvalue v) noexcept {
     return v.b;
 }
 
+// cppcheck-suppress unusedFunction
+qvalue qbool_to_qvalue(qbool b) noexcept {
+    qvalue v;
+    v.b = b;
+    return v;
+}
+
 } // namespace nrt
 } // namespace qore
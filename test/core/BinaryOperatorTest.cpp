@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/BinaryOperator.h"
+
+namespace qore {
+
+static const std::string &plus(const Type &left, const Type &right) {
+    return BinaryOperator::find(BinaryOperator::Kind::Plus, left, right).getFunctionName();
+}
+
+static const std::string &plusEquals(const Type &left, const Type &right) {
+    return BinaryOperator::find(BinaryOperator::Kind::PlusEquals, left, right).getFunctionName();
+}
+
+TEST(BinaryOperatorTest, plus) {
+    EXPECT_EQ("binOpAnyPlusAny", plus(Type::Any, Type::Any));
+    EXPECT_EQ("binOpAnyPlusAny", plus(Type::Any, Type::String));
+    EXPECT_EQ("binOpAnyPlusAny", plus(Type::Int, Type::Any));
+    EXPECT_EQ("binOpSoftStringPlusSoftString", plus(Type::String, Type::String));
+    EXPECT_EQ("binOpSoftStringPlusSoftString", plus(Type::Int, Type::String));
+    EXPECT_EQ("binOpSoftStringPlusSoftString", plus(Type::String, Type::Int));
+    EXPECT_EQ("binOpSoftIntPlusSoftInt", plus(Type::Int, Type::Int));
+    EXPECT_EQ("binOpSoftIntPlusSoftInt", plus(Type::Bool, Type::Int));
+}
+
+TEST(BinaryOperatorTest, plusEquals) {
+    EXPECT_EQ("binOpAnyPlusEqualsAny", plusEquals(Type::Any, Type::Int));
+    EXPECT_EQ("binOpSoftStringPlusSoftString", plusEquals(Type::String, Type::Any));
+    EXPECT_EQ("binOpSoftIntPlusSoftInt", plusEquals(Type::Int, Type::String));
+}
+
+TEST(BinaryOperatorTest, notImplemented) {
+    EXPECT_THROW(plus(Type::Bool, Type::Bool), util::NotImplemented);
+    EXPECT_THROW(plusEquals(Type::Bool, Type::Int), util::NotImplemented);
+
+    Type::Ptr t = Type::createForClass("A", false);
+    EXPECT_THROW(plus(*t, *t), util::NotImplemented);
+    EXPECT_EQ("binOpAnyPlusAny", plus(*t, Type::Any));
+}
+
+} // namespace qore
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/Conversion.h"
+
+namespace qore {
+
+TEST(ConversionTest, identity) {
+    EXPECT_EQ(nullptr, Conversion::find(Type::Int, Type::Int));
+    EXPECT_EQ(nullptr, Conversion::find(Type::Any, Type::Any));
+    EXPECT_EQ(nullptr, Conversion::find(Type::String, Type::SoftString));
+    EXPECT_EQ(nullptr, Conversion::find(Type::String, Type::Any));
+    EXPECT_EQ(nullptr, Conversion::find(Type::Int, Type::SoftInt));
+
+    Type::Ptr t = Type::createForClass("A", false);
+    EXPECT_EQ(nullptr, Conversion::find(*t, *t));
+}
+
+TEST(ConversionTest, find) {
+    EXPECT_EQ("convertAnyToString", Conversion::find(Type::Any, Type::String)->getFunctionName());
+    EXPECT_EQ("convertAnyToString", Conversion::find(Type::Any, Type::SoftString)->getFunctionName());
+    EXPECT_EQ("convertIntToAny", Conversion::find(Type::Int, Type::Any)->getFunctionName());
+    EXPECT_EQ("convertIntToBool", Conversion::find(Type::Int, Type::SoftBool)->getFunctionName());
+    EXPECT_EQ("convertIntToString", Conversion::find(Type::Int, Type::SoftString)->getFunctionName());
+    EXPECT_EQ("convertStringToInt", Conversion::find(Type::String, Type::SoftInt)->getFunctionName());
+    EXPECT_EQ(Type::Int, Conversion::find(Type::String, Type::SoftInt)->getToType());
+}
+
+TEST(ConversionTest, notImplemented) {
+    EXPECT_THROW(Conversion::find(Type::Int, Type::String), util::NotImplemented);
+    EXPECT_THROW(Conversion::find(Type::Bool, Type::Int), util::NotImplemented);
+
+    Type::Ptr t1 = Type::createForClass("A", false);
+    Type::Ptr t2 = Type::createForClass("B", false);
+    EXPECT_THROW(Conversion::find(*t1, *t2), util::NotImplemented);
+}
+
+} // namespace qore
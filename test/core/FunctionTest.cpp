@@ -0,0 +1,282 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/FunctionGroup.h"
+
+namespace qore {
+
+class FunctionTest : public ::testing::Test {
+
+protected:
+    FunctionTest() : group("::test"), f(group.addFunction(FunctionType(Type::Int), SourceLocation())),
+            gv("::gv", Type::Any, SourceLocation()) {
+    }
+
+    static std::vector<code::Instruction::Kind> kinds(const code::Block &b) {
+        std::vector<code::Instruction::Kind> result;
+        for (const code::Instruction &ins : b) {
+            result.push_back(ins.getKind());
+        }
+        return result;
+    }
+
+protected:
+    FunctionGroup group;
+    Function &f;
+    GlobalVariable gv;
+};
+
+using Kind = code::Instruction::Kind;
+
+TEST_F(FunctionTest, fuseGlobalAndLocalReads) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendGlobalReadLock(gv);
+    entry->appendGlobalGet(t0, gv);
+    entry->appendRefInc(t0);
+    entry->appendGlobalReadUnlock(gv);
+    entry->appendGlobalReadLock(gv);
+    entry->appendGlobalGet(t1, gv);
+    entry->appendGlobalReadUnlock(gv);
+    entry->appendLocalGet(t1, lv);
+    entry->appendRefInc(t1);
+    entry->appendLocalGet(t1, lv);
+    entry->appendRefInc(t0);
+    entry->appendRet(t0);
+
+    f.fuseInstructions();
+    EXPECT_EQ((std::vector<Kind>{Kind::GlobalLoadRef, Kind::GlobalLoad, Kind::LocalLoadRef, Kind::LocalGet,
+            Kind::RefInc, Kind::Ret}), kinds(*entry));
+}
+
+TEST_F(FunctionTest, fuseConvertAndBranch) {
+    const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+    LocalVariable &lv = f.addLocalVariable("a", Type::Int, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *yes = f.addBlock();
+    code::Block *no = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendInvokeConversion(t1, *toBool, t0, nullptr);
+    entry->appendBranch(t1, *yes, *no);
+    yes->appendRet(t0);
+    no->appendInvokeConversion(t1, *toBool, t0, nullptr);
+    no->appendBranch(t1, *yes, *entry);
+
+    f.fuseInstructions();
+    EXPECT_EQ((std::vector<Kind>{Kind::LocalGet, Kind::ConvertAndBranch}), kinds(*entry));
+    EXPECT_EQ((std::vector<Kind>{Kind::ConvertAndBranch}), kinds(*no));
+    f.compactTemps();
+    EXPECT_EQ(1U, f.getTempCount());
+}
+
+TEST_F(FunctionTest, conditionUsedLaterIsNotFused) {
+    const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+    LocalVariable &lv = f.addLocalVariable("a", Type::Int, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *exit = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendInvokeConversion(t1, *toBool, t0, nullptr);
+    entry->appendBranch(t1, *exit, *exit);
+    exit->appendRet(t1);
+
+    f.fuseInstructions();
+    EXPECT_EQ((std::vector<Kind>{Kind::LocalGet, Kind::InvokeConversion, Kind::Branch}), kinds(*entry));
+}
+
+TEST_F(FunctionTest, fusedInstructionKeepsLocation) {
+    SourceLocation location(SourceInfo::Invalid, 3, 5);
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    entry->setLocation(location);
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->setLocation(SourceLocation());
+    entry->appendRet(t0);
+
+    f.fuseInstructions();
+    ASSERT_EQ((std::vector<Kind>{Kind::LocalLoadRef, Kind::Ret}), kinds(*entry));
+    EXPECT_EQ(location.getPacked(), entry->begin()->getLocation().getPacked());
+    EXPECT_EQ(0, (++entry->begin())->getLocation().getPacked());
+}
+
+TEST_F(FunctionTest, elideRefCountsOfImmortalValuesAndMoves) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    code::Temp t2 = f.addTemp();
+    entry->appendConstNothing(t2);
+    entry->appendRefInc(t2);
+    entry->appendRefDecNoexcept(t2);
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendLocalGet(t1, lv);
+    entry->appendRefDec(t1, nullptr);
+    entry->appendRet(t0);
+
+    EXPECT_EQ(4U, f.elideRefCounts());
+    EXPECT_EQ((std::vector<Kind>{Kind::ConstNothing, Kind::LocalGet, Kind::LocalGet, Kind::Ret}), kinds(*entry));
+}
+
+TEST_F(FunctionTest, elideRefCountsAcrossLandingPad) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *lpad = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendInvokeFunction(t1, f, {}, lpad);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendRet(t1);
+    lpad->appendRefDecNoexcept(t0);
+    lpad->appendResumeUnwind();
+
+    EXPECT_EQ(3U, f.elideRefCounts());
+    EXPECT_EQ((std::vector<Kind>{Kind::LocalGet, Kind::InvokeFunction, Kind::Ret}), kinds(*entry));
+    EXPECT_EQ(nullptr, (++entry->begin())->getLpad());
+}
+
+TEST_F(FunctionTest, elideRefCountsKeepsReferenceOfLentValue) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendInvokeFunction(t1, f, {t0}, nullptr);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendRefDec(t1, nullptr);
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendRet(t0);
+
+    EXPECT_EQ(0U, f.elideRefCounts());
+    EXPECT_EQ(8U, kinds(*entry).size());
+}
+
+TEST_F(FunctionTest, elideRefCountsMovesLastUseToCallee) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *lpad = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendInvokeFunction(t1, f, {t0}, lpad);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendRet(t1);
+    lpad->appendRefDecNoexcept(t0);
+    lpad->appendLocalGet(t0, lv);
+    lpad->appendRefDecNoexcept(t0);
+    lpad->appendResumeUnwind();
+
+    EXPECT_EQ(3U, f.elideRefCounts());
+    EXPECT_EQ((std::vector<Kind>{Kind::LocalGet, Kind::InvokeFunction, Kind::LocalGet, Kind::RefDec, Kind::Ret}),
+            kinds(*entry));
+    EXPECT_EQ((std::vector<Kind>{Kind::LocalGet, Kind::RefDecNoexcept, Kind::ResumeUnwind}), kinds(*lpad));
+}
+
+TEST_F(FunctionTest, elideRefCountsKeepsReferenceOfValueReadInSuccessor) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *then = f.addBlock();
+    code::Block *other = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendInvokeFunction(t1, f, {t0}, nullptr);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendBranch(t1, *then, *other);
+    then->appendLocalGet(t0, lv);
+    then->appendRefInc(t0);
+    then->appendRet(t0);
+    other->appendRet(t1);
+
+    EXPECT_EQ(0U, f.elideRefCounts());
+    EXPECT_EQ(5U, kinds(*entry).size());
+}
+
+TEST_F(FunctionTest, elideRefCountsKeepsReferenceOfAliasedValue) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    code::Temp t2 = f.addTemp();
+    entry->appendLocalGet(t0, lv);
+    entry->appendRefInc(t0);
+    entry->appendLocalGet(t1, lv);
+    entry->appendRefInc(t1);
+    entry->appendInvokeFunction(t2, f, {t0, t1}, nullptr);
+    entry->appendRefDec(t1, nullptr);
+    entry->appendRefDec(t0, nullptr);
+    entry->appendRet(t2);
+
+    EXPECT_EQ(0U, f.elideRefCounts());
+    EXPECT_EQ(8U, kinds(*entry).size());
+}
+
+TEST_F(FunctionTest, elideRefCountsKeepsTransferredReference) {
+    LocalVariable &a = f.addLocalVariable("a", Type::Any, SourceLocation());
+    LocalVariable &b = f.addLocalVariable("b", Type::Any, SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, a);
+    entry->appendRefInc(t0);
+    entry->appendLocalSet(b, t0);
+    entry->appendLocalGet(t1, a);
+    entry->appendRefDec(t1, nullptr);
+    entry->appendLocalGet(t0, b);
+    entry->appendRefInc(t0);
+    entry->appendRet(t0);
+
+    EXPECT_EQ(0U, f.elideRefCounts());
+    EXPECT_EQ(8U, kinds(*entry).size());
+}
+
+TEST_F(FunctionTest, mangledName) {
+    EXPECT_EQ("_Z4testv", f.getMangledName());
+
+    FunctionGroup nested("::ns::inner::f");
+    FunctionType type(Type::Nothing);
+    type.addParameter(Type::Int);
+    type.addParameter(Type::StringOpt);
+    Function &g = nested.addFunction(std::move(type), SourceLocation());
+    EXPECT_EQ("_ZN2ns5inner1fEu3intu7*string", g.getMangledName());
+}
+
+} // namespace qore
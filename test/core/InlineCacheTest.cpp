@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/InlineCache.h"
+#include "qore/core/String.h"
+
+namespace qore {
+
+static String::Ptr toString(qvalue v) {
+    return String::Ptr(static_cast<String *>(v.p));
+}
+
+TEST(InlineCacheTest, binaryOperatorHit) {
+    BinaryOperatorCache cache;
+    InlineCache::Stats before = InlineCache::getStats();
+    qvalue r1 = cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(1), qvalue::tagInt(2));
+    qvalue r2 = cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(3), qvalue::tagInt(4));
+    InlineCache::Stats after = InlineCache::getStats();
+
+    EXPECT_EQ(3, r1.untagInt());
+    EXPECT_EQ(7, r2.untagInt());
+    EXPECT_EQ(1U, after.misses - before.misses);
+    EXPECT_EQ(1U, after.hits - before.hits);
+}
+
+TEST(InlineCacheTest, binaryOperatorPolymorphic) {
+    BinaryOperatorCache cache;
+    String::Ptr s(new String("ab"));
+    String::Ptr s2 = s.dup();
+    qvalue str;
+    str.p = s.get();
+
+    InlineCache::Stats before = InlineCache::getStats();
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(2, cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(1), qvalue::tagInt(1)).untagInt());
+        EXPECT_EQ("1ab", toString(cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(1), str))->get());
+        EXPECT_EQ("ab1", toString(cache.invoke(BinaryOperator::Kind::Plus, str, qvalue::tagInt(1)))->get());
+        EXPECT_EQ("abab", toString(cache.invoke(BinaryOperator::Kind::Plus, str, str))->get());
+    }
+    InlineCache::Stats after = InlineCache::getStats();
+
+    EXPECT_EQ("ab", s->get());
+    EXPECT_EQ(4U, after.misses - before.misses);
+    EXPECT_EQ(4U, after.hits - before.hits);
+}
+
+TEST(InlineCacheTest, binaryOperatorNotImplemented) {
+    BinaryOperatorCache cache;
+    qvalue nothing;
+    nothing.p = nullptr;
+    EXPECT_THROW(cache.invoke(BinaryOperator::Kind::Plus, nothing, nothing), util::NotImplemented);
+
+    InlineCache::Stats before = InlineCache::getStats();
+    EXPECT_THROW(cache.invoke(BinaryOperator::Kind::Plus, nothing, nothing), util::NotImplemented);
+    EXPECT_EQ(2, cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(1), qvalue::tagInt(1)).untagInt());
+    InlineCache::Stats after = InlineCache::getStats();
+    EXPECT_EQ(2U, after.misses - before.misses);
+    EXPECT_EQ(0U, after.hits - before.hits);
+}
+
+TEST(InlineCacheTest, conversion) {
+    ConversionCache cache;
+    String::Ptr s(new String("abc"));
+    qvalue str;
+    str.p = s.get();
+
+    InlineCache::Stats before = InlineCache::getStats();
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ("42", toString(cache.invoke(Type::SoftString, qvalue::tagInt(42)))->get());
+        String::Ptr r = toString(cache.invoke(Type::SoftString, str));
+        EXPECT_EQ(s.get(), r.get());
+    }
+    InlineCache::Stats after = InlineCache::getStats();
+    EXPECT_EQ(2U, after.misses - before.misses);
+    EXPECT_EQ(2U, after.hits - before.hits);
+}
+
+} // namespace qore
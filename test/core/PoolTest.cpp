@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "qore/core/Int.h"
+#include "qore/core/Pool.h"
+
+namespace qore {
+
+static bool isAligned(void *ptr) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % Pool::Granularity == 0;
+}
+
+TEST(PoolTest, reuse) {
+    void *p1 = Pool::allocate(40);
+    Pool::deallocate(p1, 40);
+    void *p2 = Pool::allocate(64);
+    EXPECT_EQ(p1, p2);
+    Pool::deallocate(p2, 64);
+}
+
+TEST(PoolTest, alignment) {
+    std::vector<std::pair<void *, Size>> v;
+    for (Size size = 1; size <= Pool::MaxSize; size += 7) {
+        void *p = Pool::allocate(size);
+        EXPECT_TRUE(isAligned(p));
+        v.emplace_back(p, size);
+    }
+    for (auto &p : v) {
+        Pool::deallocate(p.first, p.second);
+    }
+}
+
+TEST(PoolTest, large) {
+    void *p = Pool::allocate(Pool::MaxSize + 1);
+    EXPECT_NE(nullptr, p);
+    Pool::deallocate(p, Pool::MaxSize + 1);
+}
+
+TEST(PoolTest, freedByOtherThread) {
+    const Size count = 20000;
+    std::vector<void *> v;
+    for (Size i = 0; i < count; ++i) {
+        v.push_back(Pool::allocate(Pool::MaxSize));
+    }
+    std::thread([&v]() {
+        for (void *p : v) {
+            Pool::deallocate(p, Pool::MaxSize);
+        }
+    }).join();
+    //the objects have been returned to this thread's heap, so no new slabs are needed
+    Size reserved = Pool::getReservedSize();
+    for (Size i = 0; i < count; ++i) {
+        v[i] = Pool::allocate(Pool::MaxSize);
+    }
+    EXPECT_EQ(reserved, Pool::getReservedSize());
+    for (void *p : v) {
+        Pool::deallocate(p, Pool::MaxSize);
+    }
+}
+
+TEST(PoolTest, any) {
+    Int *i = new Int(42);
+    EXPECT_TRUE(isAligned(i));
+    std::thread([i]() { i->decRefCount(); }).join();
+}
+
+} // namespace qore
@@ -0,0 +1,196 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "qore/core/RefCounted.h"
+
+namespace qore {
+
+class TestObject : public RefCounted {
+
+public:
+    explicit TestObject(bool &destroyed) : destroyed(destroyed) {
+        destroyed = false;
+    }
+
+    ~TestObject() {
+        destroyed = true;
+    }
+
+private:
+    bool &destroyed;
+};
+
+TEST(RefCountedTest, singleThread) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    EXPECT_EQ(1, obj->getRefCount());
+    obj->incRefCount();
+    EXPECT_EQ(2, obj->getRefCount());
+    obj->decRefCount();
+    EXPECT_FALSE(destroyed);
+    obj->decRefCount();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(RefCountedTest, ownerReleasesLast) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    std::thread([obj]() { obj->incRefCount(); }).join();
+    obj->decRefCount();
+    EXPECT_FALSE(destroyed);
+    std::thread([obj]() { obj->decRefCount(); }).join();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(RefCountedTest, otherThreadReleasesLast) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    obj->incRefCount();
+    std::thread([obj]() { obj->decRefCount(); }).join();
+    EXPECT_FALSE(destroyed);
+    obj->decRefCount();
+    //the object has been queued for an explicit merge, which happens when the owner creates another object
+    bool destroyed2;
+    TestObject *obj2 = new TestObject(destroyed2);
+    EXPECT_TRUE(destroyed);
+    obj2->decRefCount();
+    EXPECT_TRUE(destroyed2);
+}
+
+TEST(RefCountedTest, ownerTerminates) {
+    bool destroyed;
+    TestObject *obj;
+    std::thread([&obj, &destroyed]() {
+        obj = new TestObject(destroyed);
+        obj->incRefCount();
+    }).join();
+    obj->decRefCount();
+    EXPECT_FALSE(destroyed);
+    obj->decRefCount();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(RefCountedTest, immortal) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    obj->makeImmortal();
+    obj->incRefCount();
+    obj->decRefCount();
+    obj->decRefCount();
+    std::thread([obj]() {
+        obj->incRefCount();
+        obj->decRefCount();
+        obj->decRefCount();
+    }).join();
+    EXPECT_FALSE(destroyed);
+    obj->makeMortal();
+    EXPECT_EQ(1, obj->getRefCount());
+    obj->decRefCount();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(RefCountedTest, concurrent) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        obj->incRefCount();
+        threads.emplace_back([obj]() {
+            for (int j = 0; j < 10000; ++j) {
+                obj->incRefCount();
+                obj->decRefCount();
+            }
+            obj->decRefCount();
+        });
+    }
+    for (int j = 0; j < 10000; ++j) {
+        obj->incRefCount();
+        obj->decRefCount();
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+    EXPECT_FALSE(destroyed);
+    obj->decRefCount();
+    bool destroyed2;
+    (new TestObject(destroyed2))->decRefCount();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST(RefCountedTest, deferred) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    obj->incRefCount();
+    obj->decRefCountDeferred();
+    EXPECT_FALSE(destroyed);
+    EXPECT_EQ(0U, RefCounted::getDeferredCount());
+    obj->decRefCountDeferred();
+    EXPECT_FALSE(destroyed);
+    EXPECT_EQ(1U, RefCounted::getDeferredCount());
+    RefCounted::reclaimDeferred();
+    EXPECT_TRUE(destroyed);
+    EXPECT_EQ(0U, RefCounted::getDeferredCount());
+}
+
+TEST(RefCountedTest, deferredBatch) {
+    std::unique_ptr<bool[]> destroyed(new bool[RefCounted::DeferredBatchSize]);
+    std::vector<TestObject *> objs;
+    for (Index i = 0; i < RefCounted::DeferredBatchSize; ++i) {
+        objs.push_back(new TestObject(destroyed[i]));
+    }
+    for (Index i = 0; i + 1 < RefCounted::DeferredBatchSize; ++i) {
+        objs[i]->decRefCountDeferred();
+    }
+    EXPECT_EQ(RefCounted::DeferredBatchSize - 1, RefCounted::getDeferredCount());
+    EXPECT_FALSE(destroyed[0]);
+    //the table is drained as soon as it becomes full
+    objs.back()->decRefCountDeferred();
+    EXPECT_EQ(0U, RefCounted::getDeferredCount());
+    for (Index i = 0; i < RefCounted::DeferredBatchSize; ++i) {
+        EXPECT_TRUE(destroyed[i]);
+    }
+}
+
+TEST(RefCountedTest, deferredOtherThreadReleasesLast) {
+    bool destroyed;
+    TestObject *obj = new TestObject(destroyed);
+    obj->incRefCount();
+    obj->decRefCountDeferred();
+    std::thread([obj, &destroyed]() {
+        obj->decRefCountDeferred();
+        EXPECT_EQ(0U, RefCounted::getDeferredCount());
+    }).join();
+    //the object has been queued for an explicit merge by the owner
+    EXPECT_FALSE(destroyed);
+    bool destroyed2;
+    (new TestObject(destroyed2))->decRefCount();
+    EXPECT_TRUE(destroyed);
+}
+
+} // namespace qore
@@ -0,0 +1,198 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <string>
+#include "gtest/gtest.h"
+#include "qore/core/String.h"
+
+namespace qore {
+
+TEST(StringTest, appendInPlaceWhenUnique) {
+    String *s = new String("abc");
+    String::Ptr r(new String("def"));
+    String *result = s->append(r.get());
+    EXPECT_EQ(s, result);
+    EXPECT_EQ("abcdef", result->get());
+    EXPECT_EQ(6U, result->getLength());
+    s->decRefCount();
+    result->decRefCount();
+}
+
+TEST(StringTest, appendToItselfInPlace) {
+    std::string expected(100, 'a');
+    String *s = new String(expected);
+    String *result = s->append(s);
+    EXPECT_EQ(s, result);
+    EXPECT_EQ(expected + expected, result->get());
+    s->decRefCount();
+    result->decRefCount();
+}
+
+TEST(StringTest, appendCopiesWhenShared) {
+    String::Ptr s(new String("abc"));
+    String::Ptr s2 = s.dup();
+    String::Ptr r(new String("def"));
+    String::Ptr result(s->append(r.get()));
+    EXPECT_NE(s.get(), result.get());
+    EXPECT_EQ("abc", s->get());
+    EXPECT_EQ("abcdef", result->get());
+}
+
+TEST(StringTest, appendCopiesWhenImmortal) {
+    String *s = new String("abc");
+    s->makeImmortal();
+    String::Ptr r(new String("def"));
+    String::Ptr result(s->append(r.get()));
+    EXPECT_NE(s, result.get());
+    EXPECT_EQ("abc", s->get());
+    s->makeMortal();
+    s->decRefCount();
+}
+
+TEST(StringTest, rope) {
+    std::string expected(300, 'a');
+    String::Ptr s(new String(expected));
+    String::Ptr s2 = s.dup();
+    String::Ptr r(new String("xyz"));
+    String::Ptr result(s->append(r.get()));
+    expected += "xyz";
+    EXPECT_EQ(expected.size(), result->getLength());
+    EXPECT_EQ(expected, result->get());
+}
+
+TEST(StringTest, deepRope) {
+    std::string expected(300, 'a');
+    String *s = new String(expected);
+    String::Ptr r(new String("0123456789"));
+    for (int i = 0; i < 1000; ++i) {
+        //s = s + r, where s is shared
+        s->incRefCount();
+        String *n = s->append(r.get());
+        s->decRefCount();
+        s->decRefCount();
+        s = n;
+        expected += r->get();
+    }
+    EXPECT_EQ(expected.size(), s->getLength());
+    EXPECT_EQ(expected, s->get());
+    s->decRefCount();
+}
+
+TEST(StringTest, deepRopeOnTheRight) {
+    std::string expected(300, 'a');
+    String *s = new String(expected);
+    String::Ptr l(new String("0123456789"));
+    String::Ptr l2 = l.dup();
+    for (int i = 0; i < 1000; ++i) {
+        //s = l + s, where both operands are shared
+        s->incRefCount();
+        String *n = l->append(s);
+        s->decRefCount();
+        s->decRefCount();
+        s = n;
+        expected = l->get() + expected;
+    }
+    EXPECT_EQ(expected.size(), s->getLength());
+    EXPECT_EQ(expected, s->get());
+    s->decRefCount();
+}
+
+TEST(StringTest, destroyVeryDeepRope) {
+    String *s = new String(std::string(300, 'a'));
+    String::Ptr r(new String("0123456789"));
+    for (int i = 0; i < 50000; ++i) {
+        s->incRefCount();
+        String *n = s->append(r.get());
+        s->decRefCount();
+        s->decRefCount();
+        s = n;
+    }
+    EXPECT_EQ(300U + 50000U * 10U, s->getLength());
+    s->decRefCount();
+}
+
+TEST(StringTest, readRopeWhileGrowing) {
+    std::string expected(300, 'a');
+    String *s = new String(expected);
+    String::Ptr r(new String("0123456789"));
+    for (int i = 0; i < 200; ++i) {
+        s->incRefCount();
+        String *n = s->append(r.get());
+        s->decRefCount();
+        s->decRefCount();
+        s = n;
+        expected += r->get();
+        ASSERT_EQ(expected, s->get());
+    }
+    s->decRefCount();
+}
+
+TEST(StringTest, appendToRopeInPlace) {
+    std::string expected(300, 'a');
+    String::Ptr s(new String(expected));
+    String::Ptr s2 = s.dup();
+    String::Ptr r(new String("xyz"));
+    String *rope = s->append(r.get());
+    String *result = rope->append(r.get());
+    EXPECT_EQ(rope, result);
+    expected += "xyzxyz";
+    EXPECT_EQ(expected, result->get());
+    rope->decRefCount();
+    result->decRefCount();
+}
+
+TEST(StringTest, concatenateFromInt) {
+    String::Ptr s(String::fromInt(-1234567890123456789));
+    EXPECT_EQ(20U, s->getLength());
+    String::Ptr r(new String("id="));
+    String::Ptr s2 = r.dup();
+    String::Ptr result(r->append(s.get()));
+    EXPECT_EQ("id=-1234567890123456789", result->get());
+    EXPECT_EQ("-1234567890123456789", s->get());
+}
+
+TEST(StringTest, appendFromIntInPlace) {
+    String *s = String::fromInt(4);
+    String::Ptr r(String::fromInt(2));
+    String *result = s->append(r.get());
+    EXPECT_EQ(s, result);
+    EXPECT_EQ("42", result->get());
+    EXPECT_EQ(42, result->toInt());
+    s->decRefCount();
+    result->decRefCount();
+}
+
+TEST(StringTest, ropeOfFromInt) {
+    std::string expected(300, 'a');
+    String::Ptr s(new String(expected));
+    String::Ptr s2 = s.dup();
+    String::Ptr r(String::fromInt(123));
+    String::Ptr result(s->append(r.get()));
+    expected += "123";
+    EXPECT_EQ(expected.size(), result->getLength());
+    EXPECT_EQ(expected, result->get());
+}
+
+} // namespace qore
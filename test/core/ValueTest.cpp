@@ -0,0 +1,85 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/String.h"
+#include "qore/core/Value.h"
+
+namespace qore {
+
+TEST(ValueTest, nothing) {
+    qvalue v;
+    v.p = nullptr;
+    EXPECT_FALSE(v.isHeapObject());
+    EXPECT_FALSE(v.isTaggedInt());
+    EXPECT_FALSE(v.isTaggedBool());
+    EXPECT_EQ(Type::Nothing, Any::typeOf(v));
+}
+
+TEST(ValueTest, taggedInt) {
+    for (qint i : {qint(0), qint(1), qint(-1), qint(42), qint(-123456789), INT64_MAX >> 1, INT64_MIN >> 1}) {
+        ASSERT_TRUE(qvalue::fitsTaggedInt(i));
+        qvalue v = qvalue::tagInt(i);
+        EXPECT_TRUE(v.isTaggedInt());
+        EXPECT_FALSE(v.isTaggedBool());
+        EXPECT_FALSE(v.isHeapObject());
+        EXPECT_EQ(i, v.untagInt());
+        EXPECT_EQ(Type::Int, Any::typeOf(v));
+    }
+    EXPECT_FALSE(qvalue::fitsTaggedInt(INT64_MAX));
+    EXPECT_FALSE(qvalue::fitsTaggedInt(INT64_MIN));
+    EXPECT_FALSE(qvalue::fitsTaggedInt((INT64_MAX >> 1) + 1));
+    EXPECT_FALSE(qvalue::fitsTaggedInt((INT64_MIN >> 1) - 1));
+}
+
+TEST(ValueTest, taggedBool) {
+    for (qbool b : {false, true}) {
+        qvalue v = qvalue::tagBool(b);
+        EXPECT_TRUE(v.isTaggedBool());
+        EXPECT_FALSE(v.isTaggedInt());
+        EXPECT_FALSE(v.isHeapObject());
+        EXPECT_EQ(b, v.untagBool());
+        EXPECT_EQ(Type::Bool, Any::typeOf(v));
+    }
+}
+
+TEST(ValueTest, heapObject) {
+    String::Ptr s(new String("abc"));
+    qvalue v;
+    v.p = s.get();
+    EXPECT_TRUE(v.isHeapObject());
+    EXPECT_FALSE(v.isTaggedInt());
+    EXPECT_FALSE(v.isTaggedBool());
+    EXPECT_EQ(Type::String, Any::typeOf(v));
+}
+
+TEST(ValueTest, autoPtrIgnoresTaggedValues) {
+    auto_ptr<qvalue> i(qvalue::tagInt(7), true);
+    auto_ptr<qvalue> b(qvalue::tagBool(true), true);
+    EXPECT_EQ(7, (*i).untagInt());
+    EXPECT_TRUE((*b).untagBool());
+}
+
+} // namespace qore
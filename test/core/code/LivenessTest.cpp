@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include "gtest/gtest.h"
+#include "qore/core/FunctionGroup.h"
+#include "qore/core/code/Liveness.h"
+
+namespace qore {
+namespace code {
+
+class LivenessTest : public ::testing::Test {
+
+protected:
+    LivenessTest() : str(new String("x")), group("::test"), f(group.addFunction(FunctionType(Type::Int), SourceLocation())) {
+    }
+
+    static std::vector<Index> collectTemps(const Block &b) {
+        std::vector<Index> temps;
+        std::vector<Temp> uses;
+        std::vector<Temp> defs;
+        for (const Instruction &ins : b) {
+            uses.clear();
+            defs.clear();
+            Liveness::getAccess(ins, uses, defs);
+            for (Temp t : uses) {
+                temps.push_back(t.getIndex());
+            }
+            for (Temp t : defs) {
+                temps.push_back(t.getIndex());
+            }
+        }
+        return temps;
+    }
+
+protected:
+    String::Ptr str;
+    FunctionGroup group;
+    Function &f;
+};
+
+TEST_F(LivenessTest, loop) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Int, SourceLocation());
+    Block *entry = f.addBlock();
+    Block *loop = f.addBlock();
+    Block *exit = f.addBlock();
+    Temp t0 = f.addTemp();
+    Temp t1 = f.addTemp();
+    entry->appendConstInt(t0, 1);
+    entry->appendJump(*loop);
+    loop->appendLocalGet(t1, lv);
+    loop->appendLocalSet(lv, t0);
+    loop->appendBranch(t1, *loop, *exit);
+    exit->appendRet(t0);
+
+    Liveness liveness(f);
+    EXPECT_FALSE(liveness.getLiveIn(*entry)[0]);
+    EXPECT_TRUE(liveness.getLiveOut(*entry)[0]);
+    EXPECT_TRUE(liveness.getLiveIn(*loop)[0]);
+    EXPECT_FALSE(liveness.getLiveIn(*loop)[1]);
+    EXPECT_TRUE(liveness.getLiveOut(*loop)[0]);
+    EXPECT_TRUE(liveness.getLiveIn(*exit)[0]);
+}
+
+TEST_F(LivenessTest, landingPadKeepsTempAlive) {
+    const Conversion *toAny = Conversion::find(Type::Int, Type::Any);
+    Block *entry = f.addBlock();
+    Block *lpad = f.addBlock();
+    Temp t0 = f.addTemp();
+    Temp t1 = f.addTemp();
+    Temp t2 = f.addTemp();
+    entry->appendConstString(t0, *str);
+    entry->appendConstInt(t1, 1);
+    entry->appendInvokeConversion(t2, *toAny, t1, lpad);
+    entry->appendRefDecNoexcept(t2);
+    entry->appendRefDecNoexcept(t0);
+    entry->appendRet(t1);
+    lpad->appendRefDecNoexcept(t0);
+    lpad->appendResumeUnwind();
+
+    Liveness liveness(f);
+    EXPECT_TRUE(liveness.getLiveIn(*lpad)[0]);
+    std::vector<Liveness::Set> occupied = liveness.getOccupied(*entry);
+    ASSERT_EQ(6U, occupied.size());
+    EXPECT_TRUE(occupied[2][0]);
+    EXPECT_TRUE(occupied[2][1]);
+    EXPECT_TRUE(occupied[2][2]);
+
+    f.compactTemps();
+    EXPECT_EQ(3U, f.getTempCount());
+}
+
+TEST_F(LivenessTest, compactTemps) {
+    LocalVariable &lv = f.addLocalVariable("a", Type::Int, SourceLocation());
+    Block *entry = f.addBlock();
+    Block *exit = f.addBlock();
+    for (int i = 0; i < 4; ++i) {
+        Temp t = f.addTemp();
+        entry->appendConstInt(t, i);
+        entry->appendLocalSet(lv, t);
+    }
+    Temp cond = f.addTemp();
+    Temp value = f.addTemp();
+    entry->appendConstInt(value, 42);
+    entry->appendLocalGet(cond, lv);
+    entry->appendBranch(cond, *exit, *exit);
+    exit->appendRet(value);
+    ASSERT_EQ(6U, f.getTempCount());
+
+    f.compactTemps();
+    EXPECT_EQ(2U, f.getTempCount());
+    EXPECT_EQ((std::vector<Index>{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1}), collectTemps(*entry));
+    EXPECT_EQ((std::vector<Index>{0}), collectTemps(*exit));
+}
+
+} // namespace code
+} // namespace qore
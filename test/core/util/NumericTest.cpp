@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <limits>
+#include <string>
+#include "gtest/gtest.h"
+#include "qore/core/String.h"
+#include "qore/core/util/Numeric.h"
+
+namespace qore {
+namespace util {
+
+TEST(NumericTest, parseIntDecimal) {
+    EXPECT_EQ(0, parseInt(""));
+    EXPECT_EQ(0, parseInt("0"));
+    EXPECT_EQ(7, parseInt("7"));
+    EXPECT_EQ(123, parseInt("123"));
+    EXPECT_EQ(12345678, parseInt("12345678"));
+    EXPECT_EQ(123456789012345678LL, parseInt("123456789012345678"));
+    EXPECT_EQ(1000000000000000000LL, parseInt("1000000000000000000"));
+    EXPECT_EQ(42, parseInt("0000000000000000000042"));
+}
+
+TEST(NumericTest, parseIntSign) {
+    EXPECT_EQ(-5, parseInt("-5"));
+    EXPECT_EQ(5, parseInt("+5"));
+    EXPECT_EQ(-1234567890123LL, parseInt("-1234567890123"));
+    EXPECT_EQ(0, parseInt("-"));
+    EXPECT_EQ(0, parseInt("+-1"));
+}
+
+TEST(NumericTest, parseIntWhitespaceAndGarbage) {
+    EXPECT_EQ(12, parseInt(" \t\n\r\f\v12"));
+    EXPECT_EQ(12, parseInt("12abc"));
+    EXPECT_EQ(12345678, parseInt("12345678x9"));
+    EXPECT_EQ(123456789, parseInt("123456789 123"));
+    EXPECT_EQ(0, parseInt("abc"));
+    EXPECT_EQ(0, parseInt(" - 1"));
+}
+
+TEST(NumericTest, parseIntHex) {
+    EXPECT_EQ(255, parseInt("0xff"));
+    EXPECT_EQ(255, parseInt("0XFF"));
+    EXPECT_EQ(-16, parseInt("-0x10"));
+    EXPECT_EQ(0x7FFFFFFFFFFFFFFFLL, parseInt("0x7fffffffffffffff"));
+    EXPECT_EQ(0, parseInt("0x"));
+    EXPECT_EQ(0, parseInt("0xg"));
+    EXPECT_EQ(10, parseInt("0xAg"));
+}
+
+TEST(NumericTest, parseIntLimits) {
+    EXPECT_EQ(std::numeric_limits<qint>::max(), parseInt("9223372036854775807"));
+    EXPECT_EQ(std::numeric_limits<qint>::min(), parseInt("-9223372036854775808"));
+    EXPECT_EQ(std::numeric_limits<qint>::max(), parseInt("9223372036854775808"));
+    EXPECT_EQ(std::numeric_limits<qint>::min(), parseInt("-9223372036854775809"));
+    EXPECT_EQ(std::numeric_limits<qint>::max(), parseInt("99999999999999999999999999999"));
+    EXPECT_EQ(std::numeric_limits<qint>::max(), parseInt("0x8000000000000000"));
+    EXPECT_EQ(std::numeric_limits<qint>::min(), parseInt("-0x8000000000000000"));
+    EXPECT_EQ(std::numeric_limits<qint>::min(), parseInt("-0x8000000000000001"));
+}
+
+TEST(NumericTest, stringToIntCache) {
+    String *s = new String("123");
+    EXPECT_EQ(123, s->toInt());
+    EXPECT_EQ(123, s->toInt());
+    String::Ptr r(new String("4"));
+    String *s2 = s->append(r.get());
+    EXPECT_EQ(1234, s2->toInt());
+    s->decRefCount();
+    s2->decRefCount();
+}
+
+static std::string format(qint value) {
+    char buffer[MaxIntLength];
+    return std::string(buffer, formatInt(value, buffer));
+}
+
+TEST(NumericTest, formatInt) {
+    EXPECT_EQ("0", format(0));
+    EXPECT_EQ("7", format(7));
+    EXPECT_EQ("-7", format(-7));
+    EXPECT_EQ("10", format(10));
+    EXPECT_EQ("99", format(99));
+    EXPECT_EQ("100", format(100));
+    EXPECT_EQ("-1000", format(-1000));
+    EXPECT_EQ("10000", format(10000));
+    EXPECT_EQ("123456789", format(123456789));
+    EXPECT_EQ("9223372036854775807", format(std::numeric_limits<qint>::max()));
+    EXPECT_EQ("-9223372036854775808", format(std::numeric_limits<qint>::min()));
+    for (qint v = 1; v > 0 && v <= std::numeric_limits<qint>::max() / 3; v = v * 3 + 1) {
+        EXPECT_EQ(std::to_string(v), format(v));
+        EXPECT_EQ(std::to_string(-v), format(-v));
+    }
+}
+
+TEST(NumericTest, stringFromInt) {
+    String::Ptr s(String::fromInt(-1234567));
+    EXPECT_EQ("-1234567", s->get());
+    EXPECT_EQ(-1234567, s->toInt());
+}
+
+} // namespace util
+} // namespace qore
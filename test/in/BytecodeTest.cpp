@@ -0,0 +1,391 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <new>
+#include "gtest/gtest.h"
+#include "qore/core/FunctionGroup.h"
+#include "qore/in/Bytecode.h"
+#include "qore/in/FunctionInterpreter.h"
+#include "qore/in/Stack.h"
+#include "qore/in/Tiering.h"
+
+namespace qore {
+namespace in {
+
+static Size nativeCalls;
+
+/**
+ * Native code of `sumDown()`.
+ */
+static qvalue nativeSumDown(const qvalue *args) {
+    ++nativeCalls;
+    qvalue r;
+    r.i = args[0].i * (args[0].i + 1) / 2;
+    return r;
+}
+
+static qvalue nativeThrow(const qvalue *args) {
+    throw StackOverflowException();
+}
+
+static qvalue nativeBadAlloc(const qvalue *args) {
+    throw std::bad_alloc();
+}
+
+class BytecodeTest : public ::testing::Test {
+
+protected:
+    BytecodeTest() : group("::test") {
+    }
+
+    /**
+     * Builds `int sub sumDown(int n) { int sum = 0; while (n) { sum += n; n += -1; } return sum; }`.
+     */
+    Function &createSumDown() {
+        FunctionType type(Type::Int);
+        type.addParameter(Type::Int);
+        Function &f = group.addFunction(std::move(type), SourceLocation());
+        LocalVariable &n = f.addLocalVariable("n", Type::Int, SourceLocation());
+        LocalVariable &sum = f.addLocalVariable("sum", Type::Int, SourceLocation());
+        const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+        const BinaryOperator &plus = BinaryOperator::find(BinaryOperator::Kind::Plus, Type::Int, Type::Int);
+
+        code::Block *entry = f.addBlock();
+        code::Block *loop = f.addBlock();
+        code::Block *body = f.addBlock();
+        code::Block *exit = f.addBlock();
+
+        code::Temp t0 = f.addTemp();
+        entry->appendConstInt(t0, 0);
+        entry->appendLocalSet(sum, t0);
+        entry->appendJump(*loop);
+
+        code::Temp t1 = f.addTemp();
+        code::Temp t2 = f.addTemp();
+        loop->appendLocalGet(t1, n);
+        loop->appendInvokeConversion(t2, *toBool, t1, nullptr);
+        loop->appendBranch(t2, *body, *exit);
+
+        code::Temp t3 = f.addTemp();
+        code::Temp t4 = f.addTemp();
+        code::Temp t5 = f.addTemp();
+        body->appendLocalGet(t3, sum);
+        body->appendLocalGet(t4, n);
+        body->appendInvokeBinaryOperator(t5, plus, t3, t4, nullptr);
+        body->appendLocalSet(sum, t5);
+        body->appendConstInt(t3, -1);
+        body->appendInvokeBinaryOperator(t5, plus, t4, t3, nullptr);
+        body->appendLocalSet(n, t5);
+        body->appendJump(*loop);
+
+        exit->appendLocalGet(t0, sum);
+        exit->appendRet(t0);
+        return f;
+    }
+
+    /**
+     * Builds `int sub countDown(int n) { if (n) return countDown(n + -1); return 0; }`.
+     */
+    Function &createCountDown() {
+        FunctionType type(Type::Int);
+        type.addParameter(Type::Int);
+        Function &f = group.addFunction(std::move(type), SourceLocation());
+        LocalVariable &n = f.addLocalVariable("n", Type::Int, SourceLocation());
+        const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+        const BinaryOperator &plus = BinaryOperator::find(BinaryOperator::Kind::Plus, Type::Int, Type::Int);
+
+        code::Block *entry = f.addBlock();
+        code::Block *recurse = f.addBlock();
+        code::Block *exit = f.addBlock();
+
+        code::Temp t0 = f.addTemp();
+        code::Temp t1 = f.addTemp();
+        entry->appendLocalGet(t0, n);
+        entry->appendInvokeConversion(t1, *toBool, t0, nullptr);
+        entry->appendBranch(t1, *recurse, *exit);
+
+        code::Temp t2 = f.addTemp();
+        code::Temp t3 = f.addTemp();
+        recurse->appendConstInt(t2, -1);
+        recurse->appendInvokeBinaryOperator(t3, plus, t0, t2, nullptr);
+        recurse->appendInvokeFunction(t2, f, {t3}, nullptr);
+        recurse->appendRet(t2);
+
+        exit->appendConstInt(t0, 0);
+        exit->appendRet(t0);
+        return f;
+    }
+
+    /**
+     * Builds a function that returns `callee(arg)`, with a landing pad protecting the call.
+     */
+    Function &createCaller(const Function &callee, qint arg) {
+        Function &f = group.addFunction(FunctionType(Type::Int), SourceLocation());
+        code::Block *entry = f.addBlock();
+        code::Block *lpad = f.addBlock();
+        code::Temp t0 = f.addTemp();
+        code::Temp t1 = f.addTemp();
+        entry->appendConstInt(t0, arg);
+        entry->appendInvokeFunction(t1, callee, {t0}, lpad);
+        entry->appendRet(t1);
+        lpad->appendResumeUnwind();
+        return f;
+    }
+
+protected:
+    FunctionGroup group;
+};
+
+TEST_F(BytecodeTest, loop) {
+    Function &f = createSumDown();
+    Program program;
+    const Bytecode &bc = program.getBytecode(f);
+    EXPECT_EQ(f.getTempCount(), bc.getTempCount());
+    EXPECT_EQ(2U, bc.getLocalCount());
+    EXPECT_TRUE(bc.getHandlers().empty());
+
+    for (qint n : {0, 1, 10, 1000}) {
+        qvalue arg;
+        arg.i = n;
+        EXPECT_EQ(n * (n + 1) / 2, bc.call(&arg, 1).i);
+    }
+}
+
+TEST_F(BytecodeTest, sameResultAsVisitor) {
+    Function &f = createSumDown();
+    Program program;
+    const Bytecode &bc = program.getBytecode(f);
+
+    qvalue arg;
+    arg.i = 77;
+
+    Frame frame(f.getTempCount(), f.getLocalVariables().size());
+    frame.locals[0] = arg;
+    FunctionInterpreter fi(frame, f.getEntryBlock());
+    fi.run();
+
+    EXPECT_EQ(frame.returnValue.i, bc.call(&arg, 1).i);
+}
+
+TEST_F(BytecodeTest, fusedInstructions) {
+    Function &f = createSumDown();
+    f.fuseInstructions();
+    f.compactTemps();
+    Program program;
+    const Bytecode &bc = program.getBytecode(f);
+
+    qvalue arg;
+    arg.i = 77;
+    EXPECT_EQ(77 * 78 / 2, bc.call(&arg, 1).i);
+
+    Frame frame(f.getTempCount(), f.getLocalVariables().size());
+    frame.locals[0] = arg;
+    FunctionInterpreter fi(frame, f.getEntryBlock());
+    fi.run();
+    EXPECT_EQ(77 * 78 / 2, frame.returnValue.i);
+}
+
+TEST_F(BytecodeTest, call) {
+    Function &callee = createSumDown();
+    Function &caller = createCaller(callee, 100);
+    Program program;
+    EXPECT_EQ(5050, program.run(caller).i);
+
+    const Bytecode &bc = program.getBytecode(caller);
+    ASSERT_EQ(1U, bc.getHandlers().size());
+    const Bytecode::Handler &h = bc.getHandlers()[0];
+    EXPECT_EQ(3U, h.begin);                         //after ConstInt
+    EXPECT_EQ(8U, h.end);                           //InvokeFunction with one argument
+    EXPECT_EQ(bc.getCode().size() - 1, h.lpad);     //ResumeUnwind is the last instruction
+}
+
+TEST_F(BytecodeTest, jumpToNextBlockIsOmitted) {
+    Function &f = group.addFunction(FunctionType(Type::Nothing), SourceLocation());
+    code::Block *entry = f.addBlock();
+    code::Block *next = f.addBlock();
+    entry->appendJump(*next);
+    next->appendRetVoid();
+
+    Program program;
+    EXPECT_EQ(1U, program.getBytecode(f).getCode().size());
+    program.run(f);
+}
+
+TEST_F(BytecodeTest, recursion) {
+    Function &f = createCountDown();
+    Program program;
+    const Bytecode &bc = program.getBytecode(f);
+    Stack &stack = Stack::getCurrent();
+    Index top = stack.getTop();
+    Size depth = stack.getDepth();
+
+    qvalue arg;
+    arg.i = 10000;
+    EXPECT_EQ(0, bc.call(&arg, 1).i);
+    EXPECT_EQ(top, stack.getTop());
+    EXPECT_EQ(depth, stack.getDepth());
+}
+
+TEST_F(BytecodeTest, stackOverflow) {
+    Function &f = createCountDown();
+    Function &caller = createCaller(f, 100);
+    Program program;
+    Stack &stack = Stack::getCurrent();
+    Index top = stack.getTop();
+    Size depth = stack.getDepth();
+    Size maxDepth = stack.getMaxDepth();
+
+    stack.setMaxDepth(depth + 50);
+    EXPECT_THROW(program.run(caller), StackOverflowException);
+    EXPECT_EQ(top, stack.getTop());
+    EXPECT_EQ(depth, stack.getDepth());
+
+    stack.setMaxDepth(depth + 200);
+    EXPECT_EQ(0, program.run(caller).i);
+    stack.setMaxDepth(maxDepth);
+}
+
+TEST_F(BytecodeTest, tieringPromotesAfterCallThreshold) {
+    Function &f = createSumDown();
+    Tiering::Options options;
+    options.callThreshold = 3;
+    options.backEdgeThreshold = 0;
+    Tiering tiering([](const Function &, Program &) { return &nativeSumDown; }, options);
+    Program program(&tiering);
+    const Bytecode &bc = program.getBytecode(f);
+    nativeCalls = 0;
+
+    qvalue arg;
+    arg.i = 10;
+    EXPECT_EQ(55, bc.call(&arg, 1).i);
+    EXPECT_EQ(55, bc.call(&arg, 1).i);
+    EXPECT_EQ(nullptr, bc.getNativeCode());
+    EXPECT_EQ(2U, bc.getCallCount());
+    EXPECT_EQ(0U, nativeCalls);
+
+    EXPECT_EQ(55, bc.call(&arg, 1).i);
+    EXPECT_EQ(&nativeSumDown, bc.getNativeCode());
+    EXPECT_EQ(1U, nativeCalls);
+    EXPECT_EQ(55, Tiering::invoke(&bc, &arg, 1).i);
+    EXPECT_EQ(2U, nativeCalls);
+    EXPECT_EQ(3U, bc.getCallCount());
+
+    Tiering::Stats stats = tiering.getStats();
+    EXPECT_EQ(1U, stats.promotions);
+    EXPECT_EQ(0U, stats.failures);
+    ASSERT_EQ(1U, stats.promoted.size());
+    EXPECT_EQ(&f, stats.promoted[0]);
+}
+
+TEST_F(BytecodeTest, tieringPromotesHotLoop) {
+    Function &f = createSumDown();
+    Tiering::Options options;
+    options.callThreshold = 0;
+    options.backEdgeThreshold = 100;
+    Tiering tiering([](const Function &, Program &) { return &nativeSumDown; }, options);
+    Program program(&tiering);
+    const Bytecode &bc = program.getBytecode(f);
+    nativeCalls = 0;
+
+    qvalue arg;
+    arg.i = 50;
+    EXPECT_EQ(1275, bc.call(&arg, 1).i);
+    EXPECT_EQ(nullptr, bc.getNativeCode());
+    EXPECT_EQ(50U, bc.getBackEdgeCount());
+
+    //the activation which triggered the promotion finishes in the interpreter
+    arg.i = 1000;
+    EXPECT_EQ(500500, bc.call(&arg, 1).i);
+    EXPECT_EQ(&nativeSumDown, bc.getNativeCode());
+    EXPECT_EQ(0U, nativeCalls);
+
+    EXPECT_EQ(500500, bc.call(&arg, 1).i);
+    EXPECT_EQ(1U, nativeCalls);
+}
+
+TEST_F(BytecodeTest, tieringFromInterpretedCaller) {
+    Function &callee = createSumDown();
+    Function &caller = createCaller(callee, 100);
+    Tiering::Options options;
+    options.callThreshold = 1;
+    Tiering tiering([&callee](const Function &f, Program &) {
+        return &f == &callee ? &nativeSumDown : nullptr;
+    }, options);
+    Program program(&tiering);
+    nativeCalls = 0;
+
+    EXPECT_EQ(5050, program.run(caller).i);
+    EXPECT_EQ(5050, program.run(caller).i);
+    EXPECT_EQ(2U, nativeCalls);
+    EXPECT_EQ(nullptr, program.getBytecode(caller).getNativeCode());
+
+    Tiering::Stats stats = tiering.getStats();
+    EXPECT_EQ(1U, stats.promotions);
+    EXPECT_EQ(1U, stats.failures);
+}
+
+TEST_F(BytecodeTest, tieringNativeException) {
+    Function &callee = createSumDown();
+    Function &caller = createCaller(callee, 100);
+    Tiering::Options options;
+    options.callThreshold = 1;
+    Tiering tiering([&callee](const Function &f, Program &) {
+        return &f == &callee ? &nativeThrow : nullptr;
+    }, options);
+    Program program(&tiering);
+    Stack &stack = Stack::getCurrent();
+    Index top = stack.getTop();
+    Size depth = stack.getDepth();
+
+    EXPECT_THROW(program.run(caller), StackOverflowException);
+    EXPECT_EQ(top, stack.getTop());
+    EXPECT_EQ(depth, stack.getDepth());
+}
+
+TEST_F(BytecodeTest, foreignExceptionInNestedActivation) {
+    Function &f = createCountDown();
+    Function &caller = createCaller(f, 100);
+    Tiering::Options options;
+    options.callThreshold = 10;
+    options.backEdgeThreshold = 0;
+    Tiering tiering([](const Function &, Program &) { return &nativeBadAlloc; }, options);
+    Program program(&tiering);
+    Stack &stack = Stack::getCurrent();
+    Index top = stack.getTop();
+    Size depth = stack.getDepth();
+
+    //the recursion is promoted to native code (which throws) ten activations deep
+    EXPECT_THROW(program.run(caller), std::bad_alloc);
+    EXPECT_EQ(top, stack.getTop());
+    EXPECT_EQ(depth, stack.getDepth());
+
+    Program interpreted;
+    EXPECT_EQ(0, interpreted.run(caller).i);
+    EXPECT_EQ(top, stack.getTop());
+    EXPECT_EQ(depth, stack.getDepth());
+}
+
+} // namespace in
+} // namespace qore
@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+#include <string>
+#include "gtest/gtest.h"
+#include "qore/comp/DirectiveProcessor.h"
+#include "qore/comp/Parser.h"
+#include "qore/comp/sem/Analyzer.h"
+#include "qore/core/Env.h"
+#include "qore/core/FunctionGroup.h"
+#include "qore/core/String.h"
+#include "qore/in/Bytecode.h"
+
+namespace qore {
+namespace in {
+
+/**
+ * Analyzes scripts and runs them through the bytecode interpreter.
+ */
+class ScriptTest : public ::testing::Test {
+
+protected:
+    ScriptTest() : diagMgr(stringTable), srcMgr(diagMgr), ctx(env, stringTable, diagMgr, srcMgr) {
+    }
+
+    /**
+     * Analyzes the script and runs its top level statements.
+     */
+    void execute(const std::string &script) {
+        comp::Source &src = srcMgr.createFromString(env.addSourceInfo("<test>"), script);
+        comp::DirectiveProcessor dp(ctx, src);
+        comp::Parser parser(ctx, dp);
+        comp::ast::Script::Ptr node = parser.parseScript();
+        if (Function *qinit = comp::sem::Analyzer::analyze(ctx, *node)) {
+            program.run(*qinit);
+        }
+    }
+
+    /**
+     * Runs the script and then the function with given name, which must return a string.
+     */
+    std::string run(const std::string &script, const std::string &name) {
+        execute(script);
+        for (const FunctionGroup &group : env.getRootNamespace().getFunctionGroups()) {
+            if (group.getFullName() == name) {
+                qvalue v = program.run(*group.getFunctions().begin());
+                std::string result = static_cast<String *>(v.p)->get();
+                v.p->decRefCount();
+                return result;
+            }
+        }
+        ADD_FAILURE() << "function " << name << " not found";
+        return "";
+    }
+
+protected:
+    Env env;
+    comp::StringTable stringTable;
+    comp::DiagManager diagMgr;
+    comp::SourceManager srcMgr;
+    comp::Context ctx;
+    Program program;
+};
+
+TEST_F(ScriptTest, operandOfConcatenationIsNotModified) {
+    EXPECT_EQ("aaaaaaaabbbb", run("string sub f() { string x = \"aaaaaaaa\"; x += \"bbbb\"; "
+            "string y = x + \"cccc\"; return x; }", "::f"));
+}
+
+TEST_F(ScriptTest, operandReadInLaterBlockIsNotModified) {
+    EXPECT_EQ("aaaaaaaabbbb", run("string sub f() { string x = \"aaaaaaaa\"; x += \"bbbb\"; "
+            "string y = x + \"cccc\"; if (1) { return x; } return y; }", "::f"));
+}
+
+TEST_F(ScriptTest, lastUseOfOperandIsConcatenated) {
+    EXPECT_EQ("aaaaaaaabbbbcccc", run("string sub f() { string x = \"aaaaaaaa\"; x += \"bbbb\"; "
+            "string y = x + \"cccc\"; return y; }", "::f"));
+}
+
+TEST_F(ScriptTest, literalHeldByGlobalIsReleasedOnce) {
+    //the environment is destroyed at the end of the test while ::g still refers to the literal
+    execute("our string g; sub f() { g = \"abc\"; } f();");
+}
+
+} // namespace in
+} // namespace qore
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+#include <string>
+#include "gtest/gtest.h"
+#include "qore/core/Env.h"
+#include "qore/nrt/nrt.h"
+
+namespace qore {
+namespace nrt {
+
+static const Type *typeString() {
+    return &Type::String;
+}
+
+TEST(EnvLoadTest, createsEntitiesFromTables) {
+    const char *sourceInfos[] = { "a.q", "b.q" };
+    qvalue str1, str2;
+    StringEntry strings[] = { { "abc", 3, &str1 }, { "x\0y", 3, &str2 } };
+    NamespaceEntry namespaces[] = { { "N", -1, 0, 5 }, { "M", 0, 1, 7 } };
+    GlobalVariable *gv = nullptr;
+    GlobalVariableEntry globals[] = { { "g", 1, 1, 9, &typeString, &gv } };
+    FunctionGroupEntry functionGroups[] = { { "f", -1 }, { "h", 0 } };
+    EnvTable table = { sourceInfos, 2, strings, 2, namespaces, 2, globals, 1, functionGroups, 2 };
+
+    Env env;
+    env_load(&env, &table);
+
+    auto infos = env.getSourceInfos();
+    ASSERT_EQ(2, infos.end() - infos.begin());
+    EXPECT_EQ("b.q", (*++infos.begin()).getName());
+
+    EXPECT_EQ("abc", static_cast<String *>(str1.p)->get());
+    EXPECT_EQ(std::string("x\0y", 3), static_cast<String *>(str2.p)->get());
+
+    Namespace &root = env.getRootNamespace();
+    ASSERT_EQ(1, root.getNamespaces().end() - root.getNamespaces().begin());
+    const Namespace &n = *root.getNamespaces().begin();
+    EXPECT_EQ("::N", n.getFullName());
+    ASSERT_EQ(1, n.getNamespaces().end() - n.getNamespaces().begin());
+    const Namespace &m = *n.getNamespaces().begin();
+    EXPECT_EQ("::N::M", m.getFullName());
+    EXPECT_EQ("b.q", m.getLocation().getSourceInfo().getName());
+
+    ASSERT_NE(nullptr, gv);
+    EXPECT_EQ(&*m.getGlobalVariables().begin(), gv);
+    EXPECT_EQ("::N::M::g", gv->getFullName());
+    EXPECT_EQ(Type::String, gv->getType());
+
+    EXPECT_EQ("::f", (*root.getFunctionGroups().begin()).getFullName());
+    EXPECT_EQ("::N::h", (*n.getFunctionGroups().begin()).getFullName());
+}
+
+} // namespace nrt
+} // namespace qore
@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Implementation of the microbenchmark harness and the main entry point.
+///
+//------------------------------------------------------------------------------
+#include "Bench.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace qore {
+namespace bench {
+
+static Benchmark *first = nullptr;
+static Benchmark **last = &first;
+static std::vector<std::string> notes;
+
+Benchmark::Benchmark(const char *name, Function function, Size iterations) : name(name), function(function),
+        iterations(iterations), next(nullptr) {
+    *last = this;
+    last = &next;
+}
+
+void Benchmark::runAll(const std::string &filter) {
+    for (Benchmark *b = first; b; b = b->next) {
+        if (std::string(b->name).find(filter) == std::string::npos) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        b->function(b->iterations);
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        std::cout << std::left << std::setw(48) << b->name
+                << std::right << std::setw(12) << b->iterations << " ops"
+                << std::setw(12) << std::fixed << std::setprecision(2) << ns / b->iterations << " ns/op"
+                << std::setw(12) << static_cast<Size>(ns / 1e6) << " ms" << std::endl;
+        for (const std::string &n : notes) {
+            std::cout << "    " << n << std::endl;
+        }
+        notes.clear();
+    }
+}
+
+void note(const std::string &text) {
+    notes.push_back(text);
+}
+
+Size residentSetSize() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    Size total = 0;
+    Size resident = 0;
+    if (statm >> total >> resident) {
+        return resident * static_cast<Size>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+Size threadCount() {
+    Size n = std::thread::hardware_concurrency();
+    return n < 2 ? 2 : n;
+}
+
+void parallel(std::function<void(Index)> f) {
+    std::vector<std::thread> threads;
+    for (Index i = 0; i < threadCount(); ++i) {
+        threads.emplace_back(f, i);
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+}
+
+} // namespace bench
+} // namespace qore
+
+int main(int argc, char *argv[]) {
+#ifdef QORE_LOGGING
+    std::cerr << "warning: logging is enabled, configure with -DQORE_LOGGING=OFF for meaningful results" << std::endl;
+#endif
+    qore::bench::Benchmark::runAll(argc > 1 ? argv[1] : "");
+    return 0;
+}
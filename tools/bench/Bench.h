@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Minimalistic microbenchmark harness.
+///
+//------------------------------------------------------------------------------
+#ifndef TOOLS_BENCH_BENCH_H_
+#define TOOLS_BENCH_BENCH_H_
+
+#include <functional>
+#include <string>
+#include "qore/core/Defs.h"
+
+namespace qore {
+namespace bench {
+
+/**
+ * \brief Describes a registered benchmark.
+ */
+class Benchmark {
+
+public:
+    /**
+     * \brief The type of the benchmark function, receives the number of operations to perform.
+     */
+    using Function = void (*)(Size iterations);
+
+    /**
+     * \brief Registers a benchmark.
+     * \param name the name of the benchmark
+     * \param function the function performing the benchmark
+     * \param iterations the number of operations to perform
+     */
+    Benchmark(const char *name, Function function, Size iterations);
+
+    /**
+     * \brief Runs all registered benchmarks whose name contains given string.
+     * \param filter the filter
+     */
+    static void runAll(const std::string &filter);
+
+private:
+    const char *name;
+    Function function;
+    Size iterations;
+    Benchmark *next;
+};
+
+/**
+ * \brief Prevents the compiler from optimizing away the computation of a value.
+ * \param value the value
+ */
+template<typename T>
+inline void doNotOptimize(const T &value) {
+#ifdef __GNUC__
+    asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+
+/**
+ * \brief Adds a line to the output of the benchmark that is currently running.
+ *
+ * The line is printed after the timing of the benchmark.
+ * \param text the text of the line
+ */
+void note(const std::string &text);
+
+/**
+ * \brief Returns the resident set size of the process.
+ * \return the resident set size in bytes or zero if it cannot be determined on this platform
+ */
+Size residentSetSize();
+
+/**
+ * \brief Returns the number of threads to use in multi-threaded benchmarks.
+ * \return the number of threads
+ */
+Size threadCount();
+
+/**
+ * \brief Runs a function in parallel in \ref threadCount() threads and waits for their completion.
+ * \param f the function to run, receives the index of the thread
+ */
+void parallel(std::function<void(Index)> f);
+
+} // namespace bench
+} // namespace qore
+
+/**
+ * \brief Defines and registers a benchmark.
+ * \param N the name of the benchmark
+ * \param I the number of operations to perform
+ */
+#define BENCHMARK(N, I) \
+    static void N(::qore::Size); \
+    static ::qore::bench::Benchmark N##_benchmark(#N, N, I); \
+    static void N(::qore::Size iterations)
+
+#endif // TOOLS_BENCH_BENCH_H_
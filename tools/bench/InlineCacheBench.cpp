@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \brief Compares dynamic binary operators with and without a polymorphic inline cache.
+///
+//------------------------------------------------------------------------------
+#include <sstream>
+#include "Bench.h"
+#include "qore/core/InlineCache.h"
+
+namespace qore {
+namespace bench {
+
+static void reportStats(const InlineCache::Stats &before) {
+    InlineCache::Stats after = InlineCache::getStats();
+    std::ostringstream s;
+    s << "inline cache hits: " << (after.hits - before.hits) << ", misses: " << (after.misses - before.misses);
+    note(s.str());
+}
+
+BENCHMARK(AnyPlusAny_Generic, 10000000) {
+    const BinaryOperator &op = BinaryOperator::find(BinaryOperator::Kind::Plus, Type::Any, Type::Any);
+    qvalue sum = qvalue::tagInt(0);
+    for (Size i = 0; i < iterations; ++i) {
+        sum = op.getFunction()(qvalue::tagInt(i & 0xFF), qvalue::tagInt(1));
+    }
+    doNotOptimize(sum);
+}
+
+BENCHMARK(AnyPlusAny_Cached, 10000000) {
+    InlineCache::Stats before = InlineCache::getStats();
+    BinaryOperatorCache cache;
+    qvalue sum = qvalue::tagInt(0);
+    for (Size i = 0; i < iterations; ++i) {
+        sum = cache.invoke(BinaryOperator::Kind::Plus, qvalue::tagInt(i & 0xFF), qvalue::tagInt(1));
+    }
+    doNotOptimize(sum);
+    reportStats(before);
+}
+
+} // namespace bench
+} // namespace qore
@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \brief Compares the bytecode interpreter with the visitor-based interpreter.
+///
+//------------------------------------------------------------------------------
+#include "Bench.h"
+#include "qore/core/FunctionGroup.h"
+#include "qore/in/Bytecode.h"
+#include "qore/in/FunctionInterpreter.h"
+
+namespace qore {
+namespace bench {
+
+/**
+ * \brief Builds `int sub sumDown(int n) { int sum = 0; while (n) { sum += n; n += -1; } return sum; }`.
+ */
+static Function &createSumDown(FunctionGroup &group) {
+    FunctionType type(Type::Int);
+    type.addParameter(Type::Int);
+    Function &f = group.addFunction(std::move(type), SourceLocation());
+    LocalVariable &n = f.addLocalVariable("n", Type::Int, SourceLocation());
+    LocalVariable &sum = f.addLocalVariable("sum", Type::Int, SourceLocation());
+    const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+    const BinaryOperator &plus = BinaryOperator::find(BinaryOperator::Kind::Plus, Type::Int, Type::Int);
+
+    code::Block *entry = f.addBlock();
+    code::Block *loop = f.addBlock();
+    code::Block *body = f.addBlock();
+    code::Block *exit = f.addBlock();
+
+    code::Temp t0 = f.addTemp();
+    entry->appendConstInt(t0, 0);
+    entry->appendLocalSet(sum, t0);
+    entry->appendJump(*loop);
+
+    code::Temp t1 = f.addTemp();
+    code::Temp t2 = f.addTemp();
+    loop->appendLocalGet(t1, n);
+    loop->appendInvokeConversion(t2, *toBool, t1, nullptr);
+    loop->appendBranch(t2, *body, *exit);
+
+    code::Temp t3 = f.addTemp();
+    code::Temp t4 = f.addTemp();
+    code::Temp t5 = f.addTemp();
+    body->appendLocalGet(t3, sum);
+    body->appendLocalGet(t4, n);
+    body->appendInvokeBinaryOperator(t5, plus, t3, t4, nullptr);
+    body->appendLocalSet(sum, t5);
+    body->appendConstInt(t3, -1);
+    body->appendInvokeBinaryOperator(t5, plus, t4, t3, nullptr);
+    body->appendLocalSet(n, t5);
+    body->appendJump(*loop);
+
+    exit->appendLocalGet(t0, sum);
+    exit->appendRet(t0);
+    return f;
+}
+
+/**
+ * \brief Builds `int sub countDown(int n) { if (n) return countDown(n + -1); return 0; }`.
+ */
+static Function &createCountDown(FunctionGroup &group) {
+    FunctionType type(Type::Int);
+    type.addParameter(Type::Int);
+    Function &f = group.addFunction(std::move(type), SourceLocation());
+    LocalVariable &n = f.addLocalVariable("n", Type::Int, SourceLocation());
+    const Conversion *toBool = Conversion::find(Type::Int, Type::SoftBool);
+    const BinaryOperator &plus = BinaryOperator::find(BinaryOperator::Kind::Plus, Type::Int, Type::Int);
+
+    code::Block *entry = f.addBlock();
+    code::Block *recurse = f.addBlock();
+    code::Block *exit = f.addBlock();
+
+    code::Temp t0 = f.addTemp();
+    code::Temp t1 = f.addTemp();
+    entry->appendLocalGet(t0, n);
+    entry->appendInvokeConversion(t1, *toBool, t0, nullptr);
+    entry->appendBranch(t1, *recurse, *exit);
+
+    code::Temp t2 = f.addTemp();
+    code::Temp t3 = f.addTemp();
+    recurse->appendConstInt(t2, -1);
+    recurse->appendInvokeBinaryOperator(t3, plus, t0, t2, nullptr);
+    recurse->appendInvokeFunction(t2, f, {t3}, nullptr);
+    recurse->appendRet(t2);
+
+    exit->appendConstInt(t0, 0);
+    exit->appendRet(t0);
+    return f;
+}
+
+//each iteration executes one pass of the loop body (11 instructions)
+BENCHMARK(Interpreter_Visitor, 10000000) {
+    FunctionGroup group("::bench");
+    Function &f = createSumDown(group);
+    in::Frame frame(f.getTempCount(), f.getLocalVariables().size());
+    frame.locals[0].i = iterations;
+    in::FunctionInterpreter fi(frame, f.getEntryBlock());
+    fi.run();
+    doNotOptimize(frame.returnValue);
+}
+
+BENCHMARK(Interpreter_Bytecode, 10000000) {
+    FunctionGroup group("::bench");
+    Function &f = createSumDown(group);
+    in::Program program;
+    const in::Bytecode &bc = program.getBytecode(f);
+    qvalue arg;
+    arg.i = iterations;
+    doNotOptimize(bc.call(&arg, 1));
+}
+
+//the loop condition is fused into a single ConvertAndBranch (10 instructions per iteration)
+BENCHMARK(Interpreter_BytecodeFused, 10000000) {
+    FunctionGroup group("::bench");
+    Function &f = createSumDown(group);
+    f.fuseInstructions();
+    f.compactTemps();
+    in::Program program;
+    const in::Bytecode &bc = program.getBytecode(f);
+    qvalue arg;
+    arg.i = iterations;
+    doNotOptimize(bc.call(&arg, 1));
+}
+
+static constexpr qint CallDepth = 1000;
+
+//each iteration executes one call and return
+BENCHMARK(Interpreter_VisitorCall, 1000000) {
+    FunctionGroup group("::bench");
+    Function &f = createCountDown(group);
+    for (Size i = 0; i < iterations / CallDepth; ++i) {
+        in::Frame frame(f.getTempCount(), f.getLocalVariables().size());
+        frame.locals[0].i = CallDepth;
+        in::FunctionInterpreter fi(frame, f.getEntryBlock());
+        fi.run();
+        doNotOptimize(frame.returnValue);
+    }
+}
+
+BENCHMARK(Interpreter_BytecodeCall, 1000000) {
+    FunctionGroup group("::bench");
+    Function &f = createCountDown(group);
+    in::Program program;
+    const in::Bytecode &bc = program.getBytecode(f);
+    for (Size i = 0; i < iterations / CallDepth; ++i) {
+        qvalue arg;
+        arg.i = CallDepth;
+        doNotOptimize(bc.call(&arg, 1));
+    }
+}
+
+} // namespace bench
+} // namespace qore
@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Benchmarks of conversions between numbers and strings.
+///
+//------------------------------------------------------------------------------
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "qore/core/String.h"
+#include "qore/core/util/Numeric.h"
+
+namespace qore {
+namespace bench {
+
+static const std::vector<std::string> &getIntStrings() {
+    static std::vector<std::string> strings{"0", "42", "-17", "  1234", "987654", "-2147483648", "1234567890123",
+        "9223372036854775807", "-9223372036854775808", "31415926535", "0x7fff", "100 apples"};
+    return strings;
+}
+
+BENCHMARK(StringToInt_StringStream, 10000000) {
+    const std::vector<std::string> &strings = getIntStrings();
+    qint sum = 0;
+    for (Size i = 0; i < iterations; ++i) {
+        std::stringstream s(strings[i % strings.size()]);
+        qint v = 0;
+        s >> v;
+        sum += v;
+    }
+    doNotOptimize(sum);
+}
+
+BENCHMARK(StringToInt_ParseInt, 10000000) {
+    const std::vector<std::string> &strings = getIntStrings();
+    qint sum = 0;
+    for (Size i = 0; i < iterations; ++i) {
+        sum += util::parseInt(strings[i % strings.size()]);
+    }
+    doNotOptimize(sum);
+}
+
+BENCHMARK(StringToInt_Cached, 10000000) {
+    std::vector<String::Ptr> strings;
+    for (const std::string &s : getIntStrings()) {
+        strings.emplace_back(new String(s));
+    }
+    qint sum = 0;
+    for (Size i = 0; i < iterations; ++i) {
+        sum += strings[i % strings.size()]->toInt();
+    }
+    doNotOptimize(sum);
+}
+
+static const std::vector<qint> &getInts() {
+    static std::vector<qint> ints{0, 42, -17, 1234, 987654, -2147483648LL, 1234567890123LL, 9223372036854775807LL,
+        -9223372036854775807LL - 1, 31415926535LL, 32767, 100};
+    return ints;
+}
+
+BENCHMARK(IntToString_ToString, 10000000) {
+    const std::vector<qint> &ints = getInts();
+    for (Size i = 0; i < iterations; ++i) {
+        String::Ptr s(new String(std::to_string(ints[i % ints.size()])));
+        doNotOptimize(s.get());
+    }
+}
+
+BENCHMARK(IntToString_StringStream, 10000000) {
+    const std::vector<qint> &ints = getInts();
+    for (Size i = 0; i < iterations; ++i) {
+        std::ostringstream os;
+        os << ints[i % ints.size()];
+        String::Ptr s(new String(os.str()));
+        doNotOptimize(s.get());
+    }
+}
+
+BENCHMARK(IntToString_FromInt, 10000000) {
+    const std::vector<qint> &ints = getInts();
+    for (Size i = 0; i < iterations; ++i) {
+        String::Ptr s(String::fromInt(ints[i % ints.size()]));
+        doNotOptimize(s.get());
+    }
+}
+
+BENCHMARK(IntToString_FromIntGet, 10000000) {
+    const std::vector<qint> &ints = getInts();
+    for (Size i = 0; i < iterations; ++i) {
+        String::Ptr s(String::fromInt(ints[i % ints.size()]));
+        doNotOptimize(s->get().data());
+    }
+}
+
+BENCHMARK(IntToString_FormatInt, 10000000) {
+    const std::vector<qint> &ints = getInts();
+    char buffer[util::MaxIntLength];
+    Size total = 0;
+    for (Size i = 0; i < iterations; ++i) {
+        total += util::formatInt(ints[i % ints.size()], buffer);
+        doNotOptimize(buffer[0]);
+    }
+    doNotOptimize(total);
+}
+
+} // namespace bench
+} // namespace qore
@@ -0,0 +1,201 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Compares the pool allocator with the global operator new.
+///
+/// The 'Malloc' variants use an object of the same size as Int which is allocated by the global operator new.
+///
+//------------------------------------------------------------------------------
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "qore/core/Int.h"
+#include "qore/core/Pool.h"
+
+namespace qore {
+namespace bench {
+
+/**
+ * \brief An object with the same layout as Int allocated by the global operator new.
+ */
+class MallocInt : public RefCounted {
+
+public:
+    explicit MallocInt(qint i) : i(i) {
+    }
+
+    qint get() const {
+        return i;
+    }
+
+private:
+    qint i;
+};
+
+static_assert(sizeof(MallocInt) == sizeof(Int), "MallocInt must have the same size as Int");
+
+template<typename T>
+static void createDestroy(Size iterations) {
+    for (Size i = 0; i < iterations; ++i) {
+        T *obj = new T(i);
+        doNotOptimize(obj);
+        obj->decRefCount();
+    }
+}
+
+/**
+ * \brief Creates a number of objects that are alive at the same time, then releases them.
+ */
+template<typename T>
+static void burst(Size iterations) {
+    const Size burstSize = 1000;
+    std::vector<T *> objs(burstSize);
+    for (Size i = 0; i < iterations; i += burstSize) {
+        for (Size j = 0; j < burstSize; ++j) {
+            objs[j] = new T(j);
+        }
+        doNotOptimize(objs);
+        for (T *obj : objs) {
+            obj->decRefCount();
+        }
+    }
+}
+
+/**
+ * \brief One thread allocates memory, the other one frees it.
+ */
+template<void *(*A)(Size), void (*D)(void *, Size)>
+static void crossThread(Size iterations) {
+    const Size batchSize = 1000;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::vector<void *>> queue;
+    parallel([&](Index index) {
+        if (index == 0) {
+            for (Size i = 0; i < iterations; i += batchSize) {
+                std::vector<void *> batch;
+                for (Size j = 0; j < batchSize; ++j) {
+                    batch.push_back(A(sizeof(Int)));
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                queue.push_back(std::move(batch));
+                cond.notify_one();
+            }
+        } else if (index == 1) {
+            for (Size i = 0; i < iterations; i += batchSize) {
+                std::vector<void *> batch;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [&queue]() { return !queue.empty(); });
+                    batch = std::move(queue.back());
+                    queue.pop_back();
+                }
+                for (void *p : batch) {
+                    D(p, sizeof(Int));
+                }
+            }
+        }
+    });
+}
+
+static void *mallocAllocate(Size size) {
+    return ::operator new(size);
+}
+
+static void mallocDeallocate(void *ptr, Size) {
+    ::operator delete(ptr);
+}
+
+/**
+ * \brief Measures the growth of the resident set size caused by a large number of live objects.
+ */
+template<typename T>
+static void rss(Size iterations) {
+    Size before = residentSetSize();
+    std::vector<T *> objs(iterations);
+    Size vectorSize = residentSetSize() - before;
+    for (Size i = 0; i < iterations; ++i) {
+        objs[i] = new T(i);
+    }
+    Size live = residentSetSize() - before - vectorSize;
+    for (T *obj : objs) {
+        obj->decRefCount();
+    }
+    Size after = residentSetSize();
+    note("rss growth with " + std::to_string(iterations) + " live objects: " + std::to_string(live / 1024)
+            + " KiB (" + std::to_string(live / iterations) + " bytes/object), "
+            + std::to_string((after > before ? after - before : 0) / 1024) + " KiB retained after release");
+}
+
+BENCHMARK(Alloc_Malloc_1Thread, 100000000) {
+    createDestroy<MallocInt>(iterations);
+}
+
+BENCHMARK(Alloc_Pool_1Thread, 100000000) {
+    createDestroy<Int>(iterations);
+}
+
+BENCHMARK(Alloc_Malloc_Burst, 100000000) {
+    burst<MallocInt>(iterations);
+}
+
+BENCHMARK(Alloc_Pool_Burst, 100000000) {
+    burst<Int>(iterations);
+}
+
+BENCHMARK(Alloc_Malloc_NThreads_Private, 100000000) {
+    parallel([iterations](Index) {
+        createDestroy<MallocInt>(iterations / threadCount());
+    });
+}
+
+BENCHMARK(Alloc_Pool_NThreads_Private, 100000000) {
+    parallel([iterations](Index) {
+        createDestroy<Int>(iterations / threadCount());
+    });
+}
+
+BENCHMARK(Alloc_Malloc_CrossThread, 10000000) {
+    crossThread<mallocAllocate, mallocDeallocate>(iterations);
+}
+
+BENCHMARK(Alloc_Pool_CrossThread, 10000000) {
+    crossThread<Pool::allocate, Pool::deallocate>(iterations);
+}
+
+BENCHMARK(Alloc_Malloc_Rss, 1000000) {
+    rss<MallocInt>(iterations);
+}
+
+BENCHMARK(Alloc_Pool_Rss, 1000000) {
+    rss<Int>(iterations);
+}
+
+} // namespace bench
+} // namespace qore
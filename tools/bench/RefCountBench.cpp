@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Compares the biased reference counting with plain sequentially-consistent atomic counter.
+///
+//------------------------------------------------------------------------------
+#include <atomic>
+#include "Bench.h"
+#include "qore/core/RefCounted.h"
+
+namespace qore {
+namespace bench {
+
+/**
+ * \brief The original reference counting scheme using a single sequentially-consistent atomic counter.
+ */
+class SeqCstObject {
+
+public:
+    SeqCstObject() : refCount(1) {
+    }
+
+    void incRefCount() noexcept {
+        ++refCount;
+    }
+
+    void decRefCount() noexcept {
+        if (!--refCount) {
+            delete this;
+        }
+    }
+
+private:
+    std::atomic<Size> refCount;
+};
+
+/**
+ * \brief An object using the biased reference counting.
+ */
+class BiasedObject : public RefCounted {
+};
+
+template<typename T>
+static void incDec(T *obj, Size iterations) {
+    for (Size i = 0; i < iterations; ++i) {
+        obj->incRefCount();
+        doNotOptimize(obj);
+        obj->decRefCount();
+        doNotOptimize(obj);
+    }
+}
+
+template<typename T>
+static void privateObjects(Size iterations) {
+    parallel([iterations](Index) {
+        T *obj = new T();
+        incDec(obj, iterations / threadCount());
+        obj->decRefCount();
+    });
+}
+
+template<typename T>
+static void sharedObject(Size iterations) {
+    T *obj = new T();
+    parallel([obj, iterations](Index) {
+        incDec(obj, iterations / threadCount());
+    });
+    obj->decRefCount();
+}
+
+BENCHMARK(RefCount_SeqCst_1Thread, 100000000) {
+    SeqCstObject *obj = new SeqCstObject();
+    incDec(obj, iterations);
+    obj->decRefCount();
+}
+
+BENCHMARK(RefCount_Biased_1Thread, 100000000) {
+    BiasedObject *obj = new BiasedObject();
+    incDec(obj, iterations);
+    obj->decRefCount();
+}
+
+BENCHMARK(RefCount_SeqCst_NThreads_Private, 100000000) {
+    privateObjects<SeqCstObject>(iterations);
+}
+
+BENCHMARK(RefCount_Biased_NThreads_Private, 100000000) {
+    privateObjects<BiasedObject>(iterations);
+}
+
+BENCHMARK(RefCount_SeqCst_NThreads_Shared, 10000000) {
+    sharedObject<SeqCstObject>(iterations);
+}
+
+BENCHMARK(RefCount_Biased_NThreads_Shared, 10000000) {
+    sharedObject<BiasedObject>(iterations);
+}
+
+} // namespace bench
+} // namespace qore
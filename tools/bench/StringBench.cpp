@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------*- C++ -*-
+//
+//  Qore Programming Language
+//
+//  Copyright (C) 2015 Qore Technologies
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+///
+/// \file
+/// \brief Benchmarks of string concatenation.
+///
+/// Each benchmark mimics the reference counting done by the generated code. The 'Copy' variants use the original
+/// strategy which always creates a new string holding the concatenation.
+///
+//------------------------------------------------------------------------------
+#include "Bench.h"
+#include "qore/core/String.h"
+
+namespace qore {
+namespace bench {
+
+static String *copyConcat(String *left, String *right) {
+    return new String(left->get() + right->get());
+}
+
+static String *concat(String *left, String *right) {
+    return left->append(right);
+}
+
+/**
+ * \brief Simulates `s += x` in a loop, the old value of `s` is moved to a temporary.
+ */
+template<String *(*F)(String *, String *)>
+static void appendLoop(Size iterations) {
+    String::Ptr fragment(new String("fragment-0123456"));
+    String *s = new String("");
+    for (Size i = 0; i < iterations; ++i) {
+        String *old = s;
+        s = F(old, fragment.get());
+        old->decRefCount();
+    }
+    doNotOptimize(s->get().size());
+    s->decRefCount();
+}
+
+/**
+ * \brief Simulates `a + b + c + ...` where all operands are local variables.
+ */
+template<String *(*F)(String *, String *)>
+static void chain(Size iterations) {
+    String::Ptr fragment(new String("fragment-0123456"));
+    fragment->incRefCount();
+    String *s = F(fragment.get(), fragment.get());
+    fragment->decRefCount();
+    for (Size i = 2; i < iterations; ++i) {
+        fragment->incRefCount();
+        String *n = F(s, fragment.get());
+        fragment->decRefCount();
+        s->decRefCount();
+        s = n;
+    }
+    doNotOptimize(s->get().size());
+    s->decRefCount();
+}
+
+/**
+ * \brief Simulates `s = s + x` in a loop, the left operand is shared with the variable.
+ */
+template<String *(*F)(String *, String *)>
+static void sharedLeft(Size iterations) {
+    String::Ptr fragment(new String("fragment-0123456"));
+    String *s = new String("");
+    for (Size i = 0; i < iterations; ++i) {
+        s->incRefCount();
+        String *n = F(s, fragment.get());
+        s->decRefCount();
+        s->decRefCount();
+        s = n;
+    }
+    doNotOptimize(s->get().size());
+    s->decRefCount();
+}
+
+//the variants without the suffix concatenate 10^4 fragments, the '_100k' variants 10^5 fragments; linear strategies
+//take the same time per operation in both, the 'Copy' variants are quadratic and are therefore only run with 10^4
+
+BENCHMARK(String_AppendLoop_Copy, 10000) {
+    appendLoop<copyConcat>(iterations);
+}
+
+BENCHMARK(String_AppendLoop, 10000) {
+    appendLoop<concat>(iterations);
+}
+
+BENCHMARK(String_AppendLoop_100k, 100000) {
+    appendLoop<concat>(iterations);
+}
+
+BENCHMARK(String_Chain_Copy, 10000) {
+    chain<copyConcat>(iterations);
+}
+
+BENCHMARK(String_Chain, 10000) {
+    chain<concat>(iterations);
+}
+
+BENCHMARK(String_Chain_100k, 100000) {
+    chain<concat>(iterations);
+}
+
+BENCHMARK(String_SharedLeft_Copy, 10000) {
+    sharedLeft<copyConcat>(iterations);
+}
+
+BENCHMARK(String_SharedLeft, 10000) {
+    sharedLeft<concat>(iterations);
+}
+
+BENCHMARK(String_SharedLeft_100k, 100000) {
+    sharedLeft<concat>(iterations);
+}
+
+} // namespace bench
+} // namespace qore
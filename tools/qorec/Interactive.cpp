@@ -123,7 +123,8 @@ private:
 class IBuilder : public comp::sem::Builder {
 
 public:
-    explicit IBuilder(in::Frame &topLevelFrame) : topLevelFrame(topLevelFrame) {
+    IBuilder(in::Frame &topLevelFrame, RefCountMode refCountMode) : comp::sem::Builder(refCountMode),
+            topLevelFrame(topLevelFrame) {
         entry = createBlock();
         setCurrentBlock(entry);
     }
@@ -170,7 +171,7 @@ void interactive() {
     StdinWrapper dp(ctx);
     comp::Parser parser(ctx, dp);
     in::Frame topLevelFrame(0, 0);
-    IBuilder mainBuilder(topLevelFrame);
+    IBuilder mainBuilder(topLevelFrame, env.getRefCountMode());
     comp::sem::Analyzer analyzer(ctx);
     InteractiveScope topScope(ctx, analyzer.getRootNamespaceScope(), topLevelFrame);
     comp::sem::BlockScope blockScope(topScope);
@@ -23,6 +23,10 @@
 //  DEALINGS IN THE SOFTWARE.
 //
 //------------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include "qore/core/util/Debug.h"
@@ -31,8 +35,12 @@
 #include "qore/comp/Parser.h"
 #include "qore/comp/ast/Dump.h"
 #include "qore/comp/sem/Analyzer.h"
-#include "qore/in/Interpreter.h"
+#include "qore/in/Bytecode.h"
+#include "qore/in/Tiering.h"
+#include "qore/cg/CodeCache.h"
 #include "qore/cg/CodeGen.h"
+#include "qore/cg/Jit.h"
+#include "qore/cg/TierCompiler.h"
 #include "DiagPrinter.h"
 #include "Interactive.h"
 
@@ -52,7 +60,71 @@ public:
 };
 #endif
 
-void test(bool file, std::string str) {
+void report(const char *what, qore::cg::OptLevel level, const qore::cg::CompileTimes &times) {
+    std::cerr << what << " at O" << static_cast<int>(level) << ": generation " << times.generation.count()
+            << " us, optimization " << times.optimization.count() << " us, emission " << times.emission.count()
+            << " us\n";
+}
+
+void interpret(qore::Function &qinit, qore::cg::OptLevel level) {
+    qore::cg::TierCompiler compiler(&qore::in::Tiering::invoke, level);
+    qore::in::Tiering tiering([&compiler](const qore::Function &f, qore::in::Program &program) {
+        return compiler.compile(f, [&program](const qore::Function &callee) -> const void * {
+            return &program.getBytecode(callee);
+        });
+    });
+    qore::in::Program program(&tiering);
+    program.run(qinit);
+    LOG("Promoted " << tiering.getStats().promotions << " functions to native code");
+    report("Tier compilation", level, compiler.getCompileTimes());
+}
+
+/**
+ * \brief Command line options.
+ */
+struct Options {
+    bool jit = false;
+    qore::cg::OptLevel level = qore::cg::OptLevel::O2;
+    unsigned threads = 1;           //!< The number of threads generating code.
+    bool debugInfo = false;         //!< Generate DWARF line tables and write a perf map for JIT code.
+    std::string output;             //!< Compile ahead of time into this file if not empty.
+    bool objectOnly = false;        //!< Do not link the object file into an executable.
+    qore::cg::OutputFormat format = qore::cg::OutputFormat::Object;
+    std::string cacheDir;           //!< Run scripts through a cache of executables in this directory if not empty.
+    std::uint64_t cacheSize = 256 << 20;
+    qore::cg::CodeCache *cache = nullptr;   //!< Stores the executable in this cache under `cacheKey`.
+    std::string cacheKey;
+};
+
+bool compile(qore::Env &env, qore::Function &qinit, const Options &options) {
+    std::string object = options.format == qore::cg::OutputFormat::Object && !options.objectOnly
+            ? options.output + ".o" : options.output;
+    std::string error;
+    qore::cg::CompileTimes times;
+    if (!qore::cg::CodeGen::emit(env, qinit, object, options.format, options.level, options.threads,
+            options.debugInfo, times, error)) {
+        std::cerr << "Compilation failed: " << error << "\n";
+        return false;
+    }
+    report("AOT compilation", options.level, times);
+    if (object != options.output) {
+        bool linked = qore::cg::CodeGen::link(object, options.output, error);
+        std::remove(object.c_str());
+        if (!linked) {
+            std::cerr << error << "\n";
+            return false;
+        }
+    }
+    if (options.cache && options.cache->store(options.cacheKey, options.output, env).empty()) {
+        std::cerr << "Unable to store the executable in the cache\n";
+        return false;
+    }
+    return true;
+}
+
+bool test(bool file, std::string str, const Options &options) {
+    bool jit = options.jit;
+    qore::cg::OptLevel level = options.level;
     qore::comp::StringTable stringTable;
     qore::comp::DiagManager diagMgr(stringTable);
     qore::comp::SourceManager srcMgr(diagMgr);
@@ -71,11 +143,45 @@ void test(bool file, std::string str) {
     qore::Function *qinit = qore::comp::sem::Analyzer::analyze(ctx, *script);
     qore::dump(std::cout, env);
     LOG("-------------------------------------------------------------------------------");
-    if (qinit) {
-        qore::in::interpret(*qinit);
+    if (!options.output.empty()) {
+        return qinit && compile(env, *qinit, options);
     }
-    LOG("-------------------------------------------------------------------------------");
-    qore::cg::CodeGen::process(env);
+    if (!qinit) {
+        return true;
+    }
+    if (jit) {
+        qore::cg::Jit engine(level, options.threads, options.debugInfo);
+        if (engine.compile(env)) {
+            report("JIT compilation", level, engine.getCompileTimes());
+            engine.getNativeCode(*qinit)(nullptr);
+            return true;
+        }
+        std::cerr << "JIT compilation failed, falling back to the interpreter\n";
+    }
+    interpret(*qinit, level);
+    return true;
+}
+
+int runCached(const std::string &file, Options options) {
+    qore::cg::CodeCache cache(options.cacheDir, options.cacheSize);
+    std::string key = cache.getKey(file, "O" + std::to_string(static_cast<int>(options.level))
+            + (options.debugInfo ? " g" : ""));
+    if (key.empty()) {
+        std::cerr << "Unable to read " << file << "\n";
+        return 1;
+    }
+    std::string executable = cache.lookup(key);
+    if (executable.empty()) {
+        options.output = cache.createTempFile(key);
+        options.cache = &cache;
+        options.cacheKey = key;
+        if (options.output.empty() || !test(true, file, options)) {
+            std::remove(options.output.c_str());
+            return 1;
+        }
+        executable = cache.lookup(key);
+    }
+    return std::system(("\"" + executable + "\"").c_str()) == 0 ? 0 : 1;
 }
 
 /// \endcond NoDoxygen
@@ -87,6 +193,52 @@ int main(int argc, char *argv[]) {
 #endif
     LOG_FUNCTION();
 
+    Options options;
+    std::string file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--jit") {
+            options.jit = true;
+        } else if (arg.size() == 3 && arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '3') {
+            options.level = static_cast<qore::cg::OptLevel>(arg[2] - '0');
+        } else if (arg.size() > 2 && arg[0] == '-' && arg[1] == 'j') {
+            options.threads = std::max(1, std::atoi(arg.c_str() + 2));
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg.compare(0, 8, "--cache=") == 0) {
+            options.cacheDir = arg.substr(8);
+        } else if (arg.compare(0, 13, "--cache-size=") == 0) {
+            options.cacheSize = std::strtoull(arg.c_str() + 13, nullptr, 10) << 20;
+        } else if (arg == "-g") {
+            options.debugInfo = true;
+        } else if (arg == "-c") {
+            options.objectOnly = true;
+        } else if (arg == "-l") {
+            options.format = qore::cg::OutputFormat::IR;
+        } else if (arg == "--emit-llvm") {
+            options.format = qore::cg::OutputFormat::Bitcode;
+        } else if (arg[0] != '-') {
+            file = arg;
+        } else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    //-l, --emit-llvm and -c imply ahead-of-time compilation even without -o
+    if (options.output.empty() && (options.objectOnly || options.format != qore::cg::OutputFormat::Object)) {
+        switch (options.format) {
+            case qore::cg::OutputFormat::IR:
+                options.output = "out.ll";
+                break;
+            case qore::cg::OutputFormat::Bitcode:
+                options.output = "out.bc";
+                break;
+            case qore::cg::OutputFormat::Object:
+                options.output = "out.o";
+                break;
+        }
+    }
+
     std::string src = R"(
 any sub f(int i) {
     if (i += string x) {string s1 = "aaa"; return 21;}
@@ -105,8 +257,12 @@ f2("A", f(4), "C" + "D");
 //    qore::interactive();
 //    std::cin.rdbuf(cin_backup);
 
-//    test(true, argv[1]);
-    test(false, src);
-
+    if (!file.empty() && !options.cacheDir.empty() && options.output.empty()) {
+        return runCached(file, options);
+    }
+    if (!file.empty()) {
+        return test(true, file, options) ? 0 : 1;
+    }
+    test(false, src, options);
     return 0;
 }